@@ -0,0 +1,557 @@
+// Core logic shared by the plugin (Main.cpp), the Python module
+// (python/hudcore_module.cpp) and the offline tools. Nothing in here may
+// depend on the X-Plane SDK or OpenGL, so every consumer gets the same
+// numbers the plugin draws from.
+#pragma once
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// ──────────────────────────────────
+// Geodesy
+// ──────────────────────────────────
+
+// Great-circle distance in meters
+inline double haversine_m(double lat1, double lon1, double lat2, double lon2) {
+        const double R = 6371000.0; // Earth radius in meters
+        double dLat = (lat2 - lat1) * M_PI / 180.0;
+        double dLon = (lon2 - lon1) * M_PI / 180.0;
+        double a = sin(dLat/2) * sin(dLat/2) +
+                cos(lat1 * M_PI / 180.0) * cos(lat2 * M_PI / 180.0) *
+                sin(dLon/2) * sin(dLon/2);
+        double c = 2 * atan2(sqrt(a), sqrt(1-a));
+        return R * c;
+}
+
+// Same as above with cos(lat) of both ends precomputed
+inline double haversine_m(double lat1, double lon1, double cos_lat1, double lat2, double lon2, double cos_lat2) {
+        const double R = 6371000.0; // Earth radius in meters
+        double dLat = (lat2 - lat1) * M_PI / 180.0;
+        double dLon = (lon2 - lon1) * M_PI / 180.0;
+        double a = sin(dLat/2) * sin(dLat/2) +
+                cos_lat1 * cos_lat2 *
+                sin(dLon/2) * sin(dLon/2);
+        double c = 2 * atan2(sqrt(a), sqrt(1-a));
+        return R * c;
+}
+
+// ──────────────────────────────────
+// Routes
+// ──────────────────────────────────
+
+struct Waypoint {
+    double lat, lon, alt_m;
+    int direction; // 1 = up arrow, 0 = dot, -1 = down arrow
+    float heading_to_next; // degrees, filled in after parsing
+
+    bool SameAs(const Waypoint& o) const {
+        return lat == o.lat && lon == o.lon && alt_m == o.alt_m && direction == o.direction;
+    }
+};
+
+// One "lat lon alt_m direction" line per waypoint; '#' starts a comment,
+// as in assets/seattle_to_kelowna.wpt. Reading stops at the first line
+// that does not parse. Safe to call off the sim thread, so messages are
+// returned rather than logged.
+inline bool LoadCustomWaypoints(const char* filename, std::vector<Waypoint>& waypoints, const char** message) {
+    std::ifstream infile(filename);
+    if (!infile) {
+        *message = "File not found or could not be opened.\n";
+        return false;
+    }
+    std::string line;
+    while (std::getline(infile, line)) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        std::istringstream fields(line);
+        double lat, lon, alt;
+        int dir;
+        if (!(fields >> lat >> lon >> alt >> dir)) break;
+        waypoints.push_back({lat, lon, alt, dir, 0.0f});
+    }
+    if (waypoints.empty()) {
+        *message = "File loaded but no waypoints found.\n";
+        return false;
+    }
+    *message = "Waypoints loaded successfully.\n";
+    return true;
+}
+
+struct WaypointDiff {
+    int changed, added, removed;
+    bool Any() const { return changed || added || removed; }
+};
+
+// Fills in the leg headings of a freshly parsed route, reusing the ones of
+// 'previous' for legs whose two ends did not change
+inline WaypointDiff DiffWaypoints(std::vector<Waypoint>& fresh, const std::vector<Waypoint>* previous)
+{
+    WaypointDiff diff = { 0, 0, 0 };
+    int n = (int)fresh.size();
+    int old_n = previous ? (int)previous->size() : 0;
+    auto same = [&](int i) { return i < old_n && fresh[i].SameAs((*previous)[i]); };
+
+    for (int i = 0; i < n; ++i) {
+        if (i >= old_n) ++diff.added;
+        else if (!same(i)) ++diff.changed;
+
+        bool last = i == n - 1;
+        if (same(i) && (last ? i == old_n - 1 : same(i + 1))) {
+            fresh[i].heading_to_next = (*previous)[i].heading_to_next;
+        } else if (!last) {
+            double dlat = fresh[i+1].lat - fresh[i].lat;
+            double dlon = fresh[i+1].lon - fresh[i].lon;
+            float heading = (float)(atan2(dlon, dlat) * 180.0 / M_PI);
+            fresh[i].heading_to_next = heading < 0 ? heading + 360.0f : heading;
+        } else {
+            fresh[i].heading_to_next = 0.0f;
+        }
+    }
+    if (old_n > n) diff.removed = old_n - n;
+    return diff;
+}
+
+// Waypoint sequencing: the closest unpassed waypoint becomes active, and it
+// counts as passed once the distance to it starts growing again.
+// 'dist_to(i)' returns the distance in meters from the aircraft to waypoint i.
+struct RouteProgress {
+    int active = -1;
+    double prev_dist = 1e9;
+    std::vector<unsigned char> passed; // one flag per waypoint
+
+    void Reset(int count) {
+        active = -1;
+        prev_dist = 1e9;
+        passed.assign(count, 0);
+    }
+
+    int PassedCount() const {
+        int n = 0;
+        for (unsigned char p : passed) n += p ? 1 : 0;
+        return n;
+    }
+
+    // Returns the waypoint passed by this update, or -1
+    template <typename DistFn>
+    int Update(DistFn dist_to) {
+        int count = (int)passed.size();
+
+        // If no active waypoint or the current one is passed, pick the closest unpassed waypoint
+        if (active == -1 || passed[active]) {
+            double min_dist = 1e9;
+            int min_idx = -1;
+            for (int i = 0; i < count; ++i) {
+                if (passed[i]) continue;
+                double d = dist_to(i);
+                if (d < min_dist) {
+                    min_dist = d;
+                    min_idx = i;
+                }
+            }
+            active = min_idx;
+            prev_dist = 1e9;
+        }
+        if (active == -1) return -1; // all passed
+
+        // Check distance to active waypoint
+        double dist = dist_to(active);
+
+        // If distance starts increasing (after decreasing), mark as passed and pick next closest
+        if (dist < prev_dist) {
+            prev_dist = dist;
+        } else if (dist > prev_dist + 5.0) { // 5m hysteresis
+            int just_passed = active;
+            passed[active] = 1;
+            active = -1; // Force picking a new one next update
+            prev_dist = 1e9;
+            return just_passed;
+        }
+        return -1;
+    }
+};
+
+// Render-ready form of a route file. Legs are densified along the great
+// circle so long legs follow the earth instead of cutting a chord through
+// it, and a coarse lat/lon grid lists the polyline segments crossing each
+// cell so drawing and distance queries only visit the nearby part of the
+// route. Segment i joins points[i] and points[i + 1].
+struct RouteVertex {
+    double lat, lon, cos_lat;
+    float  alt_m;
+    int    leg; // waypoint the point's leg starts at
+};
+
+struct CompiledRoute {
+    std::vector<Waypoint>    waypoints;      // headings filled in
+    std::vector<RouteVertex> points;         // densified polyline through every waypoint
+    std::vector<int>         waypoint_point; // index in points of each waypoint
+    double cell_deg = 0.1;
+    int lat_cell0 = 0, lon_cell0 = 0;       // south west cell
+    int cells_lat = 0, cells_lon = 0;
+    std::vector<int> cell_start;            // offsets into cell_segments, one past the end per cell
+    std::vector<int> cell_segments;
+
+    // Heap footprint, for cache budgets
+    size_t Bytes() const {
+        return sizeof(*this) +
+               waypoints.capacity() * sizeof(Waypoint) +
+               points.capacity() * sizeof(RouteVertex) +
+               (waypoint_point.capacity() + cell_start.capacity() + cell_segments.capacity()) * sizeof(int);
+    }
+
+    // Appends the segments with a cell within radius_m of lat/lon, each once, in route order
+    template <typename Alloc>
+    void SegmentsNear(double lat, double lon, double radius_m, std::vector<int, Alloc>& out) const {
+        if (cells_lat == 0) return;
+        double dlat = radius_m / 111320.0;
+        double dlon = radius_m / (111320.0 * std::max(cos(lat * M_PI / 180.0), 0.01));
+        int i0 = std::max((int)floor((lat - dlat) / cell_deg) - lat_cell0, 0);
+        int i1 = std::min((int)floor((lat + dlat) / cell_deg) - lat_cell0, cells_lat - 1);
+        int j0 = std::max((int)floor((lon - dlon) / cell_deg) - lon_cell0, 0);
+        int j1 = std::min((int)floor((lon + dlon) / cell_deg) - lon_cell0, cells_lon - 1);
+        size_t first = out.size();
+        for (int i = i0; i <= i1; ++i) {
+            for (int j = j0; j <= j1; ++j) {
+                int cell = i * cells_lon + j;
+                int begin = cell == 0 ? 0 : cell_start[cell - 1];
+                out.insert(out.end(), cell_segments.begin() + begin, cell_segments.begin() + cell_start[cell]);
+            }
+        }
+        std::sort(out.begin() + first, out.end());
+        out.erase(std::unique(out.begin() + first, out.end()), out.end());
+    }
+};
+
+// Parses a route file (LoadCustomWaypoints format) and compiles it. Leg
+// points are at most spacing_m apart, the grid cells cell_deg on a side.
+inline bool CompileRoute(const char* filename, double spacing_m, double cell_deg, CompiledRoute& route, const char** message)
+{
+    route = CompiledRoute();
+    if (!LoadCustomWaypoints(filename, route.waypoints, message)) return false;
+    DiffWaypoints(route.waypoints, nullptr);
+
+    // Densify: spherical interpolation between leg ends, altitude linear along the leg
+    const std::vector<Waypoint>& wp = route.waypoints;
+    int n = (int)wp.size();
+    auto unit = [](double lat, double lon, double v[3]) {
+        double la = lat * M_PI / 180.0, lo = lon * M_PI / 180.0;
+        v[0] = cos(la) * cos(lo);
+        v[1] = cos(la) * sin(lo);
+        v[2] = sin(la);
+    };
+    auto push = [&](double lat, double lon, double alt_m, int leg) {
+        route.points.push_back({ lat, lon, cos(lat * M_PI / 180.0), (float)alt_m, leg });
+    };
+    for (int i = 0; i < n; ++i) {
+        route.waypoint_point.push_back((int)route.points.size());
+        push(wp[i].lat, wp[i].lon, wp[i].alt_m, i);
+        if (i == n - 1) break;
+
+        double leg_m = haversine_m(wp[i].lat, wp[i].lon, wp[i + 1].lat, wp[i + 1].lon);
+        int steps = (int)ceil(leg_m / spacing_m);
+        if (steps < 2) continue;
+        double a[3], b[3];
+        unit(wp[i].lat, wp[i].lon, a);
+        unit(wp[i + 1].lat, wp[i + 1].lon, b);
+        double omega = leg_m / 6371000.0;
+        double sin_omega = sin(omega);
+        for (int k = 1; k < steps; ++k) {
+            double t = (double)k / steps;
+            double fa = sin((1.0 - t) * omega) / sin_omega;
+            double fb = sin(t * omega) / sin_omega;
+            double x = fa * a[0] + fb * b[0], y = fa * a[1] + fb * b[1], z = fa * a[2] + fb * b[2];
+            double lat = atan2(z, sqrt(x * x + y * y)) * 180.0 / M_PI;
+            double lon = atan2(y, x) * 180.0 / M_PI;
+            push(lat, lon, wp[i].alt_m + (wp[i + 1].alt_m - wp[i].alt_m) * t, i);
+        }
+    }
+
+    // Grid over the route's bounding box, each segment listed in every cell its box touches
+    route.cell_deg = cell_deg;
+    double min_lat = 90.0, max_lat = -90.0, min_lon = 180.0, max_lon = -180.0;
+    for (const RouteVertex& p : route.points) {
+        min_lat = std::min(min_lat, p.lat);
+        max_lat = std::max(max_lat, p.lat);
+        min_lon = std::min(min_lon, p.lon);
+        max_lon = std::max(max_lon, p.lon);
+    }
+    route.lat_cell0 = (int)floor(min_lat / cell_deg);
+    route.lon_cell0 = (int)floor(min_lon / cell_deg);
+    route.cells_lat = (int)floor(max_lat / cell_deg) - route.lat_cell0 + 1;
+    route.cells_lon = (int)floor(max_lon / cell_deg) - route.lon_cell0 + 1;
+
+    int cells = route.cells_lat * route.cells_lon;
+    int segments = (int)route.points.size() - 1;
+    std::vector<std::vector<int>> buckets(cells);
+    for (int s = 0; s < segments; ++s) {
+        const RouteVertex& p = route.points[s];
+        const RouteVertex& q = route.points[s + 1];
+        int i0 = (int)floor(std::min(p.lat, q.lat) / cell_deg) - route.lat_cell0;
+        int i1 = (int)floor(std::max(p.lat, q.lat) / cell_deg) - route.lat_cell0;
+        int j0 = (int)floor(std::min(p.lon, q.lon) / cell_deg) - route.lon_cell0;
+        int j1 = (int)floor(std::max(p.lon, q.lon) / cell_deg) - route.lon_cell0;
+        for (int i = i0; i <= i1; ++i) {
+            for (int j = j0; j <= j1; ++j) buckets[i * route.cells_lon + j].push_back(s);
+        }
+    }
+    route.cell_start.resize(cells);
+    for (int c = 0; c < cells; ++c) {
+        route.cell_segments.insert(route.cell_segments.end(), buckets[c].begin(), buckets[c].end());
+        route.cell_start[c] = (int)route.cell_segments.size();
+    }
+    route.points.shrink_to_fit();
+    route.cell_segments.shrink_to_fit();
+    *message = "Route compiled.\n";
+    return true;
+}
+
+// ──────────────────────────────────
+// Landing assist
+// ──────────────────────────────────
+
+struct RunwayEnds {
+    double lat1, lon1; // north end
+    double lat2, lon2; // south end
+};
+static const RunwayEnds g_landing_runway = { 47.4602, -122.3078, 47.4294, -122.3080 };
+
+struct RunwayGuidance {
+    double runway_dist_m;    // to the nearer runway end
+    double vertical_dev_m;   // above the glide path, + = too high
+    double lateral_offset_m; // from the centerline, + = east
+};
+
+// The glide path runs from radout_init (radar altitude when the landing
+// assist was switched on) down to the runway. Positions are single
+// precision because that is what the sim datarefs deliver.
+inline RunwayGuidance ComputeRunwayGuidance(const RunwayEnds& rwy, float ac_lat, float ac_lon, float radalt_m, double radout_init)
+{
+    RunwayGuidance g;
+    double dist1 = haversine_m(ac_lat, ac_lon, rwy.lat1, rwy.lon1);
+    double dist2 = haversine_m(ac_lat, ac_lon, rwy.lat2, rwy.lon2);
+    // find the shortest distance to runway
+    g.runway_dist_m = (dist1 < dist2) ? dist1 : dist2 - 400;
+
+    double target_alt = radout_init * (g.runway_dist_m / (g.runway_dist_m + 1.0)); // Avoid div by zero
+    g.vertical_dev_m = radalt_m - target_alt;
+
+    // Interpolate centerline longitude at aircraft's latitude
+    double frac = (ac_lat - rwy.lat2) / (rwy.lat1 - rwy.lat2);
+    double centerline_lon = rwy.lon2 + frac * (rwy.lon1 - rwy.lon2);
+    double meters_per_deg_lon = 111320.0 * cos(ac_lat * M_PI / 180.0);
+    g.lateral_offset_m = (ac_lon - centerline_lon) * meters_per_deg_lon;
+    return g;
+}
+
+// ──────────────────────────────────
+// Traffic conflicts
+// ──────────────────────────────────
+
+// Traffic table in structure-of-arrays form. The closest point of approach
+// of every target is computed as flat, branch-free loops over the arrays,
+// which the compiler vectorizes.
+static const int g_max_traffic = 512;
+
+static float g_cpa_lookahead_s    = 60.0f;  // ignore closest approaches further out than this
+static float g_cpa_warning_s      = 25.0f;  // conflicts sooner than this are warnings
+static float g_cpa_horizontal_m   = 900.0f; // ~0.5 nm protected radius
+static float g_cpa_vertical_m     = 180.0f; // ~600 ft protected height
+static float g_cpa_proximate_m    = 2000.0f; // targets closer than this are drawn amber
+
+enum TrafficThreat : unsigned char { THREAT_NONE, THREAT_PROXIMATE, THREAT_CAUTION, THREAT_WARNING };
+
+struct TrafficTable {
+    int count;
+    float time_s; // sim time the positions are valid for
+    float own_x, own_y, own_z, own_vx, own_vy, own_vz;
+
+    // Inputs, local OpenGL coordinates (meters, meters per second, m/s^2)
+    alignas(32) float x[g_max_traffic];
+    alignas(32) float y[g_max_traffic];
+    alignas(32) float z[g_max_traffic];
+    alignas(32) float vx[g_max_traffic];
+    alignas(32) float vy[g_max_traffic];
+    alignas(32) float vz[g_max_traffic];
+    alignas(32) float ax[g_max_traffic];
+    alignas(32) float ay[g_max_traffic];
+    alignas(32) float az[g_max_traffic];
+    int trail[g_max_traffic]; // plugin trail slot, 0 = none
+    unsigned trail_gen[g_max_traffic]; // generation of the trail slot, changes when the slot is reused
+    char label[g_max_traffic][9]; // tail number or callsign
+
+    // Outputs of the conflict pass
+    alignas(32) float range_m[g_max_traffic];
+    alignas(32) float t_cpa_s[g_max_traffic];
+    alignas(32) float h_miss_m[g_max_traffic];  // horizontal separation at CPA
+    alignas(32) float v_miss_m[g_max_traffic];  // vertical separation at CPA
+    TrafficThreat threat[g_max_traffic];
+    TrafficThreat worst;
+    int worst_index;
+};
+
+inline void ComputeTrafficConflicts(TrafficTable& t)
+{
+    // Locals, so the stores below cannot alias the tunables and block vectorizing
+    const int n = t.count;
+    const float lookahead = g_cpa_lookahead_s, warning_s = g_cpa_warning_s;
+    const float h_protect = g_cpa_horizontal_m, v_protect = g_cpa_vertical_m, proximate = g_cpa_proximate_m;
+    const float ox = t.own_x, oy = t.own_y, oz = t.own_z, ovx = t.own_vx, ovy = t.own_vy, ovz = t.own_vz;
+
+    // Pass 1: time and separation at the closest point of approach
+    for (int i = 0; i < n; ++i) {
+        float rx = t.x[i] - ox, ry = t.y[i] - oy, rz = t.z[i] - oz;
+        float wx = t.vx[i] - ovx, wy = t.vy[i] - ovy, wz = t.vz[i] - ovz;
+        float ww = wx * wx + wy * wy + wz * wz;
+        // Plain selects rather than fminf/fmaxf, whose NaN rules keep the loop scalar
+        float tc = -(rx * wx + ry * wy + rz * wz) / (ww > 1e-3f ? ww : 1e-3f);
+        tc = tc < 0.0f ? 0.0f : (tc > lookahead ? lookahead : tc); // diverging targets are closest now
+        float cx = rx + wx * tc, cy = ry + wy * tc, cz = rz + wz * tc;
+        t.range_m[i]  = sqrtf(rx * rx + ry * ry + rz * rz);
+        t.t_cpa_s[i]  = tc;
+        t.h_miss_m[i] = sqrtf(cx * cx + cz * cz);
+        t.v_miss_m[i] = fabsf(cy);
+    }
+
+    // Pass 2: classify, a conflict needs both separations inside the protected volume.
+    // Arithmetic on the comparison results keeps this loop branch-free as well.
+    for (int i = 0; i < n; ++i) {
+        int conflict = (t.h_miss_m[i] < h_protect) & (t.v_miss_m[i] < v_protect) & (t.t_cpa_s[i] < lookahead);
+        int soon = t.t_cpa_s[i] < warning_s;
+        int close = t.range_m[i] < proximate;
+        t.threat[i] = (TrafficThreat)(conflict * (THREAT_CAUTION + soon) + (1 - conflict) * close * THREAT_PROXIMATE);
+    }
+
+    t.worst = THREAT_NONE;
+    t.worst_index = -1;
+    for (int i = 0; i < n; ++i) {
+        if (t.threat[i] > t.worst ||
+            (t.threat[i] == t.worst && t.worst_index >= 0 && t.t_cpa_s[i] < t.t_cpa_s[t.worst_index])) {
+            t.worst = t.threat[i];
+            t.worst_index = i;
+        }
+    }
+}
+
+// ──────────────────────────────────
+// Zones
+// ──────────────────────────────────
+
+// A zone outline plus a triangulation of its cap, built off the sim thread
+struct ZoneGeometry {
+    std::vector<std::tuple<double, double, double>> points; // lat, lon, alt_m
+    std::vector<int> cap_triangles;                          // indices into points
+};
+
+// Ear clipping in a local flat projection, handles concave outlines
+inline std::vector<int> TriangulateZone(const std::vector<std::tuple<double, double, double>>& points)
+{
+    std::vector<int> tris;
+    int n = (int)points.size();
+    if (n < 3) return tris;
+
+    double lon_scale = cos(std::get<0>(points[0]) * M_PI / 180.0);
+    std::vector<double> px(n), py(n);
+    double area = 0.0;
+    for (int i = 0; i < n; ++i) {
+        px[i] = std::get<1>(points[i]) * lon_scale;
+        py[i] = std::get<0>(points[i]);
+    }
+    for (int i = 0; i < n; ++i) {
+        int j = (i + 1) % n;
+        area += px[i] * py[j] - px[j] * py[i];
+    }
+
+    // Work on a counter-clockwise index ring
+    std::vector<int> ring(n);
+    for (int i = 0; i < n; ++i) ring[i] = area > 0 ? i : n - 1 - i;
+
+    auto cross = [&](int a, int b, int c) {
+        return (px[b] - px[a]) * (py[c] - py[a]) - (py[b] - py[a]) * (px[c] - px[a]);
+    };
+
+    int guard = n * n;
+    while (ring.size() > 3 && guard-- > 0) {
+        int m = (int)ring.size();
+        bool clipped = false;
+        for (int k = 0; k < m; ++k) {
+            int a = ring[(k + m - 1) % m], b = ring[k], c = ring[(k + 1) % m];
+            double turn = cross(a, b, c);
+            if (turn == 0.0) {
+                // Collinear corner, drop it without emitting a zero-area triangle
+                ring.erase(ring.begin() + k);
+                clipped = true;
+                break;
+            }
+            if (turn < 0) continue; // reflex corner
+            bool contains = false;
+            for (int q = 0; q < m && !contains; ++q) {
+                int p = ring[q];
+                if (p == a || p == b || p == c) continue;
+                contains = cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0;
+            }
+            if (contains) continue;
+            tris.insert(tris.end(), { a, b, c });
+            ring.erase(ring.begin() + k);
+            clipped = true;
+            break;
+        }
+        if (!clipped) break; // self-intersecting outline, keep what we have
+    }
+    if (ring.size() == 3) tris.insert(tris.end(), { ring[0], ring[1], ring[2] });
+    return tris;
+}
+
+// Even-odd test of a position against the zone outline, in the same flat
+// projection the triangulation uses
+inline bool PointInZone(const ZoneGeometry& zone, double lat, double lon)
+{
+    const std::vector<std::tuple<double, double, double>>& points = zone.points;
+    int n = (int)points.size();
+    if (n < 3) return false;
+    double lon_scale = cos(std::get<0>(points[0]) * M_PI / 180.0);
+    double x = lon * lon_scale;
+    bool inside = false;
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+        double yi = std::get<0>(points[i]), yj = std::get<0>(points[j]);
+        double xi = std::get<1>(points[i]) * lon_scale, xj = std::get<1>(points[j]) * lon_scale;
+        if ((yi > lat) != (yj > lat) && x < (xj - xi) * (lat - yi) / (yj - yi) + xi) inside = !inside;
+    }
+    return inside;
+}
+
+// Function to load custom zone points from a file, safe to call off the sim thread
+inline bool LoadCustomZonePoints(const char* filename, ZoneGeometry& zone, const char** status, const ZoneGeometry* previous, bool* changed) {
+    std::ifstream infile(filename);
+    if (!infile) {
+        *status = "Zone file not found";
+        return false;
+    }
+    double lat, lon, alt;
+    while (infile >> lat >> lon >> alt) {
+        zone.points.emplace_back(lat, lon, alt);
+    }
+    if (zone.points.size() < 3) {
+        *status = "Too few zone points";
+        return false;
+    }
+    *status = "Zone loaded";
+    *changed = !previous || previous->points != zone.points;
+    if (!*changed) return true;
+
+    // The cap only depends on the outline, an altitude edit keeps the triangulation
+    bool same_outline = previous && previous->points.size() == zone.points.size();
+    for (size_t i = 0; same_outline && i < zone.points.size(); ++i) {
+        same_outline = std::get<0>(previous->points[i]) == std::get<0>(zone.points[i]) &&
+                       std::get<1>(previous->points[i]) == std::get<1>(zone.points[i]);
+    }
+    zone.cap_triangles = same_outline ? previous->cap_triangles : TriangulateZone(zone.points);
+    return true;
+}
@@ -2,6 +2,7 @@
 #include "XPLMDisplay.h"
 #include "XPLMGraphics.h"
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
 #include <vector>
@@ -15,13 +16,55 @@
 #include "stb_truetype.h"
 #include "XPLMPlanes.h"  // For multiplayer aircraft
 #include "XPLMDataAccess.h"
+#include "XPLMScenery.h"  // For terrain probes
 #include <map>
 #include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <ctime> // For naming session recordings
+#include "XPLMUtilities.h" // For the system path
+#include "XPLMPlugin.h" // For the aircraft loaded message
 #include <sstream> // For loading waypoints from file
+#include <sys/stat.h> // For watching the custom waypoint and zone files
+// Built-in route and zone, see tools/bake_assets.py. CMake bakes a fresh copy into the build tree.
+#ifdef HUD_BAKED_ASSETS_HEADER
+#include HUD_BAKED_ASSETS_HEADER
+#else
+#include "generated/BakedAssets.h"
+#endif
+#include "HudCore.h" // Geodesy, route and zone logic shared with the Python module
 
 #if IBM
+    #include <winsock2.h> // must come before windows.h
+    #include <ws2tcpip.h> // inet_pton
     #include <windows.h>
     #include <GL/gl.h>
+    #pragma comment(lib, "ws2_32.lib")
+#elif LIN
+    #include <GL/gl.h>
+    #include <GL/glx.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#elif APL
+    #include <OpenGL/gl.h>
+    #include <dlfcn.h>
+#endif
+
+#if !IBM
+    #include <sys/mman.h> // For the telemetry bus
+    #include <sys/socket.h> // For the UDP traffic feed
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <unistd.h>
 #endif
 
 #ifndef XPLM300
@@ -34,9 +77,9 @@
 
 static int        g_menu_container_idx;
 static XPLMMenuID g_menu_id;
+static XPLMMenuID g_route_menu = NULL; // Route Library submenu
 static bool       g_hud_visible = false;
 static bool g_font_baked = false;
-static float      g_ladder_spacing = 30.0f;  // Default pitch ladder spacing in pixels per degree
  
 // DataRefs for aircraft parameters
 static XPLMDataRef  g_airspeed_ias_ref = NULL;   // Indicated airspeed (knots)
@@ -48,8 +91,8 @@ static XPLMDataRef  g_roll_ref         = NULL;   // Roll angle (degrees)
 static XPLMDataRef  gHeadingRef       = NULL;   // Aircraft heading (degrees)
 static XPLMDataRef g_aoa_ref = NULL; // Angle of Attack (degrees)
 
-double lat1 = 47.4602, lon1 = -122.3078; // North end
-double lat2 = 47.4294, lon2 = -122.3080; // South end
+double lat1 = g_landing_runway.lat1, lon1 = g_landing_runway.lon1; // North end
+double lat2 = g_landing_runway.lat2, lon2 = g_landing_runway.lon2; // South end
 float elev = 400.0f; // Approx field elevation in feet
 
 // for landing assist
@@ -58,34 +101,116 @@ static bool radout_init_set = false;
 static bool g_landing_assist_visible = false;
 static bool g_seattle_to_kelowna_visible = false;
 static bool g_zones_visible = false;
+static bool g_custom_zone_visible = false;
 
 // for traffic 
 static bool g_aircraft_highlight_visible = false;
-static int draw_aircraft_highlight_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon); // callback for drawing aircraft highlights
-static void draw_highlight_box(float x, float y, float z, const float color[3], const char* tailnum);  // function to draw a highlight box around an aircraft
-static std::map<int, std::deque<std::array<float, 3>>> g_ai_trails; //store trails for each AI aircraft
+static void draw_highlight_box(float x, float y, float z, const float color[3], const char* tailnum, int priority);  // function to draw a highlight box around an aircraft
+static float traffic_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+static void ResetTrafficConflicts();
+static float trail_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+// Fixed-capacity ring of trail points, never reallocates once the plugin is loaded
+static const int g_max_trail_points = 1000;
+struct AiTrail {
+    std::array<std::array<float, 3>, g_max_trail_points> pts;
+    int start; // index of the oldest point
+    int count;
+    unsigned pushed;     // points pushed since the last clear, for the telemetry bus
+    unsigned generation; // bumped by every clear
+
+    void clear() {
+        start = 0;
+        count = 0;
+        pushed = 0;
+        ++generation;
+    }
+    void push(const std::array<float, 3>& p, int max_points) {
+        ++pushed;
+        pts[(start + count) % g_max_trail_points] = p;
+        if (count < g_max_trail_points) ++count;
+        else start = (start + 1) % g_max_trail_points;
+        while (count > max_points) {
+            start = (start + 1) % g_max_trail_points;
+            --count;
+        }
+    }
+    const std::array<float, 3>& at(int i) const { return pts[(start + i) % g_max_trail_points]; }
+};
+// Trails 1-19 belong to the multiplayer slots, the rest are handed out to feed targets
+// (g_max_traffic is in HudCore.h)
+static AiTrail g_ai_trails[g_max_traffic];
+static bool g_traffic_replay_active = false;
+static bool g_traffic_udp_active = false;
+static bool StartTrafficReplay();
+static void StopTrafficReplay();
+static bool StartTrafficUdp();
+static void StopTrafficUdp();
+static size_t TrafficFeedCount();
+
+// for the shared memory telemetry bus read by the UI process
+static bool OpenTelemetryBus();
+static void CloseTelemetryBus();
+static float telemetry_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+
+// for the instructor station UDP stream
+static bool g_instructor_stream_active = false;
+static bool StartInstructorStream();
+static void StopInstructorStream();
+
+// for recording sessions that tools/flight_analysis.cpp scores
+static bool g_session_recording_active = false;
+static bool StartSessionRecording();
+static void StopSessionRecording();
+
+// for guidance values shared by the draw callbacks and published as datarefs
+static void RegisterGuidanceDataRefs();
+static void UnregisterGuidanceDataRefs();
+static float guidance_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
 
 // for waypoints
 static bool g_custom_waypoints_visible = false;
-static bool LoadCustomWaypoints(const char* filename);
-static float draw_custom_waypoints_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon);
+static void LoadCustomWaypointsAsync(const char* filename, bool reload = false);
 static char g_waypoint_status[64] = "No load attempted";
 
 
 //for custom zones
-static std::vector<std::tuple<double, double, double>> g_custom_zone_points;
+static void LoadCustomZoneAsync(const char* filename, bool reload = false);
+static void BuildSeattleZone();
 static char g_zone_status[64] = "No zone load attempted";
 
+// for terrain following zone floors
+static int   g_terrain_probe_budget = 64;     // max terrain probes per sim frame
+static float g_zone_drape_spacing_m = 250.0f; // max distance between draped floor vertices
+static float terrain_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+static void ShutdownTerrainSampler();
+
+// for synthetic vision terrain
+static void StartSvsTerrain();
+static void StopSvsTerrain();
+static void ReleaseSvsBuffers();
+static float taws_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+static bool g_svs_visible   = false;
+static bool g_svs_wireframe = true;   // wireframe or elevation-shaded
+
 
 // ──────────────────────────────────
 // Forward declarations
 // ──────────────────────────────────
 
 static void menu_handler(void* in_menu_ref, void* in_item_ref);
-static float draw_hud_callback(
-    XPLMDrawingPhase inPhase,
-    int              inIsBefore,
-    void*            inRefcon);
+static void LoadHudLayout(bool reload = false);
+static void ReleaseHudStaticLayer();
+static void ReleaseHudBatches();
+static float hud_layout_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon);
+static void ReleaseHudFrameLayer();
+static void ReleaseOitTargets();
+static int draw_airplanes_layers_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon);
+static int draw_window_layers_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon);
+static void ReleaseLabelFont();
+static void ReserveLabelStorage();
+static void route_menu_handler(void* in_menu_ref, void* in_item_ref);
+static void ScanRouteLibrary();
+static void StopRouteLibrary();
 
 // ──────────────────────────────────
 // Utility: Draw text with black shadow for better readability
@@ -115,6 +240,799 @@ static void DrawTextWithShadow(
     glPopMatrix();
 }
 
+// ──────────────────────────────────
+// GL extension loading (framebuffer objects for cached HUD layers,
+// buffer objects for synthetic vision terrain, shaders and render targets
+// for order-independent transparency)
+// ──────────────────────────────────
+#ifndef APIENTRY
+    #define APIENTRY
+#endif
+#ifndef GL_FRAMEBUFFER
+    #define GL_FRAMEBUFFER          0x8D40
+    #define GL_COLOR_ATTACHMENT0    0x8CE0
+    #define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+    #define GL_FRAMEBUFFER_BINDING  0x8CA6
+#endif
+#ifndef GL_ARRAY_BUFFER
+    #define GL_ARRAY_BUFFER         0x8892
+    #define GL_ELEMENT_ARRAY_BUFFER 0x8893
+    #define GL_STATIC_DRAW          0x88E4
+#endif
+#ifndef GL_RENDERBUFFER
+    #define GL_RENDERBUFFER             0x8D41
+    #define GL_READ_FRAMEBUFFER         0x8CA8
+    #define GL_DRAW_FRAMEBUFFER         0x8CA9
+    #define GL_READ_FRAMEBUFFER_BINDING 0x8CAA
+    #define GL_COLOR_ATTACHMENT1        0x8CE1
+    #define GL_DEPTH_STENCIL_ATTACHMENT 0x821A
+    #define GL_DEPTH24_STENCIL8         0x88F0
+#endif
+#ifndef GL_FRAGMENT_SHADER
+    #define GL_FRAGMENT_SHADER      0x8B30
+    #define GL_VERTEX_SHADER        0x8B31
+    #define GL_COMPILE_STATUS       0x8B81
+    #define GL_LINK_STATUS          0x8B82
+#endif
+#ifndef GL_RGBA16F
+    #define GL_RGBA16F              0x881A
+#endif
+
+typedef void   (APIENTRY *PFN_glGenFramebuffers)(GLsizei, GLuint*);
+typedef void   (APIENTRY *PFN_glDeleteFramebuffers)(GLsizei, const GLuint*);
+typedef void   (APIENTRY *PFN_glBindFramebuffer)(GLenum, GLuint);
+typedef void   (APIENTRY *PFN_glFramebufferTexture2D)(GLenum, GLenum, GLenum, GLuint, GLint);
+typedef GLenum (APIENTRY *PFN_glCheckFramebufferStatus)(GLenum);
+typedef void   (APIENTRY *PFN_glBlendFuncSeparate)(GLenum, GLenum, GLenum, GLenum);
+typedef void   (APIENTRY *PFN_glGenBuffers)(GLsizei, GLuint*);
+typedef void   (APIENTRY *PFN_glDeleteBuffers)(GLsizei, const GLuint*);
+typedef void   (APIENTRY *PFN_glBindBuffer)(GLenum, GLuint);
+typedef void   (APIENTRY *PFN_glBufferData)(GLenum, ptrdiff_t, const void*, GLenum);
+typedef void   (APIENTRY *PFN_glGenRenderbuffers)(GLsizei, GLuint*);
+typedef void   (APIENTRY *PFN_glDeleteRenderbuffers)(GLsizei, const GLuint*);
+typedef void   (APIENTRY *PFN_glBindRenderbuffer)(GLenum, GLuint);
+typedef void   (APIENTRY *PFN_glRenderbufferStorage)(GLenum, GLenum, GLsizei, GLsizei);
+typedef void   (APIENTRY *PFN_glFramebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint);
+typedef void   (APIENTRY *PFN_glBlitFramebuffer)(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum);
+typedef void   (APIENTRY *PFN_glDrawBuffers)(GLsizei, const GLenum*);
+typedef GLuint (APIENTRY *PFN_glCreateShader)(GLenum);
+typedef void   (APIENTRY *PFN_glShaderSource)(GLuint, GLsizei, const char* const*, const GLint*);
+typedef void   (APIENTRY *PFN_glCompileShader)(GLuint);
+typedef void   (APIENTRY *PFN_glGetShaderiv)(GLuint, GLenum, GLint*);
+typedef void   (APIENTRY *PFN_glGetShaderInfoLog)(GLuint, GLsizei, GLsizei*, char*);
+typedef void   (APIENTRY *PFN_glDeleteShader)(GLuint);
+typedef GLuint (APIENTRY *PFN_glCreateProgram)(void);
+typedef void   (APIENTRY *PFN_glAttachShader)(GLuint, GLuint);
+typedef void   (APIENTRY *PFN_glLinkProgram)(GLuint);
+typedef void   (APIENTRY *PFN_glGetProgramiv)(GLuint, GLenum, GLint*);
+typedef void   (APIENTRY *PFN_glDeleteProgram)(GLuint);
+typedef void   (APIENTRY *PFN_glUseProgram)(GLuint);
+typedef GLint  (APIENTRY *PFN_glGetUniformLocation)(GLuint, const char*);
+typedef void   (APIENTRY *PFN_glUniform1i)(GLint, GLint);
+typedef void   (APIENTRY *PFN_glUniform1f)(GLint, GLfloat);
+
+static PFN_glGenFramebuffers        p_glGenFramebuffers        = NULL;
+static PFN_glDeleteFramebuffers     p_glDeleteFramebuffers     = NULL;
+static PFN_glBindFramebuffer        p_glBindFramebuffer        = NULL;
+static PFN_glFramebufferTexture2D   p_glFramebufferTexture2D   = NULL;
+static PFN_glCheckFramebufferStatus p_glCheckFramebufferStatus = NULL;
+static PFN_glBlendFuncSeparate      p_glBlendFuncSeparate      = NULL;
+static PFN_glGenBuffers             p_glGenBuffers             = NULL;
+static PFN_glDeleteBuffers          p_glDeleteBuffers          = NULL;
+static PFN_glBindBuffer             p_glBindBuffer             = NULL;
+static PFN_glBufferData             p_glBufferData             = NULL;
+static PFN_glGenRenderbuffers        p_glGenRenderbuffers        = NULL;
+static PFN_glDeleteRenderbuffers     p_glDeleteRenderbuffers     = NULL;
+static PFN_glBindRenderbuffer        p_glBindRenderbuffer        = NULL;
+static PFN_glRenderbufferStorage     p_glRenderbufferStorage     = NULL;
+static PFN_glFramebufferRenderbuffer p_glFramebufferRenderbuffer = NULL;
+static PFN_glBlitFramebuffer         p_glBlitFramebuffer         = NULL;
+static PFN_glDrawBuffers             p_glDrawBuffers             = NULL;
+static PFN_glCreateShader            p_glCreateShader            = NULL;
+static PFN_glShaderSource            p_glShaderSource            = NULL;
+static PFN_glCompileShader           p_glCompileShader           = NULL;
+static PFN_glGetShaderiv             p_glGetShaderiv             = NULL;
+static PFN_glGetShaderInfoLog        p_glGetShaderInfoLog        = NULL;
+static PFN_glDeleteShader            p_glDeleteShader            = NULL;
+static PFN_glCreateProgram           p_glCreateProgram           = NULL;
+static PFN_glAttachShader            p_glAttachShader            = NULL;
+static PFN_glLinkProgram             p_glLinkProgram             = NULL;
+static PFN_glGetProgramiv            p_glGetProgramiv            = NULL;
+static PFN_glDeleteProgram           p_glDeleteProgram           = NULL;
+static PFN_glUseProgram              p_glUseProgram              = NULL;
+static PFN_glGetUniformLocation      p_glGetUniformLocation      = NULL;
+static PFN_glUniform1i               p_glUniform1i               = NULL;
+static PFN_glUniform1f               p_glUniform1f               = NULL;
+static bool g_gl_ext_loaded = false;
+static bool g_gl_fbo_ok     = false;
+static bool g_gl_vbo_ok     = false;
+static bool g_gl_oit_ok     = false; // shaders, multiple render targets and depth blits
+
+static void* GetGLProc(const char* name)
+{
+#if IBM
+    return (void*)wglGetProcAddress(name);
+#elif LIN
+    return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#elif APL
+    return dlsym(RTLD_DEFAULT, name);
+#else
+    return NULL;
+#endif
+}
+
+// Must be called with a current GL context (i.e. from a draw callback)
+static bool LoadGLExtensions()
+{
+    if (g_gl_ext_loaded) return g_gl_fbo_ok;
+    g_gl_ext_loaded = true;
+
+    p_glGenFramebuffers        = (PFN_glGenFramebuffers)GetGLProc("glGenFramebuffers");
+    p_glDeleteFramebuffers     = (PFN_glDeleteFramebuffers)GetGLProc("glDeleteFramebuffers");
+    p_glBindFramebuffer        = (PFN_glBindFramebuffer)GetGLProc("glBindFramebuffer");
+    p_glFramebufferTexture2D   = (PFN_glFramebufferTexture2D)GetGLProc("glFramebufferTexture2D");
+    p_glCheckFramebufferStatus = (PFN_glCheckFramebufferStatus)GetGLProc("glCheckFramebufferStatus");
+    p_glBlendFuncSeparate      = (PFN_glBlendFuncSeparate)GetGLProc("glBlendFuncSeparate");
+    p_glGenBuffers             = (PFN_glGenBuffers)GetGLProc("glGenBuffers");
+    p_glDeleteBuffers          = (PFN_glDeleteBuffers)GetGLProc("glDeleteBuffers");
+    p_glBindBuffer             = (PFN_glBindBuffer)GetGLProc("glBindBuffer");
+    p_glBufferData             = (PFN_glBufferData)GetGLProc("glBufferData");
+    p_glGenRenderbuffers        = (PFN_glGenRenderbuffers)GetGLProc("glGenRenderbuffers");
+    p_glDeleteRenderbuffers     = (PFN_glDeleteRenderbuffers)GetGLProc("glDeleteRenderbuffers");
+    p_glBindRenderbuffer        = (PFN_glBindRenderbuffer)GetGLProc("glBindRenderbuffer");
+    p_glRenderbufferStorage     = (PFN_glRenderbufferStorage)GetGLProc("glRenderbufferStorage");
+    p_glFramebufferRenderbuffer = (PFN_glFramebufferRenderbuffer)GetGLProc("glFramebufferRenderbuffer");
+    p_glBlitFramebuffer         = (PFN_glBlitFramebuffer)GetGLProc("glBlitFramebuffer");
+    p_glDrawBuffers             = (PFN_glDrawBuffers)GetGLProc("glDrawBuffers");
+    p_glCreateShader            = (PFN_glCreateShader)GetGLProc("glCreateShader");
+    p_glShaderSource            = (PFN_glShaderSource)GetGLProc("glShaderSource");
+    p_glCompileShader           = (PFN_glCompileShader)GetGLProc("glCompileShader");
+    p_glGetShaderiv             = (PFN_glGetShaderiv)GetGLProc("glGetShaderiv");
+    p_glGetShaderInfoLog        = (PFN_glGetShaderInfoLog)GetGLProc("glGetShaderInfoLog");
+    p_glDeleteShader            = (PFN_glDeleteShader)GetGLProc("glDeleteShader");
+    p_glCreateProgram           = (PFN_glCreateProgram)GetGLProc("glCreateProgram");
+    p_glAttachShader            = (PFN_glAttachShader)GetGLProc("glAttachShader");
+    p_glLinkProgram             = (PFN_glLinkProgram)GetGLProc("glLinkProgram");
+    p_glGetProgramiv            = (PFN_glGetProgramiv)GetGLProc("glGetProgramiv");
+    p_glDeleteProgram           = (PFN_glDeleteProgram)GetGLProc("glDeleteProgram");
+    p_glUseProgram              = (PFN_glUseProgram)GetGLProc("glUseProgram");
+    p_glGetUniformLocation      = (PFN_glGetUniformLocation)GetGLProc("glGetUniformLocation");
+    p_glUniform1i               = (PFN_glUniform1i)GetGLProc("glUniform1i");
+    p_glUniform1f               = (PFN_glUniform1f)GetGLProc("glUniform1f");
+
+    g_gl_fbo_ok = p_glGenFramebuffers && p_glDeleteFramebuffers && p_glBindFramebuffer &&
+                  p_glFramebufferTexture2D && p_glCheckFramebufferStatus && p_glBlendFuncSeparate;
+    if (!g_gl_fbo_ok) {
+        XPLMDebugString("HUDPlugin: framebuffer objects unavailable, HUD layers drawn directly.\n");
+    }
+    g_gl_vbo_ok = p_glGenBuffers && p_glDeleteBuffers && p_glBindBuffer && p_glBufferData;
+    if (!g_gl_vbo_ok) {
+        XPLMDebugString("HUDPlugin: buffer objects unavailable, synthetic vision disabled.\n");
+    }
+    g_gl_oit_ok = g_gl_fbo_ok && p_glGenRenderbuffers && p_glDeleteRenderbuffers && p_glBindRenderbuffer &&
+                  p_glRenderbufferStorage && p_glFramebufferRenderbuffer && p_glBlitFramebuffer &&
+                  p_glDrawBuffers && p_glCreateShader && p_glShaderSource && p_glCompileShader &&
+                  p_glGetShaderiv && p_glGetShaderInfoLog && p_glDeleteShader && p_glCreateProgram &&
+                  p_glAttachShader && p_glLinkProgram && p_glGetProgramiv && p_glDeleteProgram &&
+                  p_glUseProgram && p_glGetUniformLocation && p_glUniform1i && p_glUniform1f;
+    if (!g_gl_oit_ok) {
+        XPLMDebugString("HUDPlugin: shaders or render targets unavailable, zones blended in draw order.\n");
+    }
+    return g_gl_fbo_ok;
+}
+
+static bool GLHasVertexBuffers()
+{
+    LoadGLExtensions();
+    return g_gl_vbo_ok;
+}
+
+// ──────────────────────────────────
+// GL state tracker. Overlay layers change state through these rather than
+// calling GL or XPLMSetGraphicsState directly, and a shadow copy lets a
+// layer skip whatever the layer before it already set. The shadow is only
+// trusted inside one overlay dispatch (see DispatchOverlayLayers): X-Plane
+// and other plugins draw in between, and XPLMDrawString sets state of its own.
+// ──────────────────────────────────
+struct GraphicsState {
+    int fog, tex_units, lighting, alpha_test, blend, depth_test, depth_write; // XPLMSetGraphicsState arguments
+
+    bool operator==(const GraphicsState& o) const {
+        return fog == o.fog && tex_units == o.tex_units && lighting == o.lighting && alpha_test == o.alpha_test &&
+               blend == o.blend && depth_test == o.depth_test && depth_write == o.depth_write;
+    }
+};
+
+struct GLStateShadow {
+    bool          graphics_known;
+    GraphicsState graphics;
+    bool          blend_known;
+    GLenum        blend_func[4]; // src rgb, dst rgb, src alpha, dst alpha
+    float         line_width;    // < 0 = unknown
+};
+static GLStateShadow g_gl_state = { false, { 0, 0, 0, 0, 0, 0, 0 }, false, { 0, 0, 0, 0 }, -1.0f };
+
+static void InvalidateGLState()
+{
+    g_gl_state.graphics_known = false;
+    g_gl_state.blend_known = false;
+    g_gl_state.line_width = -1.0f;
+}
+
+static void SetGraphicsState(const GraphicsState& s)
+{
+    if (g_gl_state.graphics_known && g_gl_state.graphics == s) return;
+    XPLMSetGraphicsState(s.fog, s.tex_units, s.lighting, s.alpha_test, s.blend, s.depth_test, s.depth_write);
+    g_gl_state.graphics = s;
+    g_gl_state.graphics_known = true;
+}
+
+static void SetGraphicsState(int fog, int tex_units, int lighting, int alpha_test, int blend, int depth_test, int depth_write)
+{
+    SetGraphicsState(GraphicsState{ fog, tex_units, lighting, alpha_test, blend, depth_test, depth_write });
+}
+
+static void SetBlendFuncSeparate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha)
+{
+    GLenum* f = g_gl_state.blend_func;
+    if (g_gl_state.blend_known && f[0] == src_rgb && f[1] == dst_rgb && f[2] == src_alpha && f[3] == dst_alpha) return;
+    if (src_rgb == src_alpha && dst_rgb == dst_alpha) glBlendFunc(src_rgb, dst_rgb);
+    else p_glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+    f[0] = src_rgb;
+    f[1] = dst_rgb;
+    f[2] = src_alpha;
+    f[3] = dst_alpha;
+    g_gl_state.blend_known = true;
+}
+
+static void SetBlendFunc(GLenum src, GLenum dst)
+{
+    SetBlendFuncSeparate(src, dst, src, dst);
+}
+
+static void SetLineWidth(float width)
+{
+    if (g_gl_state.line_width == width) return;
+    glLineWidth(width);
+    g_gl_state.line_width = width;
+}
+
+// ──────────────────────────────────
+// Per-frame arena: scratch memory for draw callbacks. Everything allocated
+// from it is released at once when the next drawing phase starts, so the
+// draw path does not touch the heap once the arena has grown to size.
+// ──────────────────────────────────
+class FrameArena {
+public:
+    FrameArena() : m_buf(NULL), m_capacity(0), m_used(0), m_high_water(0) {}
+    ~FrameArena() {
+        Reset();
+        free(m_buf);
+    }
+
+    void* Allocate(size_t bytes, size_t align) {
+        size_t offset = (m_used + align - 1) & ~(align - 1);
+        if (m_buf && offset + bytes <= m_capacity) {
+            m_used = offset + bytes;
+            if (m_used > m_high_water) m_high_water = m_used;
+            return m_buf + offset;
+        }
+        // Out of space this frame: fall back to the heap and grow on the next reset
+        m_high_water = offset + bytes > m_high_water ? offset + bytes : m_high_water;
+        void* p = malloc(bytes);
+        m_overflow.push_back(p);
+        return p;
+    }
+
+    // Called at the start of each drawing phase
+    void Reset() {
+        if (!m_overflow.empty()) {
+            for (void* p : m_overflow) free(p);
+            m_overflow.clear();
+        }
+        if (m_high_water > m_capacity) {
+            size_t new_capacity = m_capacity ? m_capacity : 64 * 1024;
+            while (new_capacity < m_high_water) new_capacity *= 2;
+            free(m_buf);
+            m_buf = (char*)malloc(new_capacity);
+            m_capacity = m_buf ? new_capacity : 0;
+            m_overflow.reserve(16);
+        }
+        m_used = 0;
+    }
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    char*              m_buf;
+    size_t             m_capacity;
+    size_t             m_used;
+    size_t             m_high_water;
+    std::vector<void*> m_overflow;
+};
+
+static FrameArena g_frame_arena;
+
+// STL allocator over g_frame_arena, deallocate is a no-op
+template <typename T>
+struct FrameAllocator {
+    typedef T value_type;
+
+    FrameAllocator() {}
+    template <typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+    T* allocate(size_t n) { return (T*)g_frame_arena.Allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+// Debug builds can define HUD_COUNT_ALLOCS to count heap allocations made
+// inside draw callbacks. After warm-up the draw path must make none.
+#ifdef HUD_COUNT_ALLOCS
+#include <atomic>
+#include <new>
+#include <cassert>
+static std::atomic<long> g_heap_allocs(0);
+static long g_draw_heap_allocs = 0;
+static int  g_draw_frames = 0;
+
+void* operator new(size_t size) {
+    ++g_heap_allocs;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct DrawAllocScope {
+    long start;
+    DrawAllocScope() : start(g_heap_allocs) {}
+    ~DrawAllocScope() { g_draw_heap_allocs += g_heap_allocs - start; }
+};
+
+static void CheckDrawAllocations() {
+    const int warmup_frames = 120;
+    if (++g_draw_frames > warmup_frames && g_draw_heap_allocs != 0) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "HUDPlugin: %ld heap allocations on the draw path\n", g_draw_heap_allocs);
+        XPLMDebugString(buf);
+        assert(g_draw_heap_allocs == 0);
+    }
+    g_draw_heap_allocs = 0;
+}
+#else
+struct DrawAllocScope {
+    DrawAllocScope() {} // user-provided, so release builds do not warn about unused scopes
+};
+static void CheckDrawAllocations() {}
+#endif
+
+// Registered "before" each drawing phase the plugin draws in
+static int frame_arena_reset_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon)
+{
+    CheckDrawAllocations();
+    g_frame_arena.Reset();
+    return 1;
+}
+
+// ──────────────────────────────────
+// Quality governor. Draw callbacks and flight loops add their wall time
+// to a per-frame total; once per frame the governor compares a smoothed
+// total against the budget and against its share of the sim's frame
+// period, and steps the quality level up or down with hysteresis.
+// Each level sets the knobs the expensive overlays read.
+// ──────────────────────────────────
+struct QualityLevel {
+    const char* name;
+    float  trail_scale;      // multiplies the distance-based trail length
+    double route_box_m;      // waypoint boxes further than this are left out, the route line stays
+    bool   zone_wireframe;   // outline and corner posts on zones
+    float  traffic_hz;       // cap on the traffic sample rate
+};
+
+static const QualityLevel g_quality_levels[] = {
+    { "HIGH", 1.0f,  1e12,    true,  8.0f },
+    { "MED",  0.5f,  80000.0, true,  6.0f },
+    { "LOW",  0.25f, 40000.0, false, 4.0f },
+    { "MIN",  0.1f,  15000.0, false, 2.0f },
+};
+static const int g_quality_level_count = sizeof(g_quality_levels) / sizeof(g_quality_levels[0]);
+
+static float g_governor_budget_ms  = 2.0f;  // plugin time per frame we aim to stay under
+static float g_governor_target_fps = 30.0f; // below this the plugin gives back time if it is a real share
+static float g_governor_share      = 0.1f;  // "real share" of the frame period
+static float g_governor_down_hold_s = 2.0f; // min time between steps down
+static float g_governor_up_hold_s   = 5.0f; // min time before stepping back up
+
+static int    g_quality = 0;
+static double g_frame_cost_s = 0.0;   // accumulated since the governor last ran
+static float  g_governor_cost_ms = 0.0f;
+static float  g_governor_period_s = 0.0f;
+static float  g_governor_hold_until = 0.0f;
+
+struct FrameCostScope {
+    std::chrono::steady_clock::time_point start;
+    FrameCostScope() : start(std::chrono::steady_clock::now()) {}
+    ~FrameCostScope() { g_frame_cost_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+};
+
+static const QualityLevel& Quality() { return g_quality_levels[g_quality]; }
+
+static float governor_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    static XPLMDataRef period_ref = XPLMFindDataRef("sim/operation/misc/frame_rate_period");
+    float cost_ms = (float)(g_frame_cost_s * 1000.0);
+    g_frame_cost_s = 0.0;
+    float period_s = period_ref ? XPLMGetDataf(period_ref) : inElapsedSinceLastCall;
+
+    // Smooth over roughly a second so single hitches don't flip levels
+    g_governor_cost_ms += 0.05f * (cost_ms - g_governor_cost_ms);
+    g_governor_period_s += 0.05f * (period_s - g_governor_period_s);
+
+    float now = XPLMGetElapsedTime();
+    if (now < g_governor_hold_until) return -1.0f;
+
+    float target_period_s = 1.0f / g_governor_target_fps;
+    bool sim_slow = g_governor_period_s > target_period_s &&
+                    g_governor_cost_ms > g_governor_share * g_governor_period_s * 1000.0f;
+    bool over = g_governor_cost_ms > g_governor_budget_ms || sim_slow;
+    // Stepping up looks only at the plugin's own cost: a sim that is slow for
+    // other reasons must not pin quality low once the plugin is a small share
+    bool under = g_governor_cost_ms < 0.5f * g_governor_budget_ms &&
+                 g_governor_cost_ms < 0.5f * g_governor_share * g_governor_period_s * 1000.0f;
+
+    int level = g_quality;
+    if (over && g_quality < g_quality_level_count - 1) {
+        ++level;
+        g_governor_hold_until = now + g_governor_down_hold_s;
+    } else if (under && g_quality > 0) {
+        --level;
+        g_governor_hold_until = now + g_governor_up_hold_s;
+    }
+    if (level != g_quality) {
+        g_quality = level;
+        char buf[128];
+        snprintf(buf, sizeof(buf), "HUDPlugin: quality %s (plugin %.2f ms, frame %.1f ms)\n",
+            Quality().name, g_governor_cost_ms, g_governor_period_s * 1000.0f);
+        XPLMDebugString(buf);
+    }
+    return -1.0f;
+}
+
+// ──────────────────────────────────
+// Worker thread pool. CPU-heavy work (file parsing, triangulation, DEM
+// loading and meshing) runs here instead of on the sim thread. Each worker
+// has its own job deque and steals from the others when idle. Finished
+// work hands a completion back through the worker's lock-free SPSC outbox;
+// completions run on the sim thread in worker_results_flight_loop and
+// publish immutable results that the draw callbacks read.
+// ──────────────────────────────────
+
+// Single producer, single consumer ring buffer
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    SpscQueue() : m_head(0), m_tail(0) {}
+
+    bool Push(T&& v) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % Capacity;
+        if (next == m_head.load(std::memory_order_acquire)) return false; // full
+        m_items[tail] = std::move(v);
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& out) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false; // empty
+        out = std::move(m_items[head]);
+        m_items[head] = T();
+        m_head.store((head + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, Capacity> m_items;
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
+
+// Latest immutable version of a value. Writers publish a new snapshot,
+// readers hold on to whichever snapshot they acquired for as long as they
+// need it. The epoch tells readers cheaply whether anything changed.
+template <typename T>
+class Published {
+public:
+    Published() : m_epoch(0) {}
+
+    void Publish(std::shared_ptr<const T> value) {
+        std::atomic_store(&m_value, std::move(value));
+        m_epoch.fetch_add(1, std::memory_order_release);
+    }
+
+    std::shared_ptr<const T> Acquire() const { return std::atomic_load(&m_value); }
+    unsigned Epoch() const { return m_epoch.load(std::memory_order_acquire); }
+
+private:
+    std::shared_ptr<const T> m_value;
+    std::atomic<unsigned> m_epoch;
+};
+
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    ThreadPool() : m_stop(false), m_pending(0), m_next(0) {}
+
+    void Start(int threads) {
+        if (!m_workers.empty()) return;
+        m_stop = false;
+        for (int i = 0; i < threads; ++i) m_workers.emplace_back(new Worker());
+        for (int i = 0; i < threads; ++i) m_workers[i]->thread = std::thread(&ThreadPool::Run, this, i);
+    }
+
+    // Joins the workers. Queued jobs and undelivered completions are dropped.
+    void Stop() {
+        if (m_workers.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for (auto& w : m_workers) w->thread.join();
+        m_workers.clear();
+        m_pending = 0;
+    }
+
+    // Runs 'work' on a worker, then 'done' on the sim thread. Sim thread only.
+    void Submit(Task work, Task done) {
+        if (m_workers.empty()) { // not running, do it inline
+            work();
+            if (done) done();
+            return;
+        }
+        Worker& w = *m_workers[m_next++ % m_workers.size()];
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.jobs.push_back(Job{ std::move(work), std::move(done) });
+        }
+        m_pending.fetch_add(1);
+        { std::lock_guard<std::mutex> lock(m_sleep_mutex); }
+        m_cv.notify_one();
+    }
+
+    // Runs completions handed back by the workers. Sim thread only.
+    void DrainCompletions() {
+        Task done;
+        for (auto& w : m_workers) {
+            while (w->outbox.Pop(done)) {
+                if (done) done();
+            }
+        }
+    }
+
+private:
+    struct Job {
+        Task work;
+        Task done;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        SpscQueue<Task, 1024> outbox;
+        std::thread thread;
+    };
+
+    // Own jobs are taken newest first, stolen jobs oldest first
+    bool PopOrSteal(int self, Job& out) {
+        int n = (int)m_workers.size();
+        for (int k = 0; k < n; ++k) {
+            Worker& w = *m_workers[(self + k) % n];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (w.jobs.empty()) continue;
+            if (k == 0) {
+                out = std::move(w.jobs.back());
+                w.jobs.pop_back();
+            } else {
+                out = std::move(w.jobs.front());
+                w.jobs.pop_front();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void Run(int self) {
+        Worker& me = *m_workers[self];
+        for (;;) {
+            Job job;
+            if (PopOrSteal(self, job)) {
+                m_pending.fetch_sub(1);
+                job.work();
+                // The sim thread drains every frame, wait for room if it falls behind
+                while (!me.outbox.Push(std::move(job.done))) {
+                    if (m_stop) return;
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_cv.wait(lock, [this] { return m_stop || m_pending.load() > 0; });
+            if (m_stop) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_cv;
+    std::atomic<bool> m_stop;
+    std::atomic<int> m_pending;
+    size_t m_next;
+};
+
+static ThreadPool g_pool;
+
+static float worker_results_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    g_pool.DrainCompletions();
+    return -1.0f; // every frame
+}
+
+// ──────────────────────────────────
+// File watcher for hot reloading the custom waypoint and zone files.
+// Linux uses inotify on the containing directory, which also catches
+// editors that save by renaming a temp file over the original. Elsewhere,
+// or if inotify is unavailable, the files are polled for size and mtime.
+// A change only fires once the file has been quiet for a moment, so a
+// save that arrives as several writes is reparsed once.
+// ──────────────────────────────────
+
+static float g_file_watch_interval_s = 0.25f; // flight loop period
+static float g_file_poll_interval_s  = 1.0f;  // stat polling period for the fallback
+static float g_file_settle_s         = 0.3f;  // quiet time before a change fires
+
+class FileWatcher {
+public:
+    typedef std::function<void()> Callback;
+
+    FileWatcher() : m_inotify_fd(-1), m_next_poll(0.0f) {}
+
+    // Watches 'path' under 'name', replacing any earlier watch with that name
+    void Watch(const char* name, const std::string& path, Callback on_change) {
+        Entry& e = m_entries[name];
+        e.path = path;
+        e.on_change = std::move(on_change);
+        e.dirty = false;
+        e.changed_at = 0.0f;
+        Stat(path, e.mtime, e.size);
+#if LIN
+        if (e.wd >= 0) {
+            // Directory watches are shared, only drop the old one if nothing else uses it
+            int old_wd = e.wd;
+            e.wd = -1;
+            bool shared = false;
+            for (auto& kv : m_entries) shared = shared || kv.second.wd == old_wd;
+            if (!shared) inotify_rm_watch(m_inotify_fd, old_wd);
+        }
+        // Relative names depend on X-Plane's working directory, so those are polled
+        size_t slash = path.find_last_of('/');
+        if (slash == std::string::npos) return;
+        if (m_inotify_fd < 0) m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotify_fd >= 0) {
+            std::string dir = slash == 0 ? "/" : path.substr(0, slash);
+            e.leaf = path.substr(slash + 1);
+            e.wd = inotify_add_watch(m_inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        }
+#endif
+    }
+
+    // Fires the callbacks of files that changed and have settled. Sim thread only.
+    void Poll(float now) {
+#if LIN
+        if (m_inotify_fd >= 0) ReadEvents(now);
+#endif
+        if (now >= m_next_poll) {
+            m_next_poll = now + g_file_poll_interval_s;
+            for (auto& kv : m_entries) {
+                Entry& e = kv.second;
+                if (e.wd >= 0) continue; // inotify covers it
+                time_t mtime;
+                long long size;
+                Stat(e.path, mtime, size);
+                if (mtime != e.mtime || size != e.size) {
+                    e.mtime = mtime;
+                    e.size = size;
+                    MarkDirty(e, now);
+                }
+            }
+        }
+        for (auto& kv : m_entries) {
+            Entry& e = kv.second;
+            if (e.dirty && now - e.changed_at >= g_file_settle_s) {
+                e.dirty = false;
+                e.on_change();
+            }
+        }
+    }
+
+    void Shutdown() {
+#if LIN
+        if (m_inotify_fd >= 0) close(m_inotify_fd);
+#endif
+        m_inotify_fd = -1;
+        m_entries.clear();
+    }
+
+private:
+    struct Entry {
+        std::string path;
+        std::string leaf;   // file name inside the watched directory
+        int wd = -1;        // inotify watch, -1 when polled
+        time_t mtime = 0;
+        long long size = -1;
+        bool dirty = false;
+        float changed_at = 0.0f;
+        Callback on_change;
+    };
+
+    static void Stat(const std::string& path, time_t& mtime, long long& size) {
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0) {
+            mtime = st.st_mtime;
+            size = (long long)st.st_size;
+        } else {
+            mtime = 0;
+            size = -1;
+        }
+    }
+
+    static void MarkDirty(Entry& e, float now) {
+        e.dirty = true;
+        e.changed_at = now;
+    }
+
+#if LIN
+    void ReadEvents(float now) {
+        alignas(inotify_event) char buf[4096];
+        for (;;) {
+            ssize_t len = read(m_inotify_fd, buf, sizeof(buf));
+            if (len <= 0) return;
+            for (ssize_t off = 0; off < len;) {
+                const inotify_event* ev = (const inotify_event*)(buf + off);
+                off += sizeof(inotify_event) + ev->len;
+                if (ev->len == 0) continue;
+                for (auto& kv : m_entries) {
+                    Entry& e = kv.second;
+                    if (e.wd == ev->wd && e.leaf == ev->name) MarkDirty(e, now);
+                }
+            }
+        }
+    }
+#endif
+
+    std::map<std::string, Entry> m_entries;
+    int m_inotify_fd;
+    float m_next_poll;
+};
+
+static FileWatcher g_file_watcher;
+
+static float file_watch_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    g_file_watcher.Poll(XPLMGetElapsedTime());
+    return g_file_watch_interval_s;
+}
+
 // ──────────────────────────────────
 // Plugin API functions: Start, Stop, Enable, Disable, ReceiveMessage
 // ──────────────────────────────────
@@ -159,6 +1077,9 @@ XPluginStart(
     XPLMAppendMenuItem(g_menu_id, "Seattle to Kelowna", (void*)"S to K", 1);
     XPLMAppendMenuItem(g_menu_id, "Load Custom Waypoints", (void*)"Load Custom Waypoints", 1);
     XPLMAppendMenuItem(g_menu_id, "Show Custom Waypoints", (void*)"Show Custom Waypoints", 1);
+    int route_menu_idx = XPLMAppendMenuItem(g_menu_id, "Route Library", 0, 0);
+    g_route_menu = XPLMCreateMenu("Route Library", g_menu_id, route_menu_idx, route_menu_handler, NULL);
+    ScanRouteLibrary();
     XPLMAppendMenuSeparator(g_menu_id);
 
     XPLMAppendMenuItem(g_menu_id, "Show zones", (void*)"Zones", 1);
@@ -168,6 +1089,14 @@ XPluginStart(
 
     XPLMAppendMenuItem(g_menu_id, "HUD", (void*)"HUD Item", 1);
     XPLMAppendMenuItem(g_menu_id, "Toggle Aircraft Highlight", (void*)"Toggle Aircraft Highlight", 1);
+    XPLMAppendMenuItem(g_menu_id, "Replay Recorded Traffic", (void*)"Traffic Replay", 1);
+    XPLMAppendMenuItem(g_menu_id, "Listen for UDP Traffic", (void*)"Traffic UDP", 1);
+    XPLMAppendMenuItem(g_menu_id, "Stream to Instructor Station", (void*)"Instructor Stream", 1);
+    XPLMAppendMenuItem(g_menu_id, "Record Session", (void*)"Session Recorder", 1);
+    XPLMAppendMenuSeparator(g_menu_id);
+
+    XPLMAppendMenuItem(g_menu_id, "Synthetic Vision", (void*)"SVS Terrain", 1);
+    XPLMAppendMenuItem(g_menu_id, "SVS Wireframe/Shaded", (void*)"SVS Style", 1);
 
     // If loaded in an aircraft folder, add extra menu item to Aircraft menu
     {
@@ -189,6 +1118,9 @@ XPluginStart(
     g_roll_ref         = XPLMFindDataRef("sim/flightmodel/position/phi");
     gHeadingRef        = XPLMFindDataRef("sim/flightmodel/position/psi");
     g_aoa_ref = XPLMFindDataRef("sim/flightmodel2/misc/AoA_angle_degrees");
+
+    // Guidance values for other plugins and the UI
+    RegisterGuidanceDataRefs();
     float ac_lat = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/latitude"));
     float ac_lon = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/longitude"));
     return 1;
@@ -197,28 +1129,101 @@ XPluginStart(
 PLUGIN_API void
 XPluginStop(void)
 {
+    XPLMDestroyMenu(g_route_menu);
     XPLMDestroyMenu(g_menu_id);
-
-    if (g_hud_visible) {
-        XPLMUnregisterDrawCallback(
-            (XPLMDrawCallback_f)draw_hud_callback,
-            xplm_Phase_Window,
-            0,
-            NULL);
-    }
+    ReleaseHudStaticLayer();
+    ReleaseHudBatches();
+    ReleaseHudFrameLayer();
+    ReleaseOitTargets();
+    UnregisterGuidanceDataRefs();
+    ShutdownTerrainSampler();
 }
 
 
 PLUGIN_API void
 XPluginDisable(void)
 {
-    // No special action required on disable
+    XPLMUnregisterFlightLoopCallback(terrain_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(taws_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(worker_results_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(file_watch_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(traffic_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(trail_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(governor_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(telemetry_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(guidance_flight_loop, NULL);
+    XPLMUnregisterFlightLoopCallback(hud_layout_flight_loop, NULL);
+    CloseTelemetryBus();
+    g_file_watcher.Shutdown();
+    g_pool.Stop();
+    // Completions of loads still in flight were dropped with the pool
+    if (!strcmp(g_waypoint_status, "Loading")) strcpy(g_waypoint_status, "No load attempted");
+    if (!strcmp(g_zone_status, "Zone loading")) strcpy(g_zone_status, "No zone load attempted");
+    StopSvsTerrain();
+    StopRouteLibrary();
+    ResetTrafficConflicts();
+    StopTrafficReplay();
+    StopTrafficUdp();
+    StopInstructorStream();
+    StopSessionRecording();
+    ReleaseSvsBuffers();
+    XPLMUnregisterDrawCallback(frame_arena_reset_callback, xplm_Phase_Airplanes, 1, NULL);
+    XPLMUnregisterDrawCallback(frame_arena_reset_callback, xplm_Phase_Window, 1, NULL);
+    XPLMUnregisterDrawCallback(draw_airplanes_layers_callback, xplm_Phase_Airplanes, 0, NULL);
+    XPLMUnregisterDrawCallback(draw_window_layers_callback, xplm_Phase_Window, 0, NULL);
+    ReleaseLabelFont();
 }
 
 PLUGIN_API int
 XPluginEnable(void)
 {
-    // Plugin is always enabled successfully
+    // Leave a couple of cores to the sim
+    int workers = (int)std::thread::hardware_concurrency() - 2;
+    g_pool.Start(workers < 1 ? 1 : (workers > 4 ? 4 : workers));
+    XPLMRegisterFlightLoopCallback(worker_results_flight_loop, -1.0f, NULL);
+    BuildSeattleZone();
+
+    // Custom waypoint and zone files reload themselves once loaded from the menu
+    XPLMRegisterFlightLoopCallback(file_watch_flight_loop, g_file_watch_interval_s, NULL);
+
+    // HUD layout, reloaded when its file changes
+    LoadHudLayout();
+
+    // Scratch memory for the draw callbacks is recycled before each phase
+    XPLMRegisterDrawCallback(frame_arena_reset_callback, xplm_Phase_Airplanes, 1, NULL);
+    XPLMRegisterDrawCallback(frame_arena_reset_callback, xplm_Phase_Window, 1, NULL);
+
+    // Terrain probes are spread across sim frames
+    XPLMRegisterFlightLoopCallback(terrain_flight_loop, -1.0f, NULL);
+
+    // DEM tiles for synthetic vision are read and meshed off the sim thread
+    StartSvsTerrain();
+    XPLMRegisterFlightLoopCallback(taws_flight_loop, -1.0f, NULL);
+
+    // Closest point of approach for all traffic, computed on the pool
+    XPLMRegisterFlightLoopCallback(traffic_flight_loop, -1.0f, NULL);
+    XPLMRegisterFlightLoopCallback(trail_flight_loop, -1.0f, NULL);
+
+    // Runway, route and traffic guidance is computed once per frame before drawing
+    XPLMRegisterFlightLoopCallback(guidance_flight_loop, -1.0f, NULL);
+
+    // The HUD layout is compiled for the screen before the frame is drawn
+    XPLMRegisterFlightLoopCallback(hud_layout_flight_loop, -1.0f, NULL);
+
+    // Overlay quality follows measured frame cost
+    XPLMRegisterFlightLoopCallback(governor_flight_loop, -1.0f, NULL);
+
+    // Traffic and waypoint labels are decluttered and drawn after the 3D pass
+    ReserveLabelStorage();
+
+    // All overlays are drawn by one callback per phase, in layer order (see g_airplanes_layers)
+    XPLMRegisterDrawCallback(draw_airplanes_layers_callback, xplm_Phase_Airplanes, 0, NULL);
+    XPLMRegisterDrawCallback(draw_window_layers_callback, xplm_Phase_Window, 0, NULL);
+
+    // Aircraft state, traffic and trails for the UI process, once per sim frame
+    if (OpenTelemetryBus()) {
+        XPLMRegisterFlightLoopCallback(telemetry_flight_loop, -1.0f, NULL);
+    }
     return 1;
 }
 
@@ -228,447 +1233,1788 @@ XPluginReceiveMessage(
     int          inMsg,
     void*        inParam)
 {
-    // Not used in this plugin
+    // A different aircraft may bring its own HUD layout
+    if (inMsg == XPLM_MSG_PLANE_LOADED && (intptr_t)inParam == 0) {
+        LoadHudLayout();
+    }
 }
 
 // ──────────────────────────────────
 // functions
 // ─────────────────────────────────
-// draw seattle city zone
 
-// Draws a 3D volumetric zone with height
-void DrawSeattleZone(
-    const std::vector<std::tuple<double, double, double>>& points, 
-    float base_alt_m = 0.0f, 
-    float top_alt_m = 2000.0f,
-    bool draw_wireframe = true
-) {
-    if (points.size() < 3) return;
-
-    std::vector<std::array<float, 3>> base_points;
-    std::vector<std::array<float, 3>> top_points;
+// ──────────────────────────────────
+// Terrain sampler: cached ground elevation for draping zone floors.
+// The cache is a quadtree over lat/lon; each node holds a small grid of
+// probed elevations. Requests queue coarse parents first, so an
+// approximate answer is available quickly and refined over later frames.
+// Probing happens in a flight loop with a fixed per-frame budget.
+// ──────────────────────────────────
+static const int    g_terrain_node_res   = 9;     // samples per node edge, edges shared with neighbours
+static const double g_terrain_root_deg   = 1.0;   // node size at level 0
+static const int    g_terrain_max_level  = 6;     // 1/64 deg nodes, ~220 m between samples
+static const size_t g_terrain_max_nodes  = 4096;  // ~1.3 MB of samples
+static const int    g_terrain_retry_frames = 600; // re-probe nodes that missed (scenery not loaded yet)
+
+struct TerrainNode {
+    float h[g_terrain_node_res * g_terrain_node_res]; // meters MSL, NAN where the probe missed
+    int   level, ix, iy;
+    int   filled;    // samples probed so far
+    bool  complete;
+    bool  has_miss;
+    int   last_used; // frame counter, for eviction
+    int   done_frame;
+};
 
-    // Convert WGS84 to local coordinates (base and top)
-    for (const auto& pt : points) {
-        double lat = std::get<0>(pt);
-        double lon = std::get<1>(pt);
-        
-        double x_base, y_base, z_base;
-        XPLMWorldToLocal(lat, lon, base_alt_m, &x_base, &y_base, &z_base);
-        base_points.push_back({ (float)x_base, (float)y_base, (float)z_base });
+class TerrainSampler {
+public:
+    TerrainSampler() : m_probe(NULL), m_frame(0) {}
 
-        double x_top, y_top, z_top;
-        XPLMWorldToLocal(lat, lon, top_alt_m, &x_top, &y_top, &z_top);
-        top_points.push_back({ (float)x_top, (float)y_top, (float)z_top });
+    void Shutdown() {
+        if (m_probe) XPLMDestroyProbe(m_probe);
+        m_probe = NULL;
+        m_nodes.clear();
+        m_pending.clear();
     }
 
-    // Enable transparency and depth
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_DEPTH_TEST);
+    // Ground elevation in meters MSL from the finest complete node at or above
+    // 'level'. Returns false until something covering the point has been probed.
+    bool Height(double lat, double lon, int level, float* out_m) {
+        for (int l = level; l >= 0; --l) {
+            double cell = CellDeg(l);
+            int ix = (int)floor(lon / cell);
+            int iy = (int)floor(lat / cell);
+
+            auto it = m_nodes.find(Key(l, ix, iy));
+            if (it == m_nodes.end()) {
+                if (l == level) Request(l, ix, iy);
+                continue;
+            }
+            TerrainNode& node = it->second;
+            node.last_used = m_frame;
+            if (!node.complete) continue;
+            if (node.has_miss && m_frame - node.done_frame > g_terrain_retry_frames) {
+                m_nodes.erase(it);
+                Request(l, ix, iy);
+                continue;
+            }
 
-    // ─── 1. Draw Solid Red Faces ───
-    glColor4f(1.0f, 0.0f, 0.0f, 0.2f);  // Red, semi-transparent
+            // Bilinear interpolation inside the node grid
+            double fx = (lon / cell - ix) * (g_terrain_node_res - 1);
+            double fy = (lat / cell - iy) * (g_terrain_node_res - 1);
+            int x0 = std::min((int)fx, g_terrain_node_res - 2);
+            int y0 = std::min((int)fy, g_terrain_node_res - 2);
+            float tx = (float)(fx - x0), ty = (float)(fy - y0);
+            float h00 = node.h[y0 * g_terrain_node_res + x0];
+            float h10 = node.h[y0 * g_terrain_node_res + x0 + 1];
+            float h01 = node.h[(y0 + 1) * g_terrain_node_res + x0];
+            float h11 = node.h[(y0 + 1) * g_terrain_node_res + x0 + 1];
+            if (std::isnan(h00) || std::isnan(h10) || std::isnan(h01) || std::isnan(h11)) continue;
+
+            *out_m = (h00 * (1 - tx) + h10 * tx) * (1 - ty) + (h01 * (1 - tx) + h11 * tx) * ty;
+            return true;
+        }
+        return false;
+    }
 
-    // Base (polygon)
-    glDisable(GL_CULL_FACE); // Draw both sides of polygons
-    glBegin(GL_POLYGON);
-    for (const auto& p : base_points) glVertex3fv(p.data());
-    glEnd();
+    // Probes up to 'budget' samples of queued nodes
+    void Pump(int budget) {
+        ++m_frame;
+        if (m_pending.empty()) return;
+        if (!m_probe) m_probe = XPLMCreateProbe(xplm_ProbeY);
+
+        while (budget > 0 && !m_pending.empty()) {
+            auto it = m_nodes.find(m_pending.front());
+            if (it == m_nodes.end()) { // evicted before it was finished
+                m_pending.pop_front();
+                continue;
+            }
+            TerrainNode& node = it->second;
+            double cell = CellDeg(node.level);
+            double step = cell / (g_terrain_node_res - 1);
+
+            while (budget > 0 && node.filled < g_terrain_node_res * g_terrain_node_res) {
+                int sx = node.filled % g_terrain_node_res;
+                int sy = node.filled / g_terrain_node_res;
+                float h = ProbeElevation(node.iy * cell + sy * step, node.ix * cell + sx * step);
+                if (std::isnan(h)) node.has_miss = true;
+                node.h[node.filled++] = h;
+                --budget;
+            }
+            if (node.filled == g_terrain_node_res * g_terrain_node_res) {
+                node.complete = true;
+                node.done_frame = m_frame;
+                m_pending.pop_front();
+            }
+        }
+    }
 
-    // Top (polygon, now closed!)
-    glBegin(GL_POLYGON);
-    for (const auto& p : top_points) glVertex3fv(p.data());
-    glEnd();
+private:
+    static double CellDeg(int level) { return g_terrain_root_deg / (double)(1 << level); }
 
-    // Sides (quad strip)
-    glBegin(GL_QUAD_STRIP);
-    for (size_t i = 0; i < base_points.size(); ++i) {
-        glVertex3fv(base_points[i].data());
-        glVertex3fv(top_points[i].data());
+    static unsigned long long Key(int level, int ix, int iy) {
+        return ((unsigned long long)level << 56) |
+               ((unsigned long long)(unsigned)(ix + (1 << 26)) << 28) |
+               (unsigned long long)(unsigned)(iy + (1 << 26));
     }
-    // Close the loop
-    glVertex3fv(base_points[0].data());
-    glVertex3fv(top_points[0].data());
-    glEnd();
 
-    // ─── 2. Optional Wireframe ───
-    if (draw_wireframe) {
-        glColor4f(1.0f, 1.0f, 0.0f, 0.7f);  // Yellow wireframe
-        glLineWidth(2.0f);
+    // Queues a node and any missing parents, coarsest first
+    void Request(int level, int ix, int iy) {
+        for (int l = 0; l <= level; ++l) {
+            int shift = level - l;
+            int pix = ix >> shift, piy = iy >> shift; // arithmetic shift floors negative indices
+            unsigned long long key = Key(l, pix, piy);
+            if (m_nodes.count(key)) continue;
+
+            if (m_nodes.size() >= g_terrain_max_nodes) Evict();
+            TerrainNode& node = m_nodes[key];
+            node.level = l;
+            node.ix = pix;
+            node.iy = piy;
+            node.filled = 0;
+            node.complete = false;
+            node.has_miss = false;
+            node.last_used = m_frame;
+            node.done_frame = 0;
+            m_pending.push_back(key);
+        }
+    }
 
-        // Base outline
-        glBegin(GL_LINE_LOOP);
-        for (const auto& p : base_points) glVertex3fv(p.data());
-        glEnd();
-
-        // Top outline
-        glBegin(GL_LINE_LOOP);
-        for (const auto& p : top_points) glVertex3fv(p.data());
-        glEnd();
+    // Drops the least recently used eighth of the cache. Nodes are often all
+    // used in the same frame, so ties with the cutoff only make up the count.
+    void Evict() {
+        std::vector<int> ages;
+        ages.reserve(m_nodes.size());
+        for (const auto& kv : m_nodes) ages.push_back(kv.second.last_used);
+        size_t n = std::max<size_t>(ages.size() / 8, 1);
+        std::nth_element(ages.begin(), ages.begin() + (n - 1), ages.end());
+        int cutoff = ages[n - 1];
+        size_t erased = 0;
+        for (auto it = m_nodes.begin(); it != m_nodes.end();) {
+            if (it->second.last_used < cutoff) {
+                it = m_nodes.erase(it);
+                ++erased;
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = m_nodes.begin(); it != m_nodes.end() && erased < n;) {
+            if (it->second.last_used == cutoff) {
+                it = m_nodes.erase(it);
+                ++erased;
+            } else {
+                ++it;
+            }
+        }
+    }
 
-        // Vertical connectors
-        glBegin(GL_LINES);
-        for (size_t i = 0; i < base_points.size(); ++i) {
-            glVertex3fv(base_points[i].data());
-            glVertex3fv(top_points[i].data());
+    float ProbeElevation(double lat, double lon) {
+        double x, y, z;
+        XPLMWorldToLocal(lat, lon, 0.0, &x, &y, &z);
+        XPLMProbeInfo_t info;
+        info.structSize = sizeof(info);
+        if (XPLMProbeTerrainXYZ(m_probe, (float)x, (float)y, (float)z, &info) != xplm_ProbeHitTerrain) {
+            return NAN;
         }
-        glEnd();
-        glLineWidth(1.0f);
+        double hit_lat, hit_lon, hit_alt;
+        XPLMLocalToWorld(info.locationX, info.locationY, info.locationZ, &hit_lat, &hit_lon, &hit_alt);
+        return (float)hit_alt;
     }
 
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
-}
+    XPLMProbeRef m_probe;
+    int m_frame;
+    std::unordered_map<unsigned long long, TerrainNode> m_nodes;
+    std::deque<unsigned long long> m_pending;
+};
 
-// runway distance calculation
-double haversine_m(double lat1, double lon1, double lat2, double lon2) {
-        const double R = 6371000.0; // Earth radius in meters
-        double dLat = (lat2 - lat1) * M_PI / 180.0;
-        double dLon = (lon2 - lon1) * M_PI / 180.0;
-        double a = sin(dLat/2) * sin(dLat/2) +
-                cos(lat1 * M_PI / 180.0) * cos(lat2 * M_PI / 180.0) *
-                sin(dLon/2) * sin(dLon/2);
-        double c = 2 * atan2(sqrt(a), sqrt(1-a));
-        return R * c;
-}
+static TerrainSampler g_terrain;
 
-// function for drawing boxes
-// direction: 0 = dot (circle, green), 1 = up arrow (blue), -1 = down arrow (red)
-void DrawLandingBox(
-    float box_x, float box_y, float box_z,
-    float box_w, float box_h,
-    int direction,
-    float next_box_x, float next_box_y, float next_box_z,
-    float heading_to_next // in degrees
-)
+static void ShutdownTerrainSampler()
 {
-    // Set box color based on direction
-    if (direction == 0) {
-        glColor4f(0.0f, 1.0f, 0.0f, 1.0f); // Green
-    } else if (direction == 1) {
-        glColor4f(0.2f, 0.5f, 1.0f, 1.0f); // Blue
-    } else if (direction == -1) {
-        glColor4f(1.0f, 0.2f, 0.2f, 1.0f); // Red
-    } else {
-        glColor4f(1.0f, 1.0f, 0.0f, 1.0f); // Default Yellow
-    }
+    g_terrain.Shutdown();
+}
 
-    glLineWidth(3.0f);
-    glBegin(GL_LINE_LOOP);
-        glVertex3f((float)(box_x - box_w/2), (float)(box_y - box_h/2), (float)box_z);
-        glVertex3f((float)(box_x + box_w/2), (float)(box_y - box_h/2), (float)box_z);
-        glVertex3f((float)(box_x + box_w/2), (float)(box_y + box_h/2), (float)box_z);
-        glVertex3f((float)(box_x - box_w/2), (float)(box_y + box_h/2), (float)box_z);
-    glEnd();
-    glLineWidth(1.0f);
+static float terrain_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    g_terrain.Pump(g_terrain_probe_budget);
+    return -1.0f; // every frame
+}
 
-    float cx = box_x;
-    float cy = box_y;
-    float cz = box_z;
-    float sym_size = box_h * 0.4f;
+// ──────────────────────────────────
+// Synthetic vision terrain
+// DEM tiles (SRTM .hgt, 1x1 degree) are loaded from disk and meshed on a
+// background thread. Each tile is split into chunks drawn at one of a few
+// grid resolutions picked by distance (geomipmapping, skirts hide cracks
+// between levels). Meshes live in vertex buffers held in an LRU cache
+// bounded by g_svs_gpu_budget_bytes.
+// ──────────────────────────────────
+static double g_svs_range_m   = 40000.0;             // terrain drawn out to this distance
+static size_t g_svs_gpu_budget_bytes = 64u << 20;     // vertex buffer memory
+static int    g_svs_uploads_per_frame = 6;           // buffer uploads allowed per frame
+static const int g_svs_chunks_per_side = 16;         // chunks per tile edge
+static const int g_svs_lod_count = 4;
+static const int g_svs_lod_grid[g_svs_lod_count] = { 32, 16, 8, 4 };            // quads per chunk edge
+static const double g_svs_lod_dist_m[g_svs_lod_count] = { 4000.0, 10000.0, 20000.0, 1e12 };
+static const float g_svs_skirt_m = 60.0f;
+
+// One SRTM tile, immutable once loaded
+struct DemTile {
+    int lat0, lon0; // south west corner
+    int n;          // samples per edge (1201 or 3601)
+    std::vector<short> h; // row 0 is the northern edge, as in the file
+
+    // Max-elevation pyramid for terrain awareness. Level 0 has one cell per
+    // 2x2 samples, each further level halves the resolution down to 1x1.
+    std::vector<std::vector<short>> max_levels;
+    std::vector<int> level_dims;
+
+    // Elevation in meters at sample column ix (east) and row iy (north of the south edge)
+    float Sample(int ix, int iy) const {
+        short v = h[(size_t)(n - 1 - iy) * n + ix];
+        return v == -32768 ? 0.0f : (float)v; // voids as sea level
+    }
 
-    // Draw up/down arrow above/below box
-    if (direction == 1) {
-        // Up arrow above box (blue)
-        glColor4f(0.2f, 0.5f, 1.0f, 1.0f);
-        float ay = cy + box_h/2 + sym_size * 0.7f;
-        glBegin(GL_TRIANGLES);
-            glVertex3f(cx, ay + sym_size * 0.5f, cz);
-            glVertex3f(cx - sym_size * 0.4f, ay - sym_size * 0.3f, cz);
-            glVertex3f(cx + sym_size * 0.4f, ay - sym_size * 0.3f, cz);
-        glEnd();
-    } else if (direction == -1) {
-        // Down arrow below box (red)
-        glColor4f(1.0f, 0.2f, 0.2f, 1.0f);
-        float ay = cy - box_h/2 - sym_size * 0.7f;
-        glBegin(GL_TRIANGLES);
-            glVertex3f(cx, ay - sym_size * 0.5f, cz);
-            glVertex3f(cx - sym_size * 0.4f, ay + sym_size * 0.3f, cz);
-            glVertex3f(cx + sym_size * 0.4f, ay + sym_size * 0.3f, cz);
-        glEnd();
+    // Bilinear elevation at a point inside the tile
+    float Elevation(double lat, double lon) const {
+        double fx = (lon - lon0) * (n - 1);
+        double fy = (lat - lat0) * (n - 1);
+        int x0 = std::max(0, std::min((int)fx, n - 2));
+        int y0 = std::max(0, std::min((int)fy, n - 2));
+        float tx = (float)(fx - x0), ty = (float)(fy - y0);
+        return (Sample(x0, y0) * (1 - tx) + Sample(x0 + 1, y0) * tx) * (1 - ty) +
+               (Sample(x0, y0 + 1) * (1 - tx) + Sample(x0 + 1, y0 + 1) * tx) * ty;
     }
 
-    // Draw left/right arrow beside box, pointing to next box
-    if (next_box_x != box_x || next_box_y != box_y) {
-        float dx = next_box_x - box_x;
-        float dy = next_box_y - box_y;
-        // If mostly to the right, draw right arrow; if mostly to the left, draw left arrow
-        if (fabs(dx) > fabs(dy)) {
-            if (dx > 0) {
-                // Right arrow
-                glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
-                float ax = cx + box_w/2 + sym_size * 0.7f;
-                glBegin(GL_TRIANGLES);
-                    glVertex3f(ax + sym_size * 0.5f, cy, cz);
-                    glVertex3f(ax - sym_size * 0.3f, cy - sym_size * 0.4f, cz);
-                    glVertex3f(ax - sym_size * 0.3f, cy + sym_size * 0.4f, cz);
-                glEnd();
-            } else {
-                // Left arrow
-                glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
-                float ax = cx - box_w/2 - sym_size * 0.7f;
-                glBegin(GL_TRIANGLES);
-                    glVertex3f(ax - sym_size * 0.5f, cy, cz);
-                    glVertex3f(ax + sym_size * 0.3f, cy - sym_size * 0.4f, cz);
-                    glVertex3f(ax + sym_size * 0.3f, cy + sym_size * 0.4f, cz);
-                glEnd();
+    void BuildMaxPyramid() {
+        int d = n - 1;
+        std::vector<short> level((size_t)d * d);
+        for (int cj = 0; cj < d; ++cj) {
+            for (int ci = 0; ci < d; ++ci) {
+                float m = std::max(std::max(Sample(ci, cj), Sample(ci + 1, cj)),
+                                   std::max(Sample(ci, cj + 1), Sample(ci + 1, cj + 1)));
+                level[(size_t)cj * d + ci] = (short)m;
+            }
+        }
+        max_levels.push_back(std::move(level));
+        level_dims.push_back(d);
+
+        while (d > 1) {
+            int pd = d;
+            d = (d + 1) / 2;
+            const std::vector<short>& prev = max_levels.back();
+            std::vector<short> next((size_t)d * d);
+            for (int cj = 0; cj < d; ++cj) {
+                for (int ci = 0; ci < d; ++ci) {
+                    short m = -32768;
+                    for (int k = 0; k < 4; ++k) {
+                        int pi = ci * 2 + (k & 1), pj = cj * 2 + (k >> 1);
+                        if (pi < pd && pj < pd) m = std::max(m, prev[(size_t)pj * pd + pi]);
+                    }
+                    next[(size_t)cj * d + ci] = m;
+                }
             }
+            max_levels.push_back(std::move(next));
+            level_dims.push_back(d);
         }
     }
 
-    // Draw heading in center of box
-    char heading_buf[16];
-    snprintf(heading_buf, sizeof(heading_buf), "%.0f", heading_to_next);
-    // You may want to use your DrawTextWithShadow here for better visibility
-    // For 3D text, you need a 3D text drawing function; for now, this is a placeholder:
-    // Draw3DText(cx, cy, cz, heading_buf);
-}
-
-// Function to load custom zone points from a file
-bool LoadCustomZonePoints(const char* filename) {
-    g_custom_zone_points.clear();
-    std::ifstream infile(filename);
-    if (!infile) {
-        strcpy(g_zone_status, "Zone file not found");
-        return false;
-    }
-    double lat, lon, alt;
-    while (infile >> lat >> lon >> alt) {
-        g_custom_zone_points.emplace_back(lat, lon, alt);
-    }
-    if (g_custom_zone_points.size() < 3) {
-        strcpy(g_zone_status, "Too few zone points");
+    // True if any terrain inside the lat/lon box reaches threshold_m. Starts at
+    // the coarsest level where the box spans a couple of cells and only refines
+    // cells whose max is above the threshold.
+    bool ExceedsInBox(double lat_s, double lat_n, double lon_w, double lon_e, float threshold_m) const {
+        double x0 = (std::max(lon_w, (double)lon0) - lon0) * (n - 1);
+        double x1 = (std::min(lon_e, (double)lon0 + 1) - lon0) * (n - 1);
+        double y0 = (std::max(lat_s, (double)lat0) - lat0) * (n - 1);
+        double y1 = (std::min(lat_n, (double)lat0 + 1) - lat0) * (n - 1);
+        if (x1 < x0 || y1 < y0) return false;
+
+        int level = 0;
+        double span = std::max(x1 - x0, y1 - y0);
+        while (level + 1 < (int)max_levels.size() && (double)(1 << (level + 1)) <= span) ++level;
+
+        int d = level_dims[level];
+        int cell = 1 << level;
+        int ci0 = std::min((int)x0 / cell, d - 1), ci1 = std::min((int)x1 / cell, d - 1);
+        int cj0 = std::min((int)y0 / cell, d - 1), cj1 = std::min((int)y1 / cell, d - 1);
+        for (int cj = cj0; cj <= cj1; ++cj) {
+            for (int ci = ci0; ci <= ci1; ++ci) {
+                if (CellExceeds(level, ci, cj, x0, x1, y0, y1, threshold_m)) return true;
+            }
+        }
         return false;
     }
-    strcpy(g_zone_status, "Zone loaded");
-    return true;
-}
 
-// ──────────────────────────────────
-// Menu handler: handles menu item selections
-// ──────────────────────────────────
+private:
+    bool CellExceeds(int level, int ci, int cj, double x0, double x1, double y0, double y1, float threshold_m) const {
+        int d = level_dims[level];
+        if (ci >= d || cj >= d) return false;
+        if (max_levels[level][(size_t)cj * d + ci] < threshold_m) return false;
 
-//callbacks
-static float draw_hud_callback(XPLMDrawingPhase, int, void*);
-static float draw_landing_assist_callback(XPLMDrawingPhase, int, void*);
-static float draw_seattle_to_kelowna_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon);
-// Update your callback to call DrawSeattleZone with your desired points:
-static float draw_seattle_zone_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon) {
-    if (!g_zones_visible) return 1.0f;
-
-    // Define zone boundaries (latitude, longitude, unused altitude)
-    std::vector<std::tuple<double, double, double>> seattle_zone = {
-        {47.591114, -122.341964, 0},  // NW
-        {47.591565, -122.286117, 0},  // NE
-        {47.642684, -122.278412, 0},  // SE
-        {47.663445, -122.431298, 0},  // SW
-        {47.630000, -122.400000, 0}   
-    };
+        // Cell extent in level 0 units, skip if outside the box
+        int cell = 1 << level;
+        if ((ci + 1) * cell < x0 || ci * cell > x1 || (cj + 1) * cell < y0 || cj * cell > y1) return false;
+        if (level == 0) return true;
 
-    // Draw from 0m to 2500m altitude
-    DrawSeattleZone(seattle_zone, 0.0f, 2500.0f, true);
+        for (int k = 0; k < 4; ++k) {
+            if (CellExceeds(level - 1, ci * 2 + (k & 1), cj * 2 + (k >> 1), x0, x1, y0, y1, threshold_m)) return true;
+        }
+        return false;
+    }
+};
 
-    return 1.0f;
-}
+static int DemTileKey(int lat0, int lon0) { return (lat0 + 90) * 360 + (lon0 + 180); }
 
-// Callback for drawing the custom zone
-static float draw_custom_zone_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon) {
-    if (!g_zones_visible || g_custom_zone_points.size() < 3) return 1.0f;
-    // Draw from lowest to highest alt in file, or use fixed values if you want
-    float base_alt = std::get<2>(g_custom_zone_points[0]);
-    float top_alt = base_alt + 2500.0f;
-    DrawSeattleZone(g_custom_zone_points, base_alt, top_alt, true);
-    return 1.0f;
+// Directory holding the .hgt files, e.g. <X-Plane>/Resources/plugins/svs_dem/N47W123.hgt
+static std::string DemDirectory()
+{
+    char sys_path[512];
+    XPLMGetSystemPath(sys_path);
+    const char* sep = XPLMGetDirectorySeparator();
+    return std::string(sys_path) + "Resources" + sep + "plugins" + sep + "svs_dem" + sep;
 }
 
-static void
-menu_handler(
-    void* in_menu_ref,
-    void* in_item_ref)
+// Reads a big-endian SRTM tile, NULL if missing or malformed
+static std::shared_ptr<const DemTile> LoadDemTile(const std::string& dir, int lat0, int lon0)
 {
-    const char* item = (const char*)in_item_ref;
+    char name[32];
+    snprintf(name, sizeof(name), "%c%02d%c%03d.hgt",
+        lat0 >= 0 ? 'N' : 'S', abs(lat0), lon0 >= 0 ? 'E' : 'W', abs(lon0));
+
+    std::ifstream in(dir + name, std::ios::binary | std::ios::ate);
+    if (!in) return NULL;
+    std::streamoff bytes = in.tellg();
+    int n = 0;
+    if (bytes == 1201LL * 1201 * 2) n = 1201;
+    else if (bytes == 3601LL * 3601 * 2) n = 3601;
+    else return NULL;
+
+    std::shared_ptr<DemTile> tile = std::make_shared<DemTile>();
+    tile->lat0 = lat0;
+    tile->lon0 = lon0;
+    tile->n = n;
+    tile->h.resize((size_t)n * n);
+    in.seekg(0);
+    in.read((char*)tile->h.data(), bytes);
+    if (!in) return NULL;
+    for (short& v : tile->h) {
+        unsigned short u = (unsigned short)v;
+        v = (short)((u >> 8) | (u << 8));
+    }
+    tile->BuildMaxPyramid();
+    return tile;
+}
 
-    if (!strcmp(item, "Menu Item 2")) {
-        XPLMCommandOnce(XPLMFindCommand("sim/operation/toggle_key_shortcuts_window"));
+// u, v are the position inside the chunk (0..1 east, 0..1 north), h is meters MSL
+struct SvsVertex {
+    float u, h, v;
+    unsigned char rgba[4];
+};
+
+// Elevation color ramp for the shaded mode
+static void SvsColor(float h, unsigned char rgba[4])
+{
+    static const float stops[][4] = {
+        {    0.0f, 0.10f, 0.35f, 0.10f },
+        {  600.0f, 0.35f, 0.55f, 0.15f },
+        { 1500.0f, 0.55f, 0.45f, 0.25f },
+        { 2500.0f, 0.60f, 0.55f, 0.50f },
+        { 4000.0f, 0.95f, 0.95f, 0.95f },
+    };
+    const int count = sizeof(stops) / sizeof(stops[0]);
+    int i = 0;
+    while (i < count - 2 && h > stops[i + 1][0]) ++i;
+    float t = (h - stops[i][0]) / (stops[i + 1][0] - stops[i][0]);
+    t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    for (int c = 0; c < 3; ++c) {
+        rgba[c] = (unsigned char)(255.0f * (stops[i][c + 1] + (stops[i + 1][c + 1] - stops[i][c + 1]) * t));
     }
-    else if (!strcmp(item, "HUD Item")) {
-        // Toggle HUD visibility on/off
-        g_hud_visible = !g_hud_visible;
+    rgba[3] = 255;
+}
 
-        if (g_hud_visible) {
-            XPLMRegisterDrawCallback(
-                (XPLMDrawCallback_f)draw_hud_callback,
-                xplm_Phase_Window, // note  xplm_Phase_Window for HUD and xplm_Phase_Airplanes for landing line
-                0,
-                NULL);
-        }
-        else {
-            XPLMUnregisterDrawCallback(
-                (XPLMDrawCallback_f)draw_hud_callback,
-                xplm_Phase_Window, // note
-                0,
-                NULL);
+// Grid vertices first, then one skirt vertex below each edge vertex
+// (south, north, west, east edges in that order)
+static void BuildSvsChunkMesh(const DemTile& tile, int chunk, int lod, std::vector<SvsVertex>& out)
+{
+    int g = g_svs_lod_grid[lod];
+    int cx = chunk % g_svs_chunks_per_side;
+    int cy = chunk / g_svs_chunks_per_side;
+    int span = (tile.n - 1) / g_svs_chunks_per_side; // samples per chunk edge
+    out.clear();
+    out.reserve((g + 1) * (g + 1) + 4 * (g + 1));
+
+    for (int j = 0; j <= g; ++j) {
+        for (int i = 0; i <= g; ++i) {
+            int sx = cx * span + (i * span + g / 2) / g;
+            int sy = cy * span + (j * span + g / 2) / g;
+            SvsVertex vtx;
+            vtx.u = (float)i / g;
+            vtx.v = (float)j / g;
+            vtx.h = tile.Sample(sx, sy);
+            SvsColor(vtx.h, vtx.rgba);
+            out.push_back(vtx);
         }
     }
-    else if (!strcmp(item, "Landing Assist Item")) 
-    {
-        g_landing_assist_visible = !g_landing_assist_visible;
-        radout_init_set = false; // <-- Reset so it will capture new value next time
-        if (g_landing_assist_visible) {
-            XPLMRegisterDrawCallback(
-                (XPLMDrawCallback_f)draw_landing_assist_callback,
-                xplm_Phase_Airplanes, // 3D world
-                0,
-                NULL);
-        } else {
-            XPLMUnregisterDrawCallback(
-                (XPLMDrawCallback_f)draw_landing_assist_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
+    for (int edge = 0; edge < 4; ++edge) {
+        for (int k = 0; k <= g; ++k) {
+            int i = edge < 2 ? k : (edge == 2 ? 0 : g);
+            int j = edge < 2 ? (edge == 0 ? 0 : g) : k;
+            SvsVertex vtx = out[j * (g + 1) + i];
+            vtx.h -= g_svs_skirt_m;
+            out.push_back(vtx);
         }
     }
-    else if(!strcmp(item, "S to K"))
-    {
-        g_seattle_to_kelowna_visible = !g_seattle_to_kelowna_visible;
-        if (g_seattle_to_kelowna_visible) {
-            XPLMRegisterDrawCallback(
-                (XPLMDrawCallback_f)draw_seattle_to_kelowna_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
-        } else {
-            XPLMUnregisterDrawCallback(
-                (XPLMDrawCallback_f)draw_seattle_to_kelowna_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
-        }
+}
+
+// A finished chunk mesh waiting for upload
+struct SvsMesh {
+    unsigned long long key;
+    unsigned gen;     // request it answers, see g_svs_in_flight
+    std::shared_ptr<std::vector<SvsVertex>> verts;
+};
+
+// DEM tiles resident for synthetic vision and terrain awareness
+struct DemTileSlot {
+    std::shared_ptr<const DemTile> tile;
+    bool requested;
+    bool missing;
+    int  last_used;
+    unsigned gen;     // load it is waiting for, a slot forgotten and requested again gets a new one
+};
+
+// Resident chunks are also linked in use order, most recent at the head.
+// The map never moves its values, so the links stay valid until erase.
+struct SvsGpuChunk {
+    GLuint vbo;
+    size_t bytes;
+    unsigned long long key;
+    SvsGpuChunk* lru_prev;
+    SvsGpuChunk* lru_next;
+    // Chunk to local OpenGL transform, recomputed when X-Plane moves its local origin
+    double xform[16];
+    int    xform_epoch;
+};
+
+static std::string g_dem_dir;
+static std::map<int, DemTileSlot> g_dem_tiles;
+static int g_dem_frame = 0;
+static std::deque<SvsMesh> g_svs_ready; // meshes built by the pool, uploaded by the draw callback
+static std::unordered_map<unsigned long long, SvsGpuChunk> g_svs_gpu;
+static std::unordered_map<unsigned long long, unsigned> g_svs_in_flight; // key -> request generation
+static unsigned g_svs_request_gen = 0;
+static unsigned g_dem_slot_gen = 0;
+static SvsGpuChunk* g_svs_lru_head = NULL;
+static SvsGpuChunk* g_svs_lru_tail = NULL;
+static size_t g_svs_gpu_bytes = 0;
+static GLuint g_svs_index_buffers[g_svs_lod_count] = { 0 };
+static int    g_svs_index_counts[g_svs_lod_count] = { 0 };      // grid and skirts
+static int    g_svs_grid_index_counts[g_svs_lod_count] = { 0 }; // grid only, for wireframe
+static int    g_svs_local_epoch = 0;
+
+// Bumped whenever X-Plane moves its local OpenGL origin, anything cached in
+// local coordinates has to be redone then. Draw callbacks only.
+static int LocalOriginEpoch()
+{
+    static double last_probe[3] = { 0.0, 0.0, 0.0 };
+    static int epoch = 0;
+    double probe[3];
+    XPLMWorldToLocal(47.0, -122.0, 0.0, &probe[0], &probe[1], &probe[2]);
+    if (probe[0] != last_probe[0] || probe[1] != last_probe[1] || probe[2] != last_probe[2]) {
+        memcpy(last_probe, probe, sizeof(probe));
+        ++epoch;
     }
-    else if(!strcmp(item, "Zones"))
-    {
-        g_zones_visible = !g_zones_visible;
-        if (g_zones_visible) {
-            XPLMRegisterDrawCallback(
-                (XPLMDrawCallback_f)draw_seattle_zone_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
-        } else {
-            XPLMUnregisterDrawCallback(
-                (XPLMDrawCallback_f)draw_seattle_zone_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
+    return epoch;
+}
+
+static unsigned long long SvsChunkKey(int tile_key, int chunk, int lod)
+{
+    return ((unsigned long long)tile_key << 16) | ((unsigned long long)chunk << 4) | (unsigned long long)lod;
+}
+
+// Index buffers are shared by every chunk drawn at the same level
+static void BuildSvsIndexBuffers()
+{
+    for (int lod = 0; lod < g_svs_lod_count; ++lod) {
+        int g = g_svs_lod_grid[lod];
+        int row = g + 1;
+        int skirt0 = row * row;
+        std::vector<unsigned short> idx;
+        for (int j = 0; j < g; ++j) {
+            for (int i = 0; i < g; ++i) {
+                unsigned short a = (unsigned short)(j * row + i);
+                unsigned short b = (unsigned short)(a + 1);
+                unsigned short c = (unsigned short)(a + row);
+                unsigned short d = (unsigned short)(c + 1);
+                idx.insert(idx.end(), { a, b, d, a, d, c });
+            }
         }
-    }
-    else if (!strcmp(item, "Load Custom Waypoints")) {
-        // if (LoadCustomWaypoints("C:\\X-Plane 11\\Resources\\plugins\\custom_waypoints.txt")) {
-        if (LoadCustomWaypoints("C:\\Users\\fsr_v\\Desktop\\X-Plane 11\\Resources\\plugins\\custom_waypoints.txt")) {
-            XPLMDebugString("Custom waypoints loaded successfully.\n");
-            strcpy(g_waypoint_status, "Loaded");
-        } else {
-            XPLMDebugString("Failed to load custom waypoints.\n");
-            strcpy(g_waypoint_status, "Failed");
+        g_svs_grid_index_counts[lod] = (int)idx.size();
+        for (int edge = 0; edge < 4; ++edge) {
+            for (int k = 0; k < g; ++k) {
+                int i0 = edge < 2 ? k : (edge == 2 ? 0 : g);
+                int j0 = edge < 2 ? (edge == 0 ? 0 : g) : k;
+                int i1 = edge < 2 ? k + 1 : i0;
+                int j1 = edge < 2 ? j0 : k + 1;
+                unsigned short top0 = (unsigned short)(j0 * row + i0);
+                unsigned short top1 = (unsigned short)(j1 * row + i1);
+                unsigned short bot0 = (unsigned short)(skirt0 + edge * row + k);
+                unsigned short bot1 = (unsigned short)(bot0 + 1);
+                idx.insert(idx.end(), { top0, top1, bot1, top0, bot1, bot0 });
+            }
         }
+        g_svs_index_counts[lod] = (int)idx.size();
+
+        p_glGenBuffers(1, &g_svs_index_buffers[lod]);
+        p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_svs_index_buffers[lod]);
+        p_glBufferData(GL_ELEMENT_ARRAY_BUFFER, (ptrdiff_t)(idx.size() * sizeof(unsigned short)), idx.data(), GL_STATIC_DRAW);
     }
-    else if (!strcmp(item, "Show Custom Waypoints")) {
-        g_custom_waypoints_visible = !g_custom_waypoints_visible;
-        if (g_custom_waypoints_visible) {
-            XPLMRegisterDrawCallback(
-                (XPLMDrawCallback_f)draw_custom_waypoints_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
-        } else {
-            XPLMUnregisterDrawCallback(
-                (XPLMDrawCallback_f)draw_custom_waypoints_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
-        }
+    p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+static void UnlinkSvsChunk(SvsGpuChunk& c)
+{
+    if (c.lru_prev) c.lru_prev->lru_next = c.lru_next;
+    else g_svs_lru_head = c.lru_next;
+    if (c.lru_next) c.lru_next->lru_prev = c.lru_prev;
+    else g_svs_lru_tail = c.lru_prev;
+    c.lru_prev = c.lru_next = NULL;
+}
+
+static void TouchSvsChunk(SvsGpuChunk& c)
+{
+    if (g_svs_lru_head == &c) return;
+    if (c.lru_prev) UnlinkSvsChunk(c); // linked and not the head
+    c.lru_next = g_svs_lru_head;
+    if (g_svs_lru_head) g_svs_lru_head->lru_prev = &c;
+    g_svs_lru_head = &c;
+    if (!g_svs_lru_tail) g_svs_lru_tail = &c;
+}
+
+// Drops least recently used chunk buffers until under budget
+static void EvictSvsChunks()
+{
+    while (g_svs_gpu_bytes > g_svs_gpu_budget_bytes && g_svs_lru_tail) {
+        SvsGpuChunk& oldest = *g_svs_lru_tail;
+        UnlinkSvsChunk(oldest);
+        p_glDeleteBuffers(1, &oldest.vbo);
+        g_svs_gpu_bytes -= oldest.bytes;
+        g_svs_gpu.erase(oldest.key);
     }
-    else if (!strcmp(item, "Toggle Aircraft Highlight")) {
-        g_aircraft_highlight_visible = !g_aircraft_highlight_visible;
-        
-        if (g_aircraft_highlight_visible) {
-            XPLMRegisterDrawCallback(
-                draw_aircraft_highlight_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL
-            );
-        } else {
-            XPLMUnregisterDrawCallback(
-                draw_aircraft_highlight_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL
-            );
-        }
-        
+}
+
+// Returns the tile covering lat0/lon0 if resident, queueing its load otherwise
+static std::shared_ptr<const DemTile> RequestDemTile(int lat0, int lon0)
+{
+    int tile_key = DemTileKey(lat0, lon0);
+    DemTileSlot& slot = g_dem_tiles[tile_key];
+    slot.last_used = g_dem_frame;
+    if (!slot.requested) {
+        slot.requested = true;
+        unsigned gen = slot.gen = ++g_dem_slot_gen;
+        std::string dir = g_dem_dir;
+        auto loaded = std::make_shared<std::shared_ptr<const DemTile>>();
+        g_pool.Submit(
+            [dir, lat0, lon0, loaded] { *loaded = LoadDemTile(dir, lat0, lon0); },
+            [tile_key, gen, loaded] {
+                auto it = g_dem_tiles.find(tile_key);
+                if (it == g_dem_tiles.end() || it->second.gen != gen) return; // no longer wanted
+                it->second.tile = *loaded;
+                it->second.missing = !*loaded;
+            });
     }
-    else if (!strcmp(item, "Load Custom Zone")) {
-        // "C:\\X-Plane 11\\Resources\\plugins\\custom_zones.txt"
-        // "C:\\Users\\fsr_v\\Desktop\\X-Plane 11\\Resources\\plugins\\custom_zone.txt"
-        if (LoadCustomZonePoints("C:\\Users\\fsr_v\\Desktop\\X-Plane 11\\Resources\\plugins\\custom_zones.txt")) {
-            XPLMDebugString("Custom zone loaded successfully.\n");
-        } else {
-            XPLMDebugString("Failed to load custom zone.\n");
-        }
+    return slot.tile;
+}
+
+// Called once per sim frame: forgets tiles nobody used for a while
+static void PumpDemTiles()
+{
+    ++g_dem_frame;
+    for (auto it = g_dem_tiles.begin(); it != g_dem_tiles.end();) {
+        if (g_dem_frame - it->second.last_used > 600) it = g_dem_tiles.erase(it);
+        else ++it;
     }
-    else if (!strcmp(item, "Show Custom Zone")) {
-        g_zones_visible = !g_zones_visible;
-        if (g_zones_visible) {
-            XPLMRegisterDrawCallback(
-                (XPLMDrawCallback_f)draw_custom_zone_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
-        } else {
-            XPLMUnregisterDrawCallback(
-                (XPLMDrawCallback_f)draw_custom_zone_callback,
-                xplm_Phase_Airplanes,
-                0,
-                NULL);
-        }
+}
+
+// Uploads a few finished chunk meshes
+static void DrainSvsResults()
+{
+    int uploads = 0;
+    while (uploads < g_svs_uploads_per_frame && !g_svs_ready.empty()) {
+        SvsMesh mesh = std::move(g_svs_ready.front());
+        g_svs_ready.pop_front();
+        unsigned long long key = mesh.key;
+        // Requests dropped since (buffers released, terrain stopped) are not uploaded
+        auto req = g_svs_in_flight.find(key);
+        if (req == g_svs_in_flight.end() || req->second != mesh.gen) continue;
+        g_svs_in_flight.erase(req);
+        if (g_svs_gpu.count(key)) continue;
+
+        SvsGpuChunk& chunk = g_svs_gpu[key];
+        chunk.bytes = mesh.verts->size() * sizeof(SvsVertex);
+        chunk.key = key;
+        chunk.lru_prev = chunk.lru_next = NULL;
+        chunk.xform_epoch = -1;
+        p_glGenBuffers(1, &chunk.vbo);
+        p_glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        p_glBufferData(GL_ARRAY_BUFFER, (ptrdiff_t)chunk.bytes, mesh.verts->data(), GL_STATIC_DRAW);
+        TouchSvsChunk(chunk);
+        g_svs_gpu_bytes += chunk.bytes;
+        ++uploads;
     }
+    p_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    EvictSvsChunks();
+}
 
-    
+// Maps chunk space (u east 0..1, h meters, v north 0..1) to local OpenGL coordinates
+static void SvsChunkTransform(double lat_s, double lon_w, double size_deg, double m[16])
+{
+    double o[3], e[3], n[3], up[3];
+    XPLMWorldToLocal(lat_s, lon_w, 0.0, &o[0], &o[1], &o[2]);
+    XPLMWorldToLocal(lat_s, lon_w + size_deg, 0.0, &e[0], &e[1], &e[2]);
+    XPLMWorldToLocal(lat_s + size_deg, lon_w, 0.0, &n[0], &n[1], &n[2]);
+    XPLMWorldToLocal(lat_s, lon_w, 1000.0, &up[0], &up[1], &up[2]);
+    for (int r = 0; r < 3; ++r) {
+        m[0 + r]  = e[r] - o[r];            // u column
+        m[4 + r]  = (up[r] - o[r]) / 1000.0; // h column
+        m[8 + r]  = n[r] - o[r];            // v column
+        m[12 + r] = o[r];
+    }
+    m[3] = m[7] = m[11] = 0.0;
+    m[15] = 1.0;
 }
-// ──────────────────────────────────
-// Draw HUD callback: draws the HUD elements every frame
-// ──────────────────────────────────
 
-// ──────────────────────────────
-// for drawing CAT III Runway Edge Lines for KSEA 16L/34R
-// ──────────────────────────────
-static float draw_landing_assist_callback(
-    XPLMDrawingPhase inPhase,
-    int inIsBefore,
-    void* inRefcon)
+static void ReleaseSvsBuffers()
 {
-    if (!g_landing_assist_visible) return 1.0f;
+    if (!g_gl_vbo_ok) return;
+    for (auto& kv : g_svs_gpu) p_glDeleteBuffers(1, &kv.second.vbo);
+    g_svs_gpu.clear();
+    g_svs_lru_head = g_svs_lru_tail = NULL;
+    g_svs_gpu_bytes = 0;
+    g_svs_in_flight.clear();
+    for (int lod = 0; lod < g_svs_lod_count; ++lod) {
+        if (g_svs_index_buffers[lod]) p_glDeleteBuffers(1, &g_svs_index_buffers[lod]);
+        g_svs_index_buffers[lod] = 0;
+    }
+}
 
-    {
-        // KSEA 16L/34R endpoints (approximate, WGS84)
-        // 16L: 47.4502, -122.3088
-        // 34R: 47.4180, -122.3088
-        // Runway width: 150 ft = 45.72 m
+static void StartSvsTerrain()
+{
+    g_dem_dir = DemDirectory();
+}
 
-        // double lat1 = 47.4602, lon1 = -122.3076; // North end, redudent
-        // double lat2 = 47.4280, lon2 = -122.3076; // South end, redundant
-        // float elev = 410.0f; // Approx field elevation in feet
+// Call after the pool has stopped, pending loads will never complete
+static void StopSvsTerrain()
+{
+    g_dem_tiles.clear();
+    g_svs_ready.clear();
+    g_svs_in_flight.clear();
+}
 
-        // Convert feet to meters for XPLMWorldToLocal
-        float elev_m = elev * 0.3048f;
+static void DrawSvsTerrainLayer()
+{
+    if (!GLHasVertexBuffers()) return;
+    if (!g_svs_index_buffers[0]) BuildSvsIndexBuffers();
+
+    // X-Plane occasionally moves the local origin, chunk transforms then need rebuilding
+    g_svs_local_epoch = LocalOriginEpoch();
+
+    DrainSvsResults();
+
+    double ac_lat = XPLMGetDatad(XPLMFindDataRef("sim/flightmodel/position/latitude"));
+    double ac_lon = XPLMGetDatad(XPLMFindDataRef("sim/flightmodel/position/longitude"));
+    double m_per_deg_lat = 111320.0;
+    double m_per_deg_lon = 111320.0 * cos(ac_lat * M_PI / 180.0);
+    double range_lat = g_svs_range_m / m_per_deg_lat;
+    double range_lon = g_svs_range_m / m_per_deg_lon;
+
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glEnable(GL_POLYGON_OFFSET_LINE);
+    glPolygonOffset(-1.0f, -4.0f);
+    glPolygonMode(GL_FRONT_AND_BACK, g_svs_wireframe ? GL_LINE : GL_FILL);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    if (g_svs_wireframe) glColor4f(0.0f, 1.0f, 0.0f, 0.5f);
+    else glEnableClientState(GL_COLOR_ARRAY);
+    glMatrixMode(GL_MODELVIEW);
+
+    for (int lat0 = (int)floor(ac_lat - range_lat); lat0 <= (int)floor(ac_lat + range_lat); ++lat0) {
+        for (int lon0 = (int)floor(ac_lon - range_lon); lon0 <= (int)floor(ac_lon + range_lon); ++lon0) {
+            int tile_key = DemTileKey(lat0, lon0);
+            std::shared_ptr<const DemTile> tile = RequestDemTile(lat0, lon0);
+            if (!tile) continue;
+
+            double chunk_deg = 1.0 / g_svs_chunks_per_side;
+            for (int chunk = 0; chunk < g_svs_chunks_per_side * g_svs_chunks_per_side; ++chunk) {
+                double lat_s = lat0 + (chunk / g_svs_chunks_per_side) * chunk_deg;
+                double lon_w = lon0 + (chunk % g_svs_chunks_per_side) * chunk_deg;
+                double dn = (lat_s + chunk_deg * 0.5 - ac_lat) * m_per_deg_lat;
+                double de = (lon_w + chunk_deg * 0.5 - ac_lon) * m_per_deg_lon;
+                double dist = sqrt(dn * dn + de * de);
+                if (dist > g_svs_range_m) continue;
+
+                int lod = 0;
+                while (dist > g_svs_lod_dist_m[lod]) ++lod;
+
+                // Ask for the wanted level, draw whatever level is resident meanwhile
+                unsigned long long want = SvsChunkKey(tile_key, chunk, lod);
+                auto it = g_svs_gpu.find(want);
+                if (it == g_svs_gpu.end()) {
+                    if (!g_svs_in_flight.count(want) && g_svs_in_flight.size() < 256) {
+                        unsigned gen = g_svs_in_flight[want] = ++g_svs_request_gen;
+                        auto verts = std::make_shared<std::vector<SvsVertex>>();
+                        g_pool.Submit(
+                            [tile, chunk, lod, verts] { BuildSvsChunkMesh(*tile, chunk, lod, *verts); },
+                            [want, gen, verts] { g_svs_ready.push_back({ want, gen, verts }); });
+                    }
+                    for (int alt = 0; alt < g_svs_lod_count && it == g_svs_gpu.end(); ++alt) {
+                        it = g_svs_gpu.find(SvsChunkKey(tile_key, chunk, alt));
+                    }
+                    if (it == g_svs_gpu.end()) continue;
+                }
+                int draw_lod = (int)(it->first & 0xF);
+                SvsGpuChunk& gpu = it->second;
+                TouchSvsChunk(gpu);
+                if (gpu.xform_epoch != g_svs_local_epoch) {
+                    SvsChunkTransform(lat_s, lon_w, chunk_deg, gpu.xform);
+                    gpu.xform_epoch = g_svs_local_epoch;
+                }
 
-        // Calculate left/right edge offsets (perpendicular to runway heading)
-        double heading_deg = 180.0; // 16L/34R is roughly north-south
-        double heading_rad = heading_deg * M_PI / 180.0;
-        double offset_lat = (45.72 / 2.0) / 111111.0; // meters to degrees latitude
-        double offset_lon = (45.72 / 2.0) / (111111.0 * cos(lat1 * M_PI / 180.0));
+                glPushMatrix();
+                glMultMatrixd(gpu.xform);
+                p_glBindBuffer(GL_ARRAY_BUFFER, gpu.vbo);
+                p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_svs_index_buffers[draw_lod]);
+                glVertexPointer(3, GL_FLOAT, sizeof(SvsVertex), (const void*)0);
+                if (!g_svs_wireframe) glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(SvsVertex), (const void*)(3 * sizeof(float)));
+                glDrawElements(GL_TRIANGLES,
+                    g_svs_wireframe ? g_svs_grid_index_counts[draw_lod] : g_svs_index_counts[draw_lod],
+                    GL_UNSIGNED_SHORT, (const void*)0);
+                glPopMatrix();
+            }
+        }
+    }
+
+    p_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    p_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glDisable(GL_POLYGON_OFFSET_LINE);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+}
+
+// ──────────────────────────────────
+// Terrain awareness (TAWS-style look-ahead)
+// Every sim frame the flight path is projected ahead along the current
+// track and vertical speed. Around each projected point a box that widens
+// with distance is checked against the DEM max-elevation pyramid for
+// terrain within the clearance margin.
+// ──────────────────────────────────
+static float g_taws_lookahead_s   = 60.0f;  // how far ahead to project
+static float g_taws_step_s        = 5.0f;   // spacing of projected points
+static float g_taws_warning_s     = 20.0f;  // conflicts sooner than this are warnings
+static float g_taws_clearance_m   = 150.0f; // ~500 ft
+static float g_taws_min_agl_m     = 30.0f;  // inhibited on the ground and in the flare
+static float g_taws_cone_base_m   = 150.0f; // half-width of the search box at the aircraft
+static float g_taws_cone_slope    = 0.1f;   // half-width growth per meter ahead (~6 deg)
+static double g_taws_landing_m     = 9260.0; // ~5 nm, inside this the gear down means landing
+static float g_taws_landing_flaps = 0.7f;   // flap ratio taken as landing configuration
+
+enum TawsAlert { TAWS_NONE, TAWS_CAUTION, TAWS_WARNING, TAWS_NO_DATA };
+
+struct TawsState {
+    TawsAlert alert;
+    float time_to_conflict_s;
+};
+static TawsState g_taws = { TAWS_NONE, 0.0f };
+
+static float taws_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    PumpDemTiles();
+
+    static XPLMDataRef lat_ref   = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef lon_ref   = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    static XPLMDataRef elev_ref  = XPLMFindDataRef("sim/flightmodel/position/elevation");
+    static XPLMDataRef agl_ref   = XPLMFindDataRef("sim/flightmodel/position/y_agl");
+    static XPLMDataRef gs_ref    = XPLMFindDataRef("sim/flightmodel/position/groundspeed"); // m/s
+    static XPLMDataRef track_ref = XPLMFindDataRef("sim/flightmodel/position/hpath");       // true track, deg
+    static XPLMDataRef vs_ref    = XPLMFindDataRef("sim/flightmodel/position/vh_ind");      // m/s
+
+    double lat = XPLMGetDatad(lat_ref);
+    double lon = XPLMGetDatad(lon_ref);
+    double alt = XPLMGetDatad(elev_ref);
+    float  gs = XPLMGetDataf(gs_ref);
+    float  vs = XPLMGetDataf(vs_ref);
+    float  track_rad = XPLMGetDataf(track_ref) * (float)(M_PI / 180.0);
+
+    g_taws.alert = TAWS_NONE;
+    if (XPLMGetDataf(agl_ref) < g_taws_min_agl_m) return -1.0f;
+
+    // Landing inhibit: on final the cone runs through the runway and the
+    // terrain short of it, so the look-ahead would alert on every approach
+    static XPLMDataRef gear_ref  = XPLMFindDataRef("sim/cockpit2/controls/gear_handle_down");
+    static XPLMDataRef flaps_ref = XPLMFindDataRef("sim/flightmodel/controls/flaprat");
+    bool gear_down = gear_ref && XPLMGetDatai(gear_ref) != 0;
+    bool landing_flaps = flaps_ref && XPLMGetDataf(flaps_ref) >= g_taws_landing_flaps;
+    double runway_m = std::min(haversine_m(lat, lon, lat1, lon1), haversine_m(lat, lon, lat2, lon2));
+    if ((gear_down && runway_m < g_taws_landing_m) || landing_flaps) return -1.0f;
+
+    double m_per_deg_lat = 111320.0;
+    double m_per_deg_lon = 111320.0 * cos(lat * M_PI / 180.0);
+
+    for (float t = g_taws_step_s; t <= g_taws_lookahead_s; t += g_taws_step_s) {
+        double ahead_m = gs * t;
+        double p_lat = lat + cos(track_rad) * ahead_m / m_per_deg_lat;
+        double p_lon = lon + sin(track_rad) * ahead_m / m_per_deg_lon;
+        float threshold = (float)(alt + vs * t) - g_taws_clearance_m;
+        double half_m = g_taws_cone_base_m + g_taws_cone_slope * ahead_m;
+        double half_lat = half_m / m_per_deg_lat;
+        double half_lon = half_m / m_per_deg_lon;
+
+        // The box can straddle tile edges
+        for (int lat0 = (int)floor(p_lat - half_lat); lat0 <= (int)floor(p_lat + half_lat); ++lat0) {
+            for (int lon0 = (int)floor(p_lon - half_lon); lon0 <= (int)floor(p_lon + half_lon); ++lon0) {
+                std::shared_ptr<const DemTile> tile = RequestDemTile(lat0, lon0);
+                if (!tile) {
+                    if (g_dem_tiles[DemTileKey(lat0, lon0)].missing && g_taws.alert == TAWS_NONE) g_taws.alert = TAWS_NO_DATA;
+                    continue;
+                }
+                if (tile->ExceedsInBox(p_lat - half_lat, p_lat + half_lat, p_lon - half_lon, p_lon + half_lon, threshold)) {
+                    g_taws.alert = t <= g_taws_warning_s ? TAWS_WARNING : TAWS_CAUTION;
+                    g_taws.time_to_conflict_s = t;
+                    return -1.0f;
+                }
+            }
+        }
+    }
+    return -1.0f;
+}
+
+static Published<ZoneGeometry> g_seattle_zone;
+static Published<ZoneGeometry> g_custom_zone;
+
+// ──────────────────────────────────
+// Order-independent transparency (weighted blended) for translucent zones.
+// Inside an OIT pass overlays accumulate into two float targets instead of
+// blending into the scene:
+//   accum  rgb = sum(rgb * a * w), alpha = product(1 - a)  (revealage)
+//   weight r   = sum(a * w)
+// Both are sums and products, so overlapping faces resolve the same way in
+// any draw order and nothing has to be sorted. w falls off with view
+// distance so nearer surfaces dominate the average. The scene depth is
+// blitted in first so terrain and objects still hide the zones. Without
+// shaders or multiple render targets zones blend in draw order as before.
+// ──────────────────────────────────
+static float g_oit_depth_scale_m = 100.0f; // view distance per unit of the weight curve
+
+struct OitTargets {
+    GLuint fbo;
+    int    accum_tex;  // XPLM texture numbers
+    int    weight_tex;
+    GLuint depth_rb;
+    int    width;
+    int    height;
+};
+static OitTargets g_oit = { 0, 0, 0, 0, 0, 0 };
+static GLuint g_oit_accum_program   = 0;
+static GLuint g_oit_resolve_program = 0;
+static GLint  g_oit_depth_scale_loc = -1;
+static bool   g_oit_failed = false; // a shader, target or blit failed, stay on the fallback
+static GLint  g_oit_prev_draw_fbo = 0;
+static GLint  g_oit_prev_read_fbo = 0;
+static GLint  g_oit_prev_viewport[4];
+
+static const char* g_oit_accum_vs =
+    "#version 120\n"
+    "varying float v_depth;\n"
+    "void main() {\n"
+    "    v_depth = -(gl_ModelViewMatrix * gl_Vertex).z;\n"
+    "    gl_FrontColor = gl_Color;\n"
+    "    gl_Position = ftransform();\n"
+    "}\n";
+
+static const char* g_oit_accum_fs =
+    "#version 120\n"
+    "uniform float u_depth_scale;\n"
+    "varying float v_depth;\n"
+    "void main() {\n"
+    "    vec4 c = gl_Color;\n"
+    "    float z = max(v_depth, 0.0) / u_depth_scale;\n"
+    "    float w = c.a * clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e3);\n"
+    "    gl_FragData[0] = vec4(c.rgb * w, c.a);\n"
+    "    gl_FragData[1] = vec4(w);\n"
+    "}\n";
+
+// Fullscreen quad in clip space, no matrices involved
+static const char* g_oit_resolve_vs =
+    "#version 120\n"
+    "void main() {\n"
+    "    gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "    gl_Position = gl_Vertex;\n"
+    "}\n";
+
+static const char* g_oit_resolve_fs =
+    "#version 120\n"
+    "uniform sampler2D u_accum;\n"
+    "uniform sampler2D u_weight;\n"
+    "void main() {\n"
+    "    vec4 accum = texture2D(u_accum, gl_TexCoord[0].st);\n"
+    "    if (accum.a >= 1.0) discard;\n"
+    "    float weight = texture2D(u_weight, gl_TexCoord[0].st).r;\n"
+    "    gl_FragColor = vec4(accum.rgb / max(weight, 1e-5), accum.a);\n"
+    "}\n";
+
+static void DisableOit(const char* why)
+{
+    if (g_oit_failed) return;
+    g_oit_failed = true;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "HUDPlugin: %s, zones blended in draw order.\n", why);
+    XPLMDebugString(buf);
+}
+
+static GLuint CompileOitShader(GLenum type, const char* src)
+{
+    GLuint shader = p_glCreateShader(type);
+    p_glShaderSource(shader, 1, &src, NULL);
+    p_glCompileShader(shader);
+    GLint ok = 0;
+    p_glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512] = { 0 };
+        p_glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        XPLMDebugString("HUDPlugin: OIT shader failed to compile:\n");
+        XPLMDebugString(log);
+        p_glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint LinkOitProgram(const char* vs_src, const char* fs_src)
+{
+    GLuint vs = CompileOitShader(GL_VERTEX_SHADER, vs_src);
+    GLuint fs = CompileOitShader(GL_FRAGMENT_SHADER, fs_src);
+    GLuint program = 0;
+    if (vs && fs) {
+        program = p_glCreateProgram();
+        p_glAttachShader(program, vs);
+        p_glAttachShader(program, fs);
+        p_glLinkProgram(program);
+        GLint ok = 0;
+        p_glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            p_glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    // Attached shaders live on with the program
+    if (vs) p_glDeleteShader(vs);
+    if (fs) p_glDeleteShader(fs);
+    return program;
+}
+
+static bool EnsureOitTargets(int width, int height)
+{
+    OitTargets& t = g_oit;
+    if (!g_oit_accum_program) {
+        g_oit_accum_program = LinkOitProgram(g_oit_accum_vs, g_oit_accum_fs);
+        g_oit_resolve_program = LinkOitProgram(g_oit_resolve_vs, g_oit_resolve_fs);
+        if (!g_oit_accum_program || !g_oit_resolve_program) {
+            DisableOit("OIT shaders unavailable");
+            return false;
+        }
+        g_oit_depth_scale_loc = p_glGetUniformLocation(g_oit_accum_program, "u_depth_scale");
+        p_glUseProgram(g_oit_resolve_program);
+        p_glUniform1i(p_glGetUniformLocation(g_oit_resolve_program, "u_accum"), 0);
+        p_glUniform1i(p_glGetUniformLocation(g_oit_resolve_program, "u_weight"), 1);
+        p_glUseProgram(0);
+    }
+    if (t.fbo && t.width == width && t.height == height) return true;
+
+    if (t.accum_tex == 0) XPLMGenerateTextureNumbers(&t.accum_tex, 1);
+    if (t.weight_tex == 0) XPLMGenerateTextureNumbers(&t.weight_tex, 1);
+    if (t.fbo == 0) p_glGenFramebuffers(1, &t.fbo);
+    if (t.depth_rb == 0) p_glGenRenderbuffers(1, &t.depth_rb);
+
+    int textures[2] = { t.accum_tex, t.weight_tex };
+    for (int tex : textures) {
+        XPLMBindTexture2d(tex, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    // Matches X-Plane's scene depth format so the blit is a straight copy
+    p_glBindRenderbuffer(GL_RENDERBUFFER, t.depth_rb);
+    p_glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    p_glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint prev_fbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+    p_glBindFramebuffer(GL_FRAMEBUFFER, t.fbo);
+    p_glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, t.accum_tex, 0);
+    p_glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, t.weight_tex, 0);
+    p_glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, t.depth_rb);
+    bool complete = p_glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    p_glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prev_fbo);
+
+    if (!complete) {
+        DisableOit("OIT framebuffer incomplete");
+        return false;
+    }
+    t.width = width;
+    t.height = height;
+    return true;
+}
+
+// Redirects translucent drawing into the OIT targets. Returns false when
+// the caller has to blend directly instead; nothing is left bound then.
+static bool BeginOitPass()
+{
+    LoadGLExtensions();
+    if (!g_gl_oit_ok || g_oit_failed) return false;
+
+    glGetIntegerv(GL_VIEWPORT, g_oit_prev_viewport);
+    int width = g_oit_prev_viewport[2];
+    int height = g_oit_prev_viewport[3];
+    if (width <= 0 || height <= 0 || !EnsureOitTargets(width, height)) return false;
+
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &g_oit_prev_draw_fbo);
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &g_oit_prev_read_fbo);
+
+    // Scene depth in, so the zones are still occluded by terrain and objects
+    while (glGetError() != GL_NO_ERROR) {}
+    p_glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)g_oit_prev_draw_fbo);
+    p_glBindFramebuffer(GL_DRAW_FRAMEBUFFER, g_oit.fbo);
+    int x0 = g_oit_prev_viewport[0], y0 = g_oit_prev_viewport[1];
+    p_glBlitFramebuffer(x0, y0, x0 + width, y0 + height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    if (glGetError() != GL_NO_ERROR) {
+        p_glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)g_oit_prev_draw_fbo);
+        p_glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)g_oit_prev_read_fbo);
+        DisableOit("scene depth could not be copied for OIT");
+        return false;
+    }
+    p_glBindFramebuffer(GL_FRAMEBUFFER, g_oit.fbo);
+    glViewport(0, 0, width, height);
+
+    // Revealage starts at 1 (nothing covers the scene), the weight sum at 0
+    GLfloat prev_clear[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, prev_clear);
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDrawBuffer(GL_COLOR_ATTACHMENT1);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(prev_clear[0], prev_clear[1], prev_clear[2], prev_clear[3]);
+    static const GLenum targets[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    p_glDrawBuffers(2, targets);
+
+    // Depth tested against the scene but never written, surfaces must not hide each other
+    SetGraphicsState(0, 0, 0, 0, 1, 1, 0);
+    SetBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    p_glUseProgram(g_oit_accum_program);
+    p_glUniform1f(g_oit_depth_scale_loc, g_oit_depth_scale_m);
+    return true;
+}
+
+// Composites the accumulated overlays over the scene and restores the
+// framebuffer and viewport BeginOitPass changed
+static void ResolveOitPass()
+{
+    p_glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)g_oit_prev_draw_fbo);
+    p_glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)g_oit_prev_read_fbo);
+    glViewport(g_oit_prev_viewport[0], g_oit_prev_viewport[1], g_oit_prev_viewport[2], g_oit_prev_viewport[3]);
+
+    // scene * revealage + average overlay colour * (1 - revealage), scene alpha kept
+    SetGraphicsState(0, 2, 0, 0, 1, 0, 0);
+    XPLMBindTexture2d(g_oit.accum_tex, 0);
+    XPLMBindTexture2d(g_oit.weight_tex, 1);
+    SetBlendFuncSeparate(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ZERO, GL_ONE);
+    p_glUseProgram(g_oit_resolve_program);
+    glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f, -1.0f);
+        glTexCoord2f(1.0f, 0.0f); glVertex2f( 1.0f, -1.0f);
+        glTexCoord2f(1.0f, 1.0f); glVertex2f( 1.0f,  1.0f);
+        glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f,  1.0f);
+    glEnd();
+    p_glUseProgram(0);
+
+    XPLMBindTexture2d(0, 1);
+}
+
+static void ReleaseOitTargets()
+{
+    OitTargets& t = g_oit;
+    if (t.fbo && p_glDeleteFramebuffers) p_glDeleteFramebuffers(1, &t.fbo);
+    if (t.depth_rb && p_glDeleteRenderbuffers) p_glDeleteRenderbuffers(1, &t.depth_rb);
+    GLuint textures[2] = { (GLuint)t.accum_tex, (GLuint)t.weight_tex };
+    for (GLuint tex : textures) {
+        if (tex) glDeleteTextures(1, &tex);
+    }
+    if (g_oit_accum_program) p_glDeleteProgram(g_oit_accum_program);
+    if (g_oit_resolve_program) p_glDeleteProgram(g_oit_resolve_program);
+    g_oit = OitTargets{ 0, 0, 0, 0, 0, 0 };
+    g_oit_accum_program = 0;
+    g_oit_resolve_program = 0;
+    g_oit_depth_scale_loc = -1;
+}
+
+// draw seattle city zone
+
+// Draws a 3D volumetric zone with height. With follow_terrain the floor is
+// draped on the ground (falling back to base_alt_m where terrain is not
+// sampled yet) and edges are subdivided so it follows the ground between corners.
+// Blend and depth state are the caller's, see DrawZonesLayer.
+void DrawSeattleZone(
+    const ZoneGeometry& zone, 
+    float base_alt_m = 0.0f, 
+    float top_alt_m = 2000.0f,
+    bool draw_wireframe = true,
+    bool follow_terrain = false
+) {
+    const std::vector<std::tuple<double, double, double>>& points = zone.points;
+    if (points.size() < 3) return;
+
+    FrameVector<std::array<float, 3>> base_points;
+    FrameVector<std::array<float, 3>> top_points;
+    FrameVector<int> corner_index; // position of each outline corner in base/top_points
+    base_points.reserve(points.size());
+    top_points.reserve(points.size());
+    corner_index.reserve(points.size());
+
+    // Convert WGS84 to local coordinates (base and top)
+    for (size_t i = 0; i < points.size(); ++i) {
+        corner_index.push_back((int)base_points.size());
+        double lat = std::get<0>(points[i]);
+        double lon = std::get<1>(points[i]);
+        double next_lat = std::get<0>(points[(i + 1) % points.size()]);
+        double next_lon = std::get<1>(points[(i + 1) % points.size()]);
+
+        int segments = 1;
+        if (follow_terrain) {
+            segments = (int)ceil(haversine_m(lat, lon, next_lat, next_lon) / g_zone_drape_spacing_m);
+            if (segments < 1) segments = 1;
+        }
+
+        for (int s = 0; s < segments; ++s) {
+            double t = (double)s / segments;
+            double seg_lat = lat + (next_lat - lat) * t;
+            double seg_lon = lon + (next_lon - lon) * t;
+
+            float floor_m = base_alt_m;
+            if (follow_terrain) g_terrain.Height(seg_lat, seg_lon, g_terrain_max_level, &floor_m);
+
+            double x_base, y_base, z_base;
+            XPLMWorldToLocal(seg_lat, seg_lon, floor_m, &x_base, &y_base, &z_base);
+            base_points.push_back({ (float)x_base, (float)y_base, (float)z_base });
+
+            double x_top, y_top, z_top;
+            XPLMWorldToLocal(seg_lat, seg_lon, top_alt_m, &x_top, &y_top, &z_top);
+            top_points.push_back({ (float)x_top, (float)y_top, (float)z_top });
+        }
+    }
+
+    // ─── 1. Draw Solid Red Faces ───
+    glColor4f(1.0f, 0.0f, 0.0f, 0.2f);  // Red, semi-transparent
+
+    // Base and top caps from the precomputed triangulation
+    glDisable(GL_CULL_FACE); // Draw both sides of polygons
+    glBegin(GL_TRIANGLES);
+    for (int idx : zone.cap_triangles) glVertex3fv(base_points[corner_index[idx]].data());
+    for (int idx : zone.cap_triangles) glVertex3fv(top_points[corner_index[idx]].data());
+    glEnd();
+
+    // Sides (quad strip)
+    glBegin(GL_QUAD_STRIP);
+    for (size_t i = 0; i < base_points.size(); ++i) {
+        glVertex3fv(base_points[i].data());
+        glVertex3fv(top_points[i].data());
+    }
+    // Close the loop
+    glVertex3fv(base_points[0].data());
+    glVertex3fv(top_points[0].data());
+    glEnd();
+
+    // ─── 2. Optional Wireframe ───
+    if (draw_wireframe) {
+        glColor4f(1.0f, 1.0f, 0.0f, 0.7f);  // Yellow wireframe
+        SetLineWidth(2.0f);
+
+        // Base outline
+        glBegin(GL_LINE_LOOP);
+        for (const auto& p : base_points) glVertex3fv(p.data());
+        glEnd();
+
+        // Top outline
+        glBegin(GL_LINE_LOOP);
+        for (const auto& p : top_points) glVertex3fv(p.data());
+        glEnd();
+
+        // Vertical connectors at the corners
+        glBegin(GL_LINES);
+        for (int i : corner_index) {
+            glVertex3fv(base_points[i].data());
+            glVertex3fv(top_points[i].data());
+        }
+        glEnd();
+    }
+}
+
+// ──────────────────────────────────
+// Screen-space labels for traffic and waypoints. The 3D callbacks submit
+// labels at world anchors; the anchors are projected right away with the
+// current matrices. In the window phase labels are placed in priority
+// order against a coarse screen bucket grid, so each label is only tested
+// against the few already placed in the buckets it covers. Survivors are
+// drawn in one textured batch from a font atlas baked with stb_truetype;
+// without the font they fall back to XPLMDrawString.
+// ──────────────────────────────────
+static const int g_max_labels        = 1024;
+static const int g_label_bucket_w    = 64;   // pixels
+static const int g_label_bucket_h    = 32;
+static float     g_label_font_px     = 14.0f;
+static const int g_font_atlas_w      = 512;
+static const int g_font_atlas_h      = 128;
+
+struct LabelCandidate {
+    float sx, sy;   // anchor in window coordinates
+    float depth;    // clip w, for ordering equal priorities near first
+    int   priority; // higher wins
+    float color[3];
+    char  text[16];
+};
+
+struct PlacedLabel {
+    float x0, y0, x1, y1;
+    int   candidate;
+};
+
+static std::vector<LabelCandidate> g_label_candidates;
+static std::vector<PlacedLabel>    g_labels_placed;
+static std::vector<int>            g_label_bucket_head; // first placed label per bucket
+static std::vector<int>            g_label_bucket_next; // next label in the same bucket
+static std::vector<int>            g_label_bucket_item; // placed label of each bucket entry
+static std::vector<int>            g_label_order;
+
+static bool  g_label_view_valid = false;
+static float g_label_mvp[16];
+static int   g_label_viewport[4];
+
+static stbtt_bakedchar g_font_chars[96];
+static int g_font_texture = 0;
+
+static bool BakeLabelFont()
+{
+    if (g_font_baked) return g_font_texture != 0;
+    g_font_baked = true;
+
+    char sys_path[512];
+    XPLMGetSystemPath(sys_path);
+    const char* sep = XPLMGetDirectorySeparator();
+    std::string path = std::string(sys_path) + "Resources" + sep + "fonts" + sep + "DejaVuSansMono.ttf";
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in) return false;
+    std::vector<unsigned char> ttf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::vector<unsigned char> atlas(g_font_atlas_w * g_font_atlas_h);
+    if (stbtt_BakeFontBitmap(ttf.data(), 0, g_label_font_px, atlas.data(), g_font_atlas_w, g_font_atlas_h, 32, 96, g_font_chars) <= 0) {
+        return false; // atlas too small for this size
+    }
+    XPLMGenerateTextureNumbers(&g_font_texture, 1);
+    XPLMBindTexture2d(g_font_texture, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, g_font_atlas_w, g_font_atlas_h, 0, GL_ALPHA, GL_UNSIGNED_BYTE, atlas.data());
+    return true;
+}
+
+static float LabelTextWidth(const char* text)
+{
+    if (!g_font_texture) return 8.0f * (float)strlen(text);
+    float w = 0.0f;
+    for (const char* c = text; *c; ++c) {
+        unsigned char ch = (unsigned char)*c;
+        if (ch >= 32 && ch < 128) w += g_font_chars[ch - 32].xadvance;
+    }
+    return w;
+}
+
+static void CaptureLabelView()
+{
+    float mv[16], proj[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    glGetFloatv(GL_PROJECTION_MATRIX, proj);
+    glGetIntegerv(GL_VIEWPORT, g_label_viewport);
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k) sum += proj[k * 4 + r] * mv[c * 4 + k];
+            g_label_mvp[c * 4 + r] = sum;
+        }
+    }
+    g_label_view_valid = true;
+}
+
+// Queues a label at a world position. Call from a 3D draw callback.
+static void SubmitLabel(float x, float y, float z, const char* text, const float color[3], int priority)
+{
+    static XPLMDataRef render_type_ref = XPLMFindDataRef("sim/graphics/view/world_render_type");
+    if (render_type_ref && XPLMGetDatai(render_type_ref) != 0) return; // reflection or shadow pass
+    if ((int)g_label_candidates.size() >= g_max_labels) return;
+    if (!g_label_view_valid) CaptureLabelView();
+
+    const float* m = g_label_mvp;
+    float cx = m[0] * x + m[4] * y + m[8]  * z + m[12];
+    float cy = m[1] * x + m[5] * y + m[9]  * z + m[13];
+    float cw = m[3] * x + m[7] * y + m[11] * z + m[15];
+    if (cw <= 0.1f) return; // behind the camera
+    float nx = cx / cw, ny = cy / cw;
+    if (nx < -1.0f || nx > 1.0f || ny < -1.0f || ny > 1.0f) return;
+
+    // NDC to window coordinates through the viewport the projection was captured with
+    const int* vp = g_label_viewport;
+    LabelCandidate c;
+    c.sx = vp[0] + (nx * 0.5f + 0.5f) * vp[2];
+    c.sy = vp[1] + (ny * 0.5f + 0.5f) * vp[3];
+    c.depth = cw;
+    c.priority = priority;
+    memcpy(c.color, color, sizeof(c.color));
+    snprintf(c.text, sizeof(c.text), "%s", text);
+    g_label_candidates.push_back(c);
+}
+
+static bool LabelFits(const PlacedLabel& r, int bx0, int by0, int bx1, int by1, int buckets_x)
+{
+    for (int by = by0; by <= by1; ++by) {
+        for (int bx = bx0; bx <= bx1; ++bx) {
+            for (int e = g_label_bucket_head[by * buckets_x + bx]; e >= 0; e = g_label_bucket_next[e]) {
+                const PlacedLabel& o = g_labels_placed[g_label_bucket_item[e]];
+                if (r.x0 < o.x1 && o.x0 < r.x1 && r.y0 < o.y1 && o.y0 < r.y1) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Greedy placement in priority order, trying four spots around each anchor.
+// Bounds are the viewport the anchors were projected through.
+static void PlaceLabels(const int* vp)
+{
+    int n = (int)g_label_candidates.size();
+    g_label_order.resize(n);
+    for (int i = 0; i < n; ++i) g_label_order[i] = i;
+    std::sort(g_label_order.begin(), g_label_order.end(), [](int a, int b) {
+        const LabelCandidate& ca = g_label_candidates[a];
+        const LabelCandidate& cb = g_label_candidates[b];
+        return ca.priority != cb.priority ? ca.priority > cb.priority : ca.depth < cb.depth;
+    });
+
+    const float left = (float)vp[0], bottom = (float)vp[1];
+    const float right = left + vp[2], top = bottom + vp[3];
+    int buckets_x = vp[2] / g_label_bucket_w + 1;
+    int buckets_y = vp[3] / g_label_bucket_h + 1;
+    g_label_bucket_head.assign(buckets_x * buckets_y, -1);
+    g_label_bucket_next.clear();
+    g_label_bucket_item.clear();
+    g_labels_placed.clear();
+
+    const float pad = 2.0f;
+    float h = g_font_texture ? g_label_font_px : 10.0f;
+    for (int idx : g_label_order) {
+        const LabelCandidate& c = g_label_candidates[idx];
+        float w = LabelTextWidth(c.text);
+        const float offsets[4][2] = { { 6.0f, 6.0f }, { 6.0f, -6.0f - h }, { -6.0f - w, 6.0f }, { -6.0f - w, -6.0f - h } };
+        for (const auto& off : offsets) {
+            PlacedLabel r = { c.sx + off[0] - pad, c.sy + off[1] - pad, c.sx + off[0] + w + pad, c.sy + off[1] + h + pad, idx };
+            if (r.x0 < left || r.y0 < bottom || r.x1 >= right || r.y1 >= top) continue;
+            int bx0 = (int)(r.x0 - left) / g_label_bucket_w, bx1 = (int)(r.x1 - left) / g_label_bucket_w;
+            int by0 = (int)(r.y0 - bottom) / g_label_bucket_h, by1 = (int)(r.y1 - bottom) / g_label_bucket_h;
+            if (!LabelFits(r, bx0, by0, bx1, by1, buckets_x)) continue;
+
+            int placed = (int)g_labels_placed.size();
+            g_labels_placed.push_back(r);
+            for (int by = by0; by <= by1; ++by) {
+                for (int bx = bx0; bx <= bx1; ++bx) {
+                    int b = by * buckets_x + bx;
+                    g_label_bucket_item.push_back(placed);
+                    g_label_bucket_next.push_back(g_label_bucket_head[b]);
+                    g_label_bucket_head[b] = (int)g_label_bucket_item.size() - 1;
+                }
+            }
+            break;
+        }
+    }
+}
+
+// All placed labels in one textured quad batch: shadows first, then text
+static void DrawPlacedLabels()
+{
+    XPLMSetGraphicsState(0, 1, 0, 1, 1, 0, 0);
+    XPLMBindTexture2d(g_font_texture, 0);
+    glBegin(GL_QUADS);
+    for (int pass = 0; pass < 2; ++pass) {
+        float shift = pass == 0 ? 1.0f : 0.0f;
+        for (const PlacedLabel& r : g_labels_placed) {
+            const LabelCandidate& c = g_label_candidates[r.candidate];
+            if (pass == 0) glColor4f(0.0f, 0.0f, 0.0f, 0.8f);
+            else glColor4f(c.color[0], c.color[1], c.color[2], 1.0f);
+
+            // stb_truetype lays out y-down from the baseline, the window is y-up
+            float pen_x = 0.0f, pen_y = 0.0f;
+            float base_x = r.x0 + 2.0f + shift, base_y = r.y0 + 2.0f + g_label_font_px * 0.25f - shift;
+            for (const char* ch = c.text; *ch; ++ch) {
+                unsigned char uc = (unsigned char)*ch;
+                if (uc < 32 || uc >= 128) continue;
+                stbtt_aligned_quad q;
+                stbtt_GetBakedQuad(g_font_chars, g_font_atlas_w, g_font_atlas_h, uc - 32, &pen_x, &pen_y, &q, 1);
+                glTexCoord2f(q.s0, q.t1); glVertex2f(base_x + q.x0, base_y - q.y1);
+                glTexCoord2f(q.s1, q.t1); glVertex2f(base_x + q.x1, base_y - q.y1);
+                glTexCoord2f(q.s1, q.t0); glVertex2f(base_x + q.x1, base_y - q.y0);
+                glTexCoord2f(q.s0, q.t0); glVertex2f(base_x + q.x0, base_y - q.y0);
+            }
+        }
+    }
+    glEnd();
+}
+
+static void DrawLabelsLayer()
+{
+    g_label_view_valid = false;
+    if (g_label_candidates.empty()) return;
+
+    PlaceLabels(g_label_viewport);
+
+    if (BakeLabelFont()) {
+        DrawPlacedLabels();
+    } else {
+        XPLMSetGraphicsState(0, 0, 0, 0, 1, 0, 0);
+        for (const PlacedLabel& r : g_labels_placed) {
+            LabelCandidate& c = g_label_candidates[r.candidate];
+            DrawTextWithShadow(c.color, (int)r.x0 + 2, (int)r.y0 + 2, c.text);
+        }
+    }
+    g_label_candidates.clear();
+}
+
+// Sized for the worst case up front, placement then never allocates on the draw path
+static void ReserveLabelStorage()
+{
+    g_label_candidates.reserve(g_max_labels);
+    g_labels_placed.reserve(g_max_labels);
+    g_label_order.reserve(g_max_labels);
+    g_label_bucket_next.reserve(g_max_labels * 8);
+    g_label_bucket_item.reserve(g_max_labels * 8);
+}
+
+static void ReleaseLabelFont()
+{
+    if (g_font_texture) {
+        GLuint tex = (GLuint)g_font_texture;
+        glDeleteTextures(1, &tex);
+    }
+    g_font_texture = 0;
+    g_font_baked = false;
+}
+
+// runway distance calculation is haversine_m in HudCore.h
+
+// Distance to a baked waypoint, reusing its precomputed cos(lat)
+double haversine_m(double lat1, double lon1, double cos_lat1, const BakedWaypoint& wp) {
+        return haversine_m(lat1, lon1, cos_lat1, wp.lat, wp.lon, wp.cos_lat);
+}
+
+// function for drawing boxes
+// direction: 0 = dot (circle, green), 1 = up arrow (blue), -1 = down arrow (red)
+void DrawLandingBox(
+    float box_x, float box_y, float box_z,
+    float box_w, float box_h,
+    int direction,
+    float next_box_x, float next_box_y, float next_box_z,
+    float heading_to_next // in degrees
+)
+{
+    // Set box color based on direction
+    if (direction == 0) {
+        glColor4f(0.0f, 1.0f, 0.0f, 1.0f); // Green
+    } else if (direction == 1) {
+        glColor4f(0.2f, 0.5f, 1.0f, 1.0f); // Blue
+    } else if (direction == -1) {
+        glColor4f(1.0f, 0.2f, 0.2f, 1.0f); // Red
+    } else {
+        glColor4f(1.0f, 1.0f, 0.0f, 1.0f); // Default Yellow
+    }
+
+    SetLineWidth(3.0f);
+    glBegin(GL_LINE_LOOP);
+        glVertex3f((float)(box_x - box_w/2), (float)(box_y - box_h/2), (float)box_z);
+        glVertex3f((float)(box_x + box_w/2), (float)(box_y - box_h/2), (float)box_z);
+        glVertex3f((float)(box_x + box_w/2), (float)(box_y + box_h/2), (float)box_z);
+        glVertex3f((float)(box_x - box_w/2), (float)(box_y + box_h/2), (float)box_z);
+    glEnd();
+
+    float cx = box_x;
+    float cy = box_y;
+    float cz = box_z;
+    float sym_size = box_h * 0.4f;
+
+    // Draw up/down arrow above/below box
+    if (direction == 1) {
+        // Up arrow above box (blue)
+        glColor4f(0.2f, 0.5f, 1.0f, 1.0f);
+        float ay = cy + box_h/2 + sym_size * 0.7f;
+        glBegin(GL_TRIANGLES);
+            glVertex3f(cx, ay + sym_size * 0.5f, cz);
+            glVertex3f(cx - sym_size * 0.4f, ay - sym_size * 0.3f, cz);
+            glVertex3f(cx + sym_size * 0.4f, ay - sym_size * 0.3f, cz);
+        glEnd();
+    } else if (direction == -1) {
+        // Down arrow below box (red)
+        glColor4f(1.0f, 0.2f, 0.2f, 1.0f);
+        float ay = cy - box_h/2 - sym_size * 0.7f;
+        glBegin(GL_TRIANGLES);
+            glVertex3f(cx, ay - sym_size * 0.5f, cz);
+            glVertex3f(cx - sym_size * 0.4f, ay + sym_size * 0.3f, cz);
+            glVertex3f(cx + sym_size * 0.4f, ay + sym_size * 0.3f, cz);
+        glEnd();
+    }
+
+    // Draw left/right arrow beside box, pointing to next box
+    if (next_box_x != box_x || next_box_y != box_y) {
+        float dx = next_box_x - box_x;
+        float dy = next_box_y - box_y;
+        // If mostly to the right, draw right arrow; if mostly to the left, draw left arrow
+        if (fabs(dx) > fabs(dy)) {
+            if (dx > 0) {
+                // Right arrow
+                glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
+                float ax = cx + box_w/2 + sym_size * 0.7f;
+                glBegin(GL_TRIANGLES);
+                    glVertex3f(ax + sym_size * 0.5f, cy, cz);
+                    glVertex3f(ax - sym_size * 0.3f, cy - sym_size * 0.4f, cz);
+                    glVertex3f(ax - sym_size * 0.3f, cy + sym_size * 0.4f, cz);
+                glEnd();
+            } else {
+                // Left arrow
+                glColor4f(1.0f, 1.0f, 0.0f, 1.0f);
+                float ax = cx - box_w/2 - sym_size * 0.7f;
+                glBegin(GL_TRIANGLES);
+                    glVertex3f(ax - sym_size * 0.5f, cy, cz);
+                    glVertex3f(ax + sym_size * 0.3f, cy - sym_size * 0.4f, cz);
+                    glVertex3f(ax + sym_size * 0.3f, cy + sym_size * 0.4f, cz);
+                glEnd();
+            }
+        }
+    }
+
+    // Heading label at the centre of the box, placed with the other labels
+    char heading_buf[16];
+    snprintf(heading_buf, sizeof(heading_buf), "%03.0f", heading_to_next);
+    const float label_color[3] = { 1.0f, 1.0f, 1.0f };
+    SubmitLabel(cx, cy, cz, heading_buf, label_color, 0);
+}
+
+static unsigned g_custom_zone_load_gen = 0; // newer loads supersede ones still in flight
+
+// Parses and triangulates on the pool, publishes on the sim thread. A reload
+// from the file watcher is diffed against the zone being drawn and keeps it
+// if the file is unchanged or fails to parse mid-save.
+static void LoadCustomZoneAsync(const char* filename, bool reload)
+{
+    std::string path = filename;
+    auto zone = std::make_shared<ZoneGeometry>();
+    auto status = std::make_shared<const char*>("Zone loading");
+    auto ok = std::make_shared<bool>(false);
+    auto changed = std::make_shared<bool>(true);
+    unsigned gen = ++g_custom_zone_load_gen;
+    if (!reload) {
+        strcpy(g_zone_status, "Zone loading");
+        g_file_watcher.Watch("zone", path, [path] { LoadCustomZoneAsync(path.c_str(), true); });
+    }
+    g_pool.Submit(
+        [path, zone, status, ok, changed, reload] {
+            std::shared_ptr<const ZoneGeometry> previous = reload ? g_custom_zone.Acquire() : nullptr;
+            *ok = LoadCustomZonePoints(path.c_str(), *zone, status.get(), previous.get(), changed.get());
+        },
+        [zone, status, ok, changed, reload, gen] {
+            if (gen != g_custom_zone_load_gen) return;
+            if (reload && !*ok) {
+                XPLMDebugString("Custom zone reload failed, keeping the previous zone: ");
+                XPLMDebugString(*status);
+                XPLMDebugString("\n");
+                strcpy(g_zone_status, "Reload failed, kept previous");
+                return;
+            }
+            snprintf(g_zone_status, sizeof(g_zone_status), "%s", !reload ? *status : *changed ? "Zone reloaded" : "Zone unchanged");
+            if (*ok) {
+                if (*changed) g_custom_zone.Publish(zone);
+                XPLMDebugString(reload ? (*changed ? "Custom zone reloaded.\n" : "Custom zone unchanged.\n")
+                                       : "Custom zone loaded successfully.\n");
+            } else {
+                // A failed first load must not leave a zone from an earlier session on screen
+                g_custom_zone.Publish(nullptr);
+                XPLMDebugString("Failed to load custom zone.\n");
+            }
+        });
+}
+
+// The built-in zone only needs triangulating once
+static void BuildSeattleZone()
+{
+    auto zone = std::make_shared<ZoneGeometry>();
+    g_pool.Submit(
+        [zone] {
+            for (int i = 0; i < g_baked_seattle_zone_count; ++i) {
+                zone->points.emplace_back(g_baked_seattle_zone[i].lat, g_baked_seattle_zone[i].lon, g_baked_seattle_zone[i].alt_m);
+            }
+            zone->cap_triangles = TriangulateZone(zone->points);
+        },
+        [zone] { g_seattle_zone.Publish(zone); });
+}
+
+// ──────────────────────────────────
+// Menu handler: handles menu item selections
+// ──────────────────────────────────
+
+// Every visible zone is drawn from this one layer so they share a single
+// OIT pass and overlapping volumes blend the same whichever comes first
+static void DrawZonesLayer() {
+    // Zone boundaries baked from assets/seattle_zone.zone, triangulated by the pool at enable
+    std::shared_ptr<const ZoneGeometry> seattle_zone = g_zones_visible ? g_seattle_zone.Acquire() : nullptr;
+    std::shared_ptr<const ZoneGeometry> custom_zone = g_custom_zone_visible ? g_custom_zone.Acquire() : nullptr;
+    if (custom_zone && custom_zone->points.size() < 3) custom_zone = nullptr;
+    if (!seattle_zone && !custom_zone) return;
+
+    // Without OIT the layer's own state (blended, depth tested) draws them directly
+    bool oit = BeginOitPass();
+
+    // Draw from the ground (sea level until terrain is sampled) to 2500m altitude
+    if (seattle_zone) DrawSeattleZone(*seattle_zone, 0.0f, 2500.0f, Quality().zone_wireframe, true);
+
+    if (custom_zone) {
+        // Floor follows the terrain, first point's altitude is the fallback until it is sampled
+        float base_alt = std::get<2>(custom_zone->points[0]);
+        float top_alt = base_alt + 2500.0f;
+        DrawSeattleZone(*custom_zone, base_alt, top_alt, Quality().zone_wireframe, true);
+    }
+
+    if (oit) ResolveOitPass();
+}
+
+static void
+menu_handler(
+    void* in_menu_ref,
+    void* in_item_ref)
+{
+    const char* item = (const char*)in_item_ref;
+
+    if (!strcmp(item, "Menu Item 2")) {
+        XPLMCommandOnce(XPLMFindCommand("sim/operation/toggle_key_shortcuts_window"));
+    }
+    else if (!strcmp(item, "HUD Item")) {
+        // Toggle HUD visibility on/off
+        g_hud_visible = !g_hud_visible;
+    }
+    else if (!strcmp(item, "Landing Assist Item")) 
+    {
+        g_landing_assist_visible = !g_landing_assist_visible;
+        radout_init_set = false; // <-- Reset so it will capture new value next time
+    }
+    else if(!strcmp(item, "S to K"))
+    {
+        g_seattle_to_kelowna_visible = !g_seattle_to_kelowna_visible;
+    }
+    else if(!strcmp(item, "Zones"))
+    {
+        g_zones_visible = !g_zones_visible;
+    }
+    else if (!strcmp(item, "Load Custom Waypoints")) {
+        // if (LoadCustomWaypoints("C:\\X-Plane 11\\Resources\\plugins\\custom_waypoints.txt")) {
+        LoadCustomWaypointsAsync("C:\\Users\\fsr_v\\Desktop\\X-Plane 11\\Resources\\plugins\\custom_waypoints.txt");
+    }
+    else if (!strcmp(item, "Show Custom Waypoints")) {
+        g_custom_waypoints_visible = !g_custom_waypoints_visible;
+    }
+    else if (!strcmp(item, "Toggle Aircraft Highlight")) {
+        g_aircraft_highlight_visible = !g_aircraft_highlight_visible;
+    }
+    else if (!strcmp(item, "Traffic Replay")) {
+        if (g_traffic_replay_active) {
+            StopTrafficReplay();
+        } else if (StartTrafficReplay()) {
+            XPLMDebugString("Traffic replay started.\n");
+        }
+    }
+    else if (!strcmp(item, "Traffic UDP")) {
+        if (g_traffic_udp_active) {
+            StopTrafficUdp();
+        } else if (StartTrafficUdp()) {
+            XPLMDebugString("Listening for traffic on UDP.\n");
+        } else {
+            XPLMDebugString("Could not open the traffic UDP port.\n");
+        }
+    }
+    else if (!strcmp(item, "Instructor Stream")) {
+        if (g_instructor_stream_active) {
+            StopInstructorStream();
+        } else if (StartInstructorStream()) {
+            XPLMDebugString("Streaming to the instructor station.\n");
+        } else {
+            XPLMDebugString("Could not open the instructor station socket.\n");
+        }
+    }
+    else if (!strcmp(item, "Session Recorder")) {
+        if (g_session_recording_active) {
+            StopSessionRecording();
+        } else if (!StartSessionRecording()) {
+            XPLMDebugString("Could not open a session file for writing.\n");
+        }
+    }
+    else if (!strcmp(item, "SVS Terrain")) {
+        g_svs_visible = !g_svs_visible;
+    }
+    else if (!strcmp(item, "SVS Style")) {
+        g_svs_wireframe = !g_svs_wireframe;
+    }
+    else if (!strcmp(item, "Load Custom Zone")) {
+        // "C:\\X-Plane 11\\Resources\\plugins\\custom_zones.txt"
+        // "C:\\Users\\fsr_v\\Desktop\\X-Plane 11\\Resources\\plugins\\custom_zone.txt"
+        LoadCustomZoneAsync("C:\\Users\\fsr_v\\Desktop\\X-Plane 11\\Resources\\plugins\\custom_zones.txt");
+    }
+    else if (!strcmp(item, "Show Custom Zone")) {
+        g_custom_zone_visible = !g_custom_zone_visible;
+    }
+
+    
+}
+// ──────────────────────────────────
+// Draw HUD callback: draws the HUD elements every frame
+// ──────────────────────────────────
+
+// ──────────────────────────────
+// for drawing CAT III Runway Edge Lines for KSEA 16L/34R
+// ──────────────────────────────
+static void DrawLandingAssistLayer()
+{
+    {
+        // KSEA 16L/34R endpoints (approximate, WGS84)
+        // 16L: 47.4502, -122.3088
+        // 34R: 47.4180, -122.3088
+        // Runway width: 150 ft = 45.72 m
+
+        // double lat1 = 47.4602, lon1 = -122.3076; // North end, redudent
+        // double lat2 = 47.4280, lon2 = -122.3076; // South end, redundant
+        // float elev = 410.0f; // Approx field elevation in feet
+
+        // Convert feet to meters for XPLMWorldToLocal
+        float elev_m = elev * 0.3048f;
+
+        // Calculate left/right edge offsets (perpendicular to runway heading)
+        double heading_deg = 180.0; // 16L/34R is roughly north-south
+        double heading_rad = heading_deg * M_PI / 180.0;
+        double offset_lat = (45.72 / 2.0) / 111111.0; // meters to degrees latitude
+        double offset_lon = (45.72 / 2.0) / (111111.0 * cos(lat1 * M_PI / 180.0));
 
         // Left edge (west)
         double lat1L = lat1;
@@ -676,468 +3022,2766 @@ static float draw_landing_assist_callback(
         double lat2L = lat2;
         double lon2L = lon2 - offset_lon;
 
-        // Right edge (east)
-        double lat1R = lat1;
-        double lon1R = lon1 + offset_lon;
-        double lat2R = lat2;
-        double lon2R = lon2 + offset_lon;
+        // Right edge (east)
+        double lat1R = lat1;
+        double lon1R = lon1 + offset_lon;
+        double lat2R = lat2;
+        double lon2R = lon2 + offset_lon;
+
+        // Convert to local OpenGL coordinates
+        double x1L, y1L, z1L, x2L, y2L, z2L;
+        double x1R, y1R, z1R, x2R, y2R, z2R;
+        XPLMWorldToLocal(lat1L, lon1L, elev_m, &x1L, &y1L, &z1L);
+        XPLMWorldToLocal(lat2L, lon2L, elev_m, &x2L, &y2L, &z2L);
+        XPLMWorldToLocal(lat1R, lon1R, elev_m, &x1R, &y1R, &z1R);
+        XPLMWorldToLocal(lat2R, lon2R, elev_m, &x2R, &y2R, &z2R);
+
+        // Draw the two edge lines in 3D
+        glColor4f(0.0f, 1.0f, 0.0f, 1.0f);
+        SetLineWidth(4.0f);
+        glBegin(GL_LINES);
+        glVertex3f((float)x1L, (float)y1L, (float)z1L);
+        glVertex3f((float)x2L, (float)y2L, (float)z2L);
+        glVertex3f((float)x1R, (float)y1R, (float)z1R);
+        glVertex3f((float)x2R, (float)y2R, (float)z2R);
+        glEnd();
+
+        // ──────────────────────────────
+        // Drawing centerline
+        // ──────────────────────────────
+
+        // Calculate the centerline coordinates (midpoint between left and right edges)
+        double lat1C = (lat1L + lat1R) / 2.0;
+        double lon1C = (lon1L + lon1R) / 2.0;
+        double lat2C = (lat2L + lat2R) / 2.0;
+        double lon2C = (lon2L + lon2R) / 2.0;
+
+        double x1C, y1C, z1C, x2C, y2C, z2C;
+        XPLMWorldToLocal(lat1C, lon1C, elev_m, &x1C, &y1C, &z1C);
+        XPLMWorldToLocal(lat2C, lon2C, elev_m, &x2C, &y2C, &z2C);
+
+        // Draw the centerline in a different color (e.g., white)
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f); // White
+        SetLineWidth(2.0f);  
+        glBegin(GL_LINES);
+            glVertex3f((float)x1C, (float)y1C, (float)z1C);
+            glVertex3f((float)x2C, (float)y2C, (float)z2C);
+        glEnd();
+
+        // ──────────────────────────────
+        // Draw a 2D "fly-through" box above the runway threshold
+        // ──────────────────────────────
+
+        // Box center: 100 meters above north threshold (lat1, lon1)
+        // Box center: 100 meters above north threshold (lat1, lon1)
+        double box_lat = 47.495;
+        double box_lon = lon1;
+        double box_elev_m = elev_m + 300.0; // 100 meters above runway
+
+        // Convert box center to local coordinates
+        double box_x, box_y, box_z;
+        XPLMWorldToLocal(box_lat, box_lon, box_elev_m, &box_x, &box_y, &box_z);
+
+        // Box size (meters)
+        float box_w = 30.0f;
+        float box_h = 30.0f;
+
+        // Draw the box as a wireframe square in the XY plane (facing forward)
+        glColor4f(1.0f, 1.0f, 0.0f, 1.0f); // Yellow
+        SetLineWidth(3.0f);
+        glBegin(GL_LINE_LOOP);
+            glVertex3f((float)(box_x - box_w/2), (float)(box_y - box_h/2), (float)box_z);
+            glVertex3f((float)(box_x + box_w/2), (float)(box_y - box_h/2), (float)box_z);
+            glVertex3f((float)(box_x + box_w/2), (float)(box_y + box_h/2), (float)box_z);
+            glVertex3f((float)(box_x - box_w/2), (float)(box_y + box_h/2), (float)box_z);
+        glEnd();
+
+        // Calculate center point between runway endpoints
+        double box2_lat = 47.485;
+        double box2_lon = lon1;
+        double box2_elev_m = elev_m + 200.0; // 300 meters above runway
+
+        // Convert box center to local coordinates
+        double box2_x, box2_y, box2_z;
+        XPLMWorldToLocal(box2_lat, box2_lon, box2_elev_m, &box2_x, &box2_y, &box2_z);
+
+        // Box size (meters)
+        float box2_w = 30.0f;
+        float box2_h = 30.0f;
+
+        // Draw the box as a wireframe square in the XY plane (facing forward)
+        glColor4f(1.0f, 0.5f, 0.0f, 1.0f); // Orange for distinction
+        SetLineWidth(3.0f);
+        glBegin(GL_LINE_LOOP);
+            glVertex3f((float)(box2_x - box2_w/2), (float)(box2_y - box2_h/2), (float)box2_z);
+            glVertex3f((float)(box2_x + box2_w/2), (float)(box2_y - box2_h/2), (float)box2_z);
+            glVertex3f((float)(box2_x + box2_w/2), (float)(box2_y + box2_h/2), (float)box2_z);
+            glVertex3f((float)(box2_x - box2_w/2), (float)(box2_y + box2_h/2), (float)box2_z);
+        glEnd();
+    }
+}
+// ──────────────────────────────────
+// traffic
+// ──────────────────────────────────
+
+// The traffic table and the conflict pass are in HudCore.h. The sim thread
+// gathers positions and velocities into a table once per frame, the
+// conflict pass runs on the pool, and the draw callback and HUD read the
+// latest published table.
+
+// ──────────────────────────────────
+// External traffic feed. Targets come from a recorded file replayed
+// against the sim clock, or from CSV datagrams on a local UDP port. Both
+// use one line format:
+//     time_s,id,lat,lon,alt_m,track_deg,gs_mps,vs_mps[,callsign]
+// (time_s is ignored for UDP, arrival time is used instead). The file is
+// read in chunks on the pool so a whole recorded day never sits in
+// memory. Targets are kept in a uniform lat/lon grid, and each frame only
+// the cells around the aircraft are visited; the nearest targets go into
+// the traffic table for drawing and conflict checks.
+// ──────────────────────────────────
+static double g_traffic_cell_deg       = 0.05;    // grid cell size, ~5.5 km north-south
+static double g_traffic_query_radius_m = 30000.0; // feed targets further away are not drawn
+static float  g_traffic_stale_s        = 20.0f;   // targets silent this long are dropped
+static float  g_traffic_replay_ahead_s = 30.0f;   // keep this much of the file parsed ahead
+static int    g_traffic_replay_chunk   = 20000;   // lines per read job
+static int    g_traffic_udp_port       = 49100;
+static int    g_traffic_trail_budget   = 100000;  // trail vertices drawn per frame, all targets
+
+struct FeedSample {
+    double t;
+    unsigned id;
+    double lat, lon;
+    float alt_m, track_deg, gs_mps, vs_mps;
+    char callsign[9];
+};
+
+struct FeedTarget {
+    unsigned id;
+    double lat, lon;
+    float alt_m, track_deg, gs_mps, vs_mps;
+    float received_at; // sim time the sample is valid for
+    char callsign[9];
+    long long cell;
+    int trail;         // -1 while the target has no trail
+};
+
+static bool ParseFeedLine(const char* line, FeedSample& out)
+{
+    out.callsign[0] = 0;
+    int n = sscanf(line, "%lf,%u,%lf,%lf,%f,%f,%f,%f,%8[^,\r\n]",
+        &out.t, &out.id, &out.lat, &out.lon, &out.alt_m, &out.track_deg, &out.gs_mps, &out.vs_mps, out.callsign);
+    return n >= 8;
+}
+
+// Uniform lat/lon grid of feed target indices
+class TrafficGrid {
+public:
+    long long Key(double lat, double lon) const {
+        long long row = (long long)floor((lat + 90.0) / g_traffic_cell_deg);
+        long long col = (long long)floor((lon + 180.0) / g_traffic_cell_deg);
+        return (row << 32) | (col & 0xffffffffLL);
+    }
+
+    void Insert(long long key, int index) { m_cells[key].push_back(index); }
+
+    void Remove(long long key, int index) {
+        std::vector<int>& cell = m_cells[key];
+        for (size_t i = 0; i < cell.size(); ++i) {
+            if (cell[i] == index) { cell[i] = cell.back(); cell.pop_back(); break; }
+        }
+        if (cell.empty()) m_cells.erase(key);
+    }
+
+    void Renumber(long long key, int from, int to) {
+        for (int& i : m_cells[key]) if (i == from) i = to;
+    }
+
+    // Calls fn(index) for every target in the cells overlapping the radius
+    template <typename Fn>
+    void Query(double lat, double lon, double radius_m, Fn fn) const {
+        double dlat = radius_m / 111320.0;
+        double dlon = radius_m / (111320.0 * std::max(0.01, cos(lat * M_PI / 180.0)));
+        long long r0 = (long long)floor((lat - dlat + 90.0) / g_traffic_cell_deg);
+        long long r1 = (long long)floor((lat + dlat + 90.0) / g_traffic_cell_deg);
+        long long c0 = (long long)floor((lon - dlon + 180.0) / g_traffic_cell_deg);
+        long long c1 = (long long)floor((lon + dlon + 180.0) / g_traffic_cell_deg);
+        for (long long r = r0; r <= r1; ++r) {
+            for (long long c = c0; c <= c1; ++c) {
+                auto it = m_cells.find((r << 32) | (c & 0xffffffffLL));
+                if (it == m_cells.end()) continue;
+                for (int i : it->second) fn(i);
+            }
+        }
+    }
+
+    void Clear() { m_cells.clear(); }
+
+private:
+    std::unordered_map<long long, std::vector<int>> m_cells;
+};
+
+static std::vector<FeedTarget> g_feed_targets;
+static std::unordered_map<unsigned, int> g_feed_index; // id -> position in g_feed_targets
+static TrafficGrid g_traffic_grid;
+static std::vector<int> g_free_trails;
+static unsigned g_trail_owner[g_max_traffic];    // feed id holding each trail
+static unsigned g_trail_seen[g_max_traffic];     // last traffic frame the trail was used
+static unsigned g_traffic_frame = 0;
+
+static void ReleaseTrail(int trail)
+{
+    g_ai_trails[trail].clear();
+    g_trail_owner[trail] = 0;
+    g_free_trails.push_back(trail);
+}
+
+static void ResetTrafficFeed()
+{
+    g_feed_targets.clear();
+    g_feed_index.clear();
+    g_traffic_grid.Clear();
+    g_free_trails.clear();
+    for (int i = g_max_traffic - 1; i >= 20; --i) {
+        g_ai_trails[i].clear();
+        g_trail_owner[i] = 0;
+        g_free_trails.push_back(i);
+    }
+}
+
+static void ApplyFeedSample(const FeedSample& s, float received_at)
+{
+    auto it = g_feed_index.find(s.id);
+    int index;
+    if (it == g_feed_index.end()) {
+        index = (int)g_feed_targets.size();
+        FeedTarget t = {};
+        t.id = s.id;
+        t.trail = -1;
+        t.cell = g_traffic_grid.Key(s.lat, s.lon);
+        g_feed_targets.push_back(t);
+        g_feed_index[s.id] = index;
+        g_traffic_grid.Insert(t.cell, index);
+    } else {
+        index = it->second;
+    }
+
+    FeedTarget& t = g_feed_targets[index];
+    long long cell = g_traffic_grid.Key(s.lat, s.lon);
+    if (cell != t.cell) {
+        g_traffic_grid.Remove(t.cell, index);
+        g_traffic_grid.Insert(cell, index);
+        t.cell = cell;
+    }
+    t.lat = s.lat;
+    t.lon = s.lon;
+    t.alt_m = s.alt_m;
+    t.track_deg = s.track_deg;
+    t.gs_mps = s.gs_mps;
+    t.vs_mps = s.vs_mps;
+    t.received_at = received_at;
+    if (s.callsign[0]) memcpy(t.callsign, s.callsign, sizeof(t.callsign));
+}
+
+// Swap-removes targets that stopped reporting
+static void DropStaleFeedTargets(float now)
+{
+    for (int i = 0; i < (int)g_feed_targets.size();) {
+        if (now - g_feed_targets[i].received_at < g_traffic_stale_s) { ++i; continue; }
+        FeedTarget& gone = g_feed_targets[i];
+        if (gone.trail >= 0) ReleaseTrail(gone.trail);
+        g_traffic_grid.Remove(gone.cell, i);
+        g_feed_index.erase(gone.id);
+
+        int last = (int)g_feed_targets.size() - 1;
+        if (i != last) {
+            g_feed_targets[i] = g_feed_targets[last];
+            g_traffic_grid.Renumber(g_feed_targets[i].cell, last, i);
+            g_feed_index[g_feed_targets[i].id] = i;
+        }
+        g_feed_targets.pop_back();
+    }
+}
+
+// ─── Recorded file replay ───
+
+struct ReplayReader {
+    std::ifstream in;
+    bool eof = false;
+};
+
+static std::shared_ptr<ReplayReader> g_replay_reader;
+static std::deque<FeedSample> g_replay_rows;   // parsed, not yet due
+static bool   g_replay_read_in_flight = false;
+static bool   g_replay_clock_started = false;
+static double g_replay_clock = 0.0;            // file time being played
+static float  g_replay_last_now = 0.0f;
+
+static std::string TrafficReplayPath()
+{
+    char sys_path[512];
+    XPLMGetSystemPath(sys_path);
+    const char* sep = XPLMGetDirectorySeparator();
+    return std::string(sys_path) + "Resources" + sep + "plugins" + sep + "traffic_replay.csv";
+}
+
+static void RequestReplayChunk()
+{
+    if (g_replay_read_in_flight || !g_replay_reader || g_replay_reader->eof) return;
+    g_replay_read_in_flight = true;
+    std::shared_ptr<ReplayReader> reader = g_replay_reader;
+    auto rows = std::make_shared<std::vector<FeedSample>>();
+    g_pool.Submit(
+        [reader, rows] {
+            std::string line;
+            rows->reserve(g_traffic_replay_chunk);
+            while ((int)rows->size() < g_traffic_replay_chunk && std::getline(reader->in, line)) {
+                FeedSample s;
+                if (ParseFeedLine(line.c_str(), s)) rows->push_back(s); // skips the header and bad lines
+            }
+            if (!reader->in) reader->eof = true;
+        },
+        [reader, rows] {
+            if (reader != g_replay_reader) return; // replay stopped or restarted meanwhile
+            g_replay_read_in_flight = false;
+            g_replay_rows.insert(g_replay_rows.end(), rows->begin(), rows->end());
+        });
+}
+
+static bool StartTrafficReplay()
+{
+    auto reader = std::make_shared<ReplayReader>();
+    reader->in.open(TrafficReplayPath().c_str());
+    if (!reader->in) {
+        XPLMDebugString("Traffic replay file not found: ");
+        XPLMDebugString(TrafficReplayPath().c_str());
+        XPLMDebugString("\n");
+        return false;
+    }
+    if (!g_traffic_udp_active) ResetTrafficFeed();
+    g_traffic_replay_active = true;
+    g_replay_reader = reader;
+    g_replay_rows.clear();
+    g_replay_read_in_flight = false;
+    g_replay_clock_started = false;
+    RequestReplayChunk();
+    return true;
+}
+
+static void StopTrafficReplay()
+{
+    g_traffic_replay_active = false;
+    g_replay_reader.reset();
+    g_replay_rows.clear();
+    g_replay_read_in_flight = false;
+}
+
+static void PumpTrafficReplay(float now)
+{
+    if (!g_replay_reader) return;
+    if (!g_replay_clock_started) {
+        if (g_replay_rows.empty()) return;
+        g_replay_clock = g_replay_rows.front().t;
+        g_replay_last_now = now;
+        g_replay_clock_started = true;
+    }
+    // Elapsed time keeps running while the sim is paused, the replay must not
+    static XPLMDataRef paused = XPLMFindDataRef("sim/time/paused");
+    if (!paused || !XPLMGetDatai(paused)) g_replay_clock += now - g_replay_last_now;
+    g_replay_last_now = now;
+
+    while (!g_replay_rows.empty() && g_replay_rows.front().t <= g_replay_clock) {
+        const FeedSample& s = g_replay_rows.front();
+        ApplyFeedSample(s, now - (float)(g_replay_clock - s.t));
+        g_replay_rows.pop_front();
+    }
+    if (g_replay_rows.empty() || g_replay_rows.back().t < g_replay_clock + g_traffic_replay_ahead_s) {
+        RequestReplayChunk();
+    }
+    // eof is written by the worker, only read it once no chunk is in flight
+    if (g_replay_rows.empty() && !g_replay_read_in_flight && g_replay_reader->eof) {
+        XPLMDebugString("Traffic replay finished.\n");
+        StopTrafficReplay();
+    }
+}
+
+// ─── Local UDP feed ───
+
+#if IBM
+typedef SOCKET FeedSocket;
+static const FeedSocket g_no_socket = INVALID_SOCKET;
+#else
+typedef int FeedSocket;
+static const FeedSocket g_no_socket = -1;
+#endif
+static FeedSocket g_traffic_socket = g_no_socket;
+
+static bool StartTrafficUdp()
+{
+#if IBM
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    FeedSocket sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == g_no_socket) return false;
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)g_traffic_udp_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool ok = bind(sock, (sockaddr*)&addr, sizeof(addr)) == 0;
+#if IBM
+    u_long nonblocking = 1;
+    ok = ok && ioctlsocket(sock, FIONBIO, &nonblocking) == 0;
+    if (!ok) { closesocket(sock); WSACleanup(); return false; }
+#else
+    ok = ok && fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) == 0;
+    if (!ok) { close(sock); return false; }
+#endif
+    if (!g_traffic_replay_active) ResetTrafficFeed();
+    g_traffic_udp_active = true;
+    g_traffic_socket = sock;
+    return true;
+}
+
+static void StopTrafficUdp()
+{
+    g_traffic_udp_active = false;
+    if (g_traffic_socket == g_no_socket) return;
+#if IBM
+    closesocket(g_traffic_socket);
+    WSACleanup();
+#else
+    close(g_traffic_socket);
+#endif
+    g_traffic_socket = g_no_socket;
+}
+
+// Each datagram holds one or more lines
+static void PumpTrafficUdp(float now)
+{
+    if (g_traffic_socket == g_no_socket) return;
+    char buf[2048];
+    for (int packets = 0; packets < 1000; ++packets) { // bounded per frame
+        int len = (int)recv(g_traffic_socket, buf, sizeof(buf) - 1, 0);
+        if (len <= 0) break;
+        buf[len] = 0;
+        for (char* line = buf; line && *line;) {
+            char* next = strchr(line, '\n');
+            if (next) *next++ = 0;
+            FeedSample s;
+            if (ParseFeedLine(line, s)) ApplyFeedSample(s, now);
+            line = next;
+        }
+    }
+}
+
+static size_t TrafficFeedCount()
+{
+    return g_feed_targets.size();
+}
+
+struct FeedCandidate {
+    float dist2;
+    int index;
+};
+static std::vector<FeedCandidate> g_feed_candidates; // reused every frame
+
+// Appends the nearest feed targets to the table, dead-reckoned to 'now'
+static void AddFeedTraffic(TrafficTable& t, float now)
+{
+    ++g_traffic_frame;
+    static float next_stale_check = 0.0f;
+    if (now >= next_stale_check) {
+        DropStaleFeedTargets(now);
+        next_stale_check = now + 1.0f;
+    }
+    if (g_feed_targets.empty()) return;
+
+    static XPLMDataRef lat_ref = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef lon_ref = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    double own_lat = XPLMGetDatad(lat_ref);
+    double own_lon = XPLMGetDatad(lon_ref);
+    double m_per_deg_lon = 111320.0 * cos(own_lat * M_PI / 180.0);
+    double radius2 = g_traffic_query_radius_m * g_traffic_query_radius_m;
+
+    g_feed_candidates.clear();
+    g_traffic_grid.Query(own_lat, own_lon, g_traffic_query_radius_m, [&](int i) {
+        const FeedTarget& f = g_feed_targets[i];
+        double dn = (f.lat - own_lat) * 111320.0;
+        double de = (f.lon - own_lon) * m_per_deg_lon;
+        double d2 = dn * dn + de * de;
+        if (d2 <= radius2) g_feed_candidates.push_back({ (float)d2, i });
+    });
+
+    // Keep the nearest ones if there are more than the table holds
+    int room = g_max_traffic - t.count;
+    if ((int)g_feed_candidates.size() > room) {
+        std::nth_element(g_feed_candidates.begin(), g_feed_candidates.begin() + room, g_feed_candidates.end(),
+            [](const FeedCandidate& a, const FeedCandidate& b) { return a.dist2 < b.dist2; });
+        g_feed_candidates.resize(room);
+    }
+
+    for (const FeedCandidate& c : g_feed_candidates) {
+        FeedTarget& f = g_feed_targets[c.index];
+        if (f.trail < 0 && !g_free_trails.empty()) {
+            f.trail = g_free_trails.back();
+            g_free_trails.pop_back();
+            g_trail_owner[f.trail] = f.id;
+        }
+        if (f.trail >= 0) g_trail_seen[f.trail] = g_traffic_frame;
+
+        // Straight-line dead reckoning from the last report
+        float dt = now - f.received_at;
+        float trk = f.track_deg * (float)(M_PI / 180.0);
+        float vn = f.gs_mps * cosf(trk), ve = f.gs_mps * sinf(trk);
+        double lat = f.lat + vn * dt / 111320.0;
+        double lon = f.lon + ve * dt / m_per_deg_lon;
+        double x, y, z;
+        XPLMWorldToLocal(lat, lon, f.alt_m + f.vs_mps * dt, &x, &y, &z);
+
+        int k = t.count++;
+        t.trail[k] = f.trail >= 0 ? f.trail : 0;
+        t.trail_gen[k] = g_ai_trails[t.trail[k]].generation;
+        t.x[k] = (float)x;
+        t.y[k] = (float)y;
+        t.z[k] = (float)z;
+        t.vx[k] = ve;        // local x points east
+        t.vy[k] = f.vs_mps;
+        t.vz[k] = -vn;       // local z points south
+        t.ax[k] = t.ay[k] = t.az[k] = 0.0f;
+        if (f.callsign[0]) memcpy(t.label[k], f.callsign, sizeof(t.label[k]));
+        else snprintf(t.label[k], sizeof(t.label[k]), "%06X", f.id & 0xffffff);
+    }
+
+    // Trails of targets that left the query area go back to the pool
+    for (int i = 20; i < g_max_traffic; ++i) {
+        if (!g_trail_owner[i] || g_trail_seen[i] == g_traffic_frame) continue;
+        auto it = g_feed_index.find(g_trail_owner[i]);
+        if (it != g_feed_index.end()) g_feed_targets[it->second].trail = -1;
+        ReleaseTrail(i);
+    }
+}
+
+static Published<TrafficTable> g_traffic;
+static std::shared_ptr<TrafficTable> g_traffic_buffers[3]; // recycled once nobody holds them
+static bool g_traffic_pass_in_flight = false;
+
+// Multiplayer datarefs, looked up once per slot
+struct TrafficSlotRefs {
+    XPLMDataRef x, y, z, vx, vy, vz, tailnum;
+};
+
+// Multiplayer targets are sampled at a low rate and dead-reckoned in
+// between. Each track keeps its last sampled state plus velocity and
+// acceleration estimates; the draw callback extrapolates to the frame
+// time with p + v*dt + a*dt^2/2, so boxes and trails stay smooth at any
+// frame rate while the datarefs are read only a few times a second.
+static float g_traffic_sample_hz   = 8.0f;
+static float g_traffic_accel_blend = 0.5f;   // weight of the newest acceleration estimate
+static float g_traffic_max_accel   = 30.0f;  // m/s^2, larger estimates are treated as noise
+static float g_traffic_jump_m      = 1000.0f; // a jump this big between samples restarts the track
+static float g_traffic_max_extrapolate_s = 1.0f;
+
+struct TrafficTrack {
+    bool valid;
+    float t;
+    float x, y, z, vx, vy, vz, ax, ay, az;
+};
+
+static void SampleTrafficTrack(TrafficTrack& tr, const TrafficSlotRefs& r, float now)
+{
+    float x = XPLMGetDataf(r.x), y = XPLMGetDataf(r.y), z = XPLMGetDataf(r.z);
+    float dt = now - tr.t;
+    float jx = x - tr.x, jy = y - tr.y, jz = z - tr.z;
+    bool restart = !tr.valid || dt <= 1e-3f || jx * jx + jy * jy + jz * jz > g_traffic_jump_m * g_traffic_jump_m;
+
+    float vx, vy, vz;
+    if (r.vx && r.vy && r.vz) {
+        vx = XPLMGetDataf(r.vx);
+        vy = XPLMGetDataf(r.vy);
+        vz = XPLMGetDataf(r.vz);
+    } else if (!restart) {
+        vx = jx / dt;
+        vy = jy / dt;
+        vz = jz / dt;
+    } else {
+        vx = vy = vz = 0.0f;
+    }
+
+    if (restart) {
+        tr.ax = tr.ay = tr.az = 0.0f;
+    } else {
+        float nax = (vx - tr.vx) / dt, nay = (vy - tr.vy) / dt, naz = (vz - tr.vz) / dt;
+        float mag2 = nax * nax + nay * nay + naz * naz;
+        if (mag2 > g_traffic_max_accel * g_traffic_max_accel) {
+            float k = g_traffic_max_accel / sqrtf(mag2);
+            nax *= k; nay *= k; naz *= k;
+        }
+        float b = g_traffic_accel_blend;
+        tr.ax += b * (nax - tr.ax);
+        tr.ay += b * (nay - tr.ay);
+        tr.az += b * (naz - tr.az);
+    }
+    tr.valid = true;
+    tr.t = now;
+    tr.x = x;  tr.y = y;  tr.z = z;
+    tr.vx = vx; tr.vy = vy; tr.vz = vz;
+}
+
+static std::shared_ptr<TrafficTable> TakeTrafficBuffer()
+{
+    for (auto& b : g_traffic_buffers) {
+        if (!b) b = std::make_shared<TrafficTable>();
+        if (b.use_count() == 1) return b;
+    }
+    return nullptr; // all in use, skip this frame
+}
+
+// Stopping the pool drops a pass still in flight
+static void ResetTrafficConflicts()
+{
+    g_traffic_pass_in_flight = false;
+}
+
+static float traffic_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    // One pass at a time, retry next frame if the last one is still running
+    if (g_traffic_pass_in_flight) return -1.0f;
+    std::shared_ptr<TrafficTable> table = TakeTrafficBuffer();
+    if (!table) return -1.0f;
+
+    static XPLMDataRef own_x  = XPLMFindDataRef("sim/flightmodel/position/local_x");
+    static XPLMDataRef own_y  = XPLMFindDataRef("sim/flightmodel/position/local_y");
+    static XPLMDataRef own_z  = XPLMFindDataRef("sim/flightmodel/position/local_z");
+    static XPLMDataRef own_vx = XPLMFindDataRef("sim/flightmodel/position/local_vx");
+    static XPLMDataRef own_vy = XPLMFindDataRef("sim/flightmodel/position/local_vy");
+    static XPLMDataRef own_vz = XPLMFindDataRef("sim/flightmodel/position/local_vz");
+    static TrafficSlotRefs refs[20];
+    static bool refs_found = false;
+    if (!refs_found) {
+        for (int i = 1; i < 20; ++i) {
+            char name[64];
+            snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_x", i);   refs[i].x  = XPLMFindDataRef(name);
+            snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_y", i);   refs[i].y  = XPLMFindDataRef(name);
+            snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_z", i);   refs[i].z  = XPLMFindDataRef(name);
+            snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_v_x", i); refs[i].vx = XPLMFindDataRef(name);
+            snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_v_y", i); refs[i].vy = XPLMFindDataRef(name);
+            snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_v_z", i); refs[i].vz = XPLMFindDataRef(name);
+            snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_tailnum", i); refs[i].tailnum = XPLMFindDataRef(name);
+        }
+        refs_found = true;
+    }
+
+    static TrafficTrack tracks[20];
+    float now = XPLMGetElapsedTime();
+
+    TrafficTable& t = *table;
+    t.time_s = now;
+    t.own_x = XPLMGetDataf(own_x);   t.own_y = XPLMGetDataf(own_y);   t.own_z = XPLMGetDataf(own_z);
+    t.own_vx = XPLMGetDataf(own_vx); t.own_vy = XPLMGetDataf(own_vy); t.own_vz = XPLMGetDataf(own_vz);
+    t.count = 0;
+    // Slots past the active count hold stale positions from earlier flights
+    int total_aircraft = 0, active_aircraft = 0;
+    XPLMPluginID controller = XPLM_NO_PLUGIN_ID;
+    XPLMCountAircraft(&total_aircraft, &active_aircraft, &controller);
+    int slots = std::min(active_aircraft, 20);
+    for (int i = 1; i < slots && t.count < g_max_traffic; ++i) {
+        const TrafficSlotRefs& r = refs[i];
+        if (!r.x || !r.y || !r.z) continue;
+        TrafficTrack& tr = tracks[i];
+        SampleTrafficTrack(tr, r, now);
+        int k = t.count++;
+        t.trail[k] = i;
+        t.trail_gen[k] = g_ai_trails[i].generation;
+        t.x[k] = tr.x;   t.y[k] = tr.y;   t.z[k] = tr.z;
+        t.vx[k] = tr.vx; t.vy[k] = tr.vy; t.vz[k] = tr.vz;
+        t.ax[k] = tr.ax; t.ay[k] = tr.ay; t.az[k] = tr.az;
+        int len = r.tailnum ? XPLMGetDatab(r.tailnum, t.label[k], 0, sizeof(t.label[k]) - 1) : 0;
+        t.label[k][len > 0 ? len : 0] = 0;
+        if (!t.label[k][0]) snprintf(t.label[k], sizeof(t.label[k]), "AI%d", i);
+    }
+
+    PumpTrafficReplay(now);
+    PumpTrafficUdp(now);
+    AddFeedTraffic(t, now);
+
+    g_traffic_pass_in_flight = true;
+    g_pool.Submit(
+        [table] { ComputeTrafficConflicts(*table); },
+        [table] {
+            g_traffic.Publish(table);
+            g_traffic_pass_in_flight = false;
+        });
+    return 1.0f / std::min(g_traffic_sample_hz, Quality().traffic_hz);
+}
+
+// Trails get one point per fixed step of sim time, so their length does not
+// depend on the frame rate. Steps missed by a slow frame are caught up from
+// the dead-reckoned track; after a long stall the trail restarts at now.
+static float g_traffic_trail_step_s = 1.0f / 30.0f;
+static float g_trail_next_t = -1.0f;
+
+static float trail_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    std::shared_ptr<const TrafficTable> traffic = g_traffic.Acquire();
+    float now = XPLMGetElapsedTime();
+    if (!traffic || g_trail_next_t < 0.0f || now - g_trail_next_t > g_traffic_max_extrapolate_s) g_trail_next_t = now;
+    if (!traffic) return -1.0f;
+    const TrafficTable& t = *traffic;
+
+    // Long trails for every target would be unbounded, share a fixed vertex budget
+    int trail_cap = t.count > 0 ? std::max(10, g_traffic_trail_budget / t.count) : g_max_trail_points;
+
+    for (; g_trail_next_t <= now; g_trail_next_t += g_traffic_trail_step_s) {
+        float dt = g_trail_next_t - t.time_s;
+        dt = dt < 0.0f ? 0.0f : (dt > g_traffic_max_extrapolate_s ? g_traffic_max_extrapolate_s : dt);
+        float half_dt2 = 0.5f * dt * dt;
+        for (int k = 0; k < t.count; k++) {
+            int i = t.trail[k];
+            if (i == 0) continue; // feed target that did not get a trail
+
+            // Scale trail length: closer = shorter, farther = longer
+            float dist_km = t.range_m[k] / 1000.0f;
+            int max_trail_points = (int)((10 + dist_km * 600.0f) * Quality().trail_scale);
+            if (max_trail_points > g_max_trail_points) max_trail_points = g_max_trail_points;
+            if (max_trail_points > trail_cap) max_trail_points = trail_cap;
+            if (max_trail_points < 10) max_trail_points = 10;
+
+            g_ai_trails[i].push({ t.x[k] + t.vx[k] * dt + t.ax[k] * half_dt2,
+                                  t.y[k] + t.vy[k] * dt + t.ay[k] * half_dt2,
+                                  t.z[k] + t.vz[k] * dt + t.az[k] * half_dt2 }, max_trail_points);
+        }
+    }
+    return -1.0f;
+}
+
+static void DrawAircraftHighlightLayer() {
+    std::shared_ptr<const TrafficTable> traffic = g_traffic.Acquire();
+    if (!traffic) return;
+    const TrafficTable& t = *traffic;
+
+    // Dead-reckon the sampled positions to this frame
+    float dt = XPLMGetElapsedTime() - t.time_s;
+    dt = dt < 0.0f ? 0.0f : (dt > g_traffic_max_extrapolate_s ? g_traffic_max_extrapolate_s : dt);
+    float half_dt2 = 0.5f * dt * dt;
+
+    for (int k = 0; k < t.count; k++) {
+        int i = t.trail[k];
+        float x = t.x[k] + t.vx[k] * dt + t.ax[k] * half_dt2;
+        float y = t.y[k] + t.vy[k] * dt + t.ay[k] * half_dt2;
+        float z = t.z[k] + t.vz[k] * dt + t.az[k] * half_dt2;
+
+        // Colour by collision risk: red for a warning, amber for a caution or a close target
+        float color[3];
+        if (t.threat[k] == THREAT_WARNING) {
+            color[0] = 1.0f; color[1] = 0.0f; color[2] = 0.0f;
+        }
+        else if (t.threat[k] == THREAT_CAUTION) {
+            color[0] = 1.0f; color[1] = 0.5f; color[2] = 0.0f;
+        }
+        else if (t.threat[k] == THREAT_PROXIMATE) {
+            color[0] = 1.0f; color[1] = 0.8f; color[2] = 0.0f;
+        }
+        else {
+            color[0] = 0.0f; color[1] = 1.0f; color[2] = 0.0f;
+        }
+
+        draw_highlight_box(x, y, z, color, t.label[k], t.threat[k]);
+
+        // ────── TRAIL LOGIC ──────
+        // Points are pushed by trail_flight_loop
+        if (i == 0) continue; // feed target that did not get a trail
+        const AiTrail& trail = g_ai_trails[i];
+
+        // Draw the trail as a line strip
+        glColor4f(color[0], color[1], color[2], 0.7f);
+        SetLineWidth(2.0f);
+        glBegin(GL_LINE_STRIP);
+        for (int p = 0; p < trail.count; ++p) {
+            glVertex3fv(trail.at(p).data());
+        }
+        glEnd();
+    }
+}
+
+// Modified to accept color parameter
+static void draw_highlight_box(float x, float y, float z, const float color[3], const char* tailnum, int priority) {
+    const float size = 5.0f; // Box size in meters
+    
+    glColor3fv(color); // Use the passed color
+    SetLineWidth(2.0f);
+    
+    // Bottom square
+    glBegin(GL_LINE_LOOP);
+    glVertex3f(x-size, y-size, z-size);
+    glVertex3f(x+size, y-size, z-size);
+    glVertex3f(x+size, y+size, z-size);
+    glVertex3f(x-size, y+size, z-size);
+    glEnd();
+    
+    // Top square
+    glBegin(GL_LINE_LOOP);
+    glVertex3f(x-size, y-size, z+size);
+    glVertex3f(x+size, y-size, z+size);
+    glVertex3f(x+size, y+size, z+size);
+    glVertex3f(x-size, y+size, z+size);
+    glEnd();
+    
+    // Vertical connectors
+    glBegin(GL_LINES);
+    glVertex3f(x-size, y-size, z-size);
+    glVertex3f(x-size, y-size, z+size);
+    glVertex3f(x+size, y-size, z-size);
+    glVertex3f(x+size, y-size, z+size);
+    glVertex3f(x+size, y+size, z-size);
+    glVertex3f(x+size, y+size, z+size);
+    glVertex3f(x-size, y+size, z-size);
+    glVertex3f(x-size, y+size, z+size);
+    glEnd();
+
+    // Tail number above the box, traffic labels win over waypoint labels
+    SubmitLabel(x, y + size * 1.5f, z, tailnum, color, priority + 1);
+}
+
+// ──────────────────────────────────
+// Telemetry bus: a shared memory segment the Qt UI maps read-only. The
+// plugin rewrites it once per sim frame under a seqlock; readers copy what
+// they need and retry if the sequence number changed underneath them.
+// Layout is mirrored in tools/hud_telemetry.py, bump the version on change.
+// ──────────────────────────────────
+static const unsigned g_telemetry_magic   = 0x4D4C4548; // "HELM"
+static const unsigned g_telemetry_version = 1;
+static const int g_telemetry_trail_points = 256;         // newest points kept per trail
+#if IBM
+static const char* g_telemetry_name = "Local\\hudplugin_telemetry";
+#else
+static const char* g_telemetry_name = "/hudplugin_telemetry";
+#endif
+
+struct TelemetryAircraft {
+    double lat, lon;                  // degrees
+    double local_x, local_y, local_z; // OpenGL coordinates, meters
+    float  local_vx, local_vy, local_vz;
+    float  elevation_m, agl_m;
+    float  ias_kt, tas_kt, vs_fpm, mach;
+    float  pitch_deg, roll_deg, heading_deg, aoa_deg;
+};
+
+// Copy of the last published TrafficTable, structure of arrays as well
+struct TelemetryTraffic {
+    unsigned count;
+    unsigned epoch;       // g_traffic.Epoch() of the copy
+    float    time_s;      // sim time the positions are valid for
+    int      worst_index; // -1 = no threat
+    unsigned worst;       // TrafficThreat
+    float x[g_max_traffic], y[g_max_traffic], z[g_max_traffic];
+    float vx[g_max_traffic], vy[g_max_traffic], vz[g_max_traffic];
+    float range_m[g_max_traffic], t_cpa_s[g_max_traffic];
+    int   trail[g_max_traffic];  // index into TelemetryBlock::trails, 0 = none
+    unsigned char threat[g_max_traffic];
+    char  label[g_max_traffic][9];
+};
+
+// Append-only ring: point n lives at pts[n % g_telemetry_trail_points] and
+// the newest is head - 1. A new generation means the trail was reused.
+struct TelemetryTrail {
+    unsigned generation;
+    unsigned head;
+    float    pts[g_telemetry_trail_points][3];
+};
+
+struct TelemetryBlock {
+    unsigned magic;
+    unsigned version;
+    unsigned size;               // sizeof(TelemetryBlock)
+    std::atomic<unsigned> seq;   // odd while the plugin is writing
+    unsigned frame;              // sim frames written
+    float    sim_time_s;
+    TelemetryAircraft aircraft;
+    TelemetryTraffic  traffic;
+    TelemetryTrail    trails[g_max_traffic];
+};
+static_assert(std::atomic<unsigned>::is_always_lock_free, "seqlock counter must be lock free in shared memory");
+
+static TelemetryBlock* g_telemetry = nullptr;
+static unsigned g_telemetry_exported[g_max_traffic]; // trail points already in each ring
+#if IBM
+static HANDLE g_telemetry_mapping = NULL;
+#else
+static int g_telemetry_fd = -1;
+#endif
+
+static bool OpenTelemetryBus()
+{
+    if (g_telemetry) return true;
+    const size_t size = sizeof(TelemetryBlock);
+    void* mem = nullptr;
+#if IBM
+    g_telemetry_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, g_telemetry_name);
+    if (g_telemetry_mapping) mem = MapViewOfFile(g_telemetry_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!mem && g_telemetry_mapping) {
+        CloseHandle(g_telemetry_mapping);
+        g_telemetry_mapping = NULL;
+    }
+#else
+    g_telemetry_fd = shm_open(g_telemetry_name, O_CREAT | O_RDWR, 0644);
+    if (g_telemetry_fd >= 0 && ftruncate(g_telemetry_fd, (off_t)size) == 0) {
+        mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, g_telemetry_fd, 0);
+        if (mem == MAP_FAILED) mem = nullptr;
+    }
+    if (!mem && g_telemetry_fd >= 0) {
+        close(g_telemetry_fd);
+        shm_unlink(g_telemetry_name);
+        g_telemetry_fd = -1;
+    }
+#endif
+    if (!mem) {
+        XPLMDebugString("HUDPlugin: could not create the telemetry shared memory segment.\n");
+        return false;
+    }
+
+    memset(mem, 0, size);
+    g_telemetry = new (mem) TelemetryBlock;
+    g_telemetry->version = g_telemetry_version;
+    g_telemetry->size = (unsigned)size;
+    g_telemetry->traffic.worst_index = -1;
+    memset(g_telemetry_exported, 0, sizeof(g_telemetry_exported));
+    // Readers check the magic last, so a half initialised block is never trusted
+    std::atomic_thread_fence(std::memory_order_release);
+    g_telemetry->magic = g_telemetry_magic;
+    return true;
+}
+
+static void CloseTelemetryBus()
+{
+    if (!g_telemetry) return;
+    // Tell readers the segment is going away before it is unlinked
+    g_telemetry->magic = 0;
+#if IBM
+    UnmapViewOfFile(g_telemetry);
+    CloseHandle(g_telemetry_mapping);
+    g_telemetry_mapping = NULL;
+#else
+    munmap(g_telemetry, sizeof(TelemetryBlock));
+    close(g_telemetry_fd);
+    shm_unlink(g_telemetry_name);
+    g_telemetry_fd = -1;
+#endif
+    g_telemetry = nullptr;
+}
+
+static void WriteTelemetryAircraft(TelemetryAircraft& a)
+{
+    static XPLMDataRef lat_ref   = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef lon_ref   = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    static XPLMDataRef x_ref     = XPLMFindDataRef("sim/flightmodel/position/local_x");
+    static XPLMDataRef y_ref     = XPLMFindDataRef("sim/flightmodel/position/local_y");
+    static XPLMDataRef z_ref     = XPLMFindDataRef("sim/flightmodel/position/local_z");
+    static XPLMDataRef vx_ref    = XPLMFindDataRef("sim/flightmodel/position/local_vx");
+    static XPLMDataRef vy_ref    = XPLMFindDataRef("sim/flightmodel/position/local_vy");
+    static XPLMDataRef vz_ref    = XPLMFindDataRef("sim/flightmodel/position/local_vz");
+    static XPLMDataRef vs_ref    = XPLMFindDataRef("sim/flightmodel/position/vh_ind_fpm");
+    static XPLMDataRef mach_ref  = XPLMFindDataRef("sim/flightmodel/misc/machno");
+
+    a.lat = XPLMGetDatad(lat_ref);
+    a.lon = XPLMGetDatad(lon_ref);
+    a.local_x = XPLMGetDatad(x_ref);
+    a.local_y = XPLMGetDatad(y_ref);
+    a.local_z = XPLMGetDatad(z_ref);
+    a.local_vx = XPLMGetDataf(vx_ref);
+    a.local_vy = XPLMGetDataf(vy_ref);
+    a.local_vz = XPLMGetDataf(vz_ref);
+    a.elevation_m = g_altitude_pa_ref ? XPLMGetDataf(g_altitude_pa_ref) : 0.0f;
+    a.agl_m = g_radar_alt_ref ? XPLMGetDataf(g_radar_alt_ref) : 0.0f;
+    a.ias_kt = g_airspeed_ias_ref ? XPLMGetDataf(g_airspeed_ias_ref) : 0.0f;
+    a.tas_kt = g_airspeed_tas_ref ? XPLMGetDataf(g_airspeed_tas_ref) : 0.0f;
+    a.vs_fpm = XPLMGetDataf(vs_ref);
+    a.mach = XPLMGetDataf(mach_ref);
+    a.pitch_deg = g_pitch_ref ? XPLMGetDataf(g_pitch_ref) : 0.0f;
+    a.roll_deg = g_roll_ref ? XPLMGetDataf(g_roll_ref) : 0.0f;
+    a.heading_deg = gHeadingRef ? XPLMGetDataf(gHeadingRef) : 0.0f;
+    a.aoa_deg = g_aoa_ref ? XPLMGetDataf(g_aoa_ref) : 0.0f;
+}
+
+static void WriteTelemetryTraffic(TelemetryTraffic& out, const TrafficTable& t, unsigned epoch)
+{
+    const int n = t.count;
+    out.count = (unsigned)n;
+    out.epoch = epoch;
+    out.time_s = t.time_s;
+    out.worst = t.worst;
+    out.worst_index = t.worst == THREAT_NONE ? -1 : t.worst_index;
+    memcpy(out.x, t.x, n * sizeof(float));
+    memcpy(out.y, t.y, n * sizeof(float));
+    memcpy(out.z, t.z, n * sizeof(float));
+    memcpy(out.vx, t.vx, n * sizeof(float));
+    memcpy(out.vy, t.vy, n * sizeof(float));
+    memcpy(out.vz, t.vz, n * sizeof(float));
+    memcpy(out.range_m, t.range_m, n * sizeof(float));
+    memcpy(out.t_cpa_s, t.t_cpa_s, n * sizeof(float));
+    memcpy(out.trail, t.trail, n * sizeof(int));
+    memcpy(out.label, t.label, n * sizeof(t.label[0]));
+    for (int k = 0; k < n; ++k) out.threat[k] = (unsigned char)t.threat[k];
+}
+
+// Appends only the trail points pushed since the last frame
+static void WriteTelemetryTrails(TelemetryTrail* rings)
+{
+    for (int i = 1; i < g_max_traffic; ++i) {
+        const AiTrail& trail = g_ai_trails[i];
+        TelemetryTrail& ring = rings[i];
+        if (ring.generation != trail.generation) {
+            ring.generation = trail.generation;
+            ring.head = 0;
+            g_telemetry_exported[i] = 0;
+        }
+        unsigned fresh = trail.pushed - g_telemetry_exported[i];
+        if (fresh == 0) continue;
+        if (fresh > (unsigned)trail.count) fresh = (unsigned)trail.count;
+        if (fresh > (unsigned)g_telemetry_trail_points) fresh = (unsigned)g_telemetry_trail_points;
+        for (unsigned p = trail.count - fresh; p < (unsigned)trail.count; ++p) {
+            const std::array<float, 3>& pt = trail.at((int)p);
+            float* dst = ring.pts[ring.head % g_telemetry_trail_points];
+            dst[0] = pt[0]; dst[1] = pt[1]; dst[2] = pt[2];
+            ++ring.head;
+        }
+        g_telemetry_exported[i] = trail.pushed;
+    }
+}
+
+static float telemetry_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    TelemetryBlock* b = g_telemetry;
+    if (!b) return 0.0f;
+
+    // Traffic is only copied when a new conflict pass was published
+    std::shared_ptr<const TrafficTable> traffic;
+    unsigned epoch = g_traffic.Epoch();
+    if (epoch != b->traffic.epoch) traffic = g_traffic.Acquire();
+
+    unsigned seq = b->seq.load(std::memory_order_relaxed);
+    b->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    b->frame++;
+    b->sim_time_s = XPLMGetElapsedTime();
+    WriteTelemetryAircraft(b->aircraft);
+    if (traffic) WriteTelemetryTraffic(b->traffic, *traffic, epoch);
+    WriteTelemetryTrails(b->trails);
+
+    b->seq.store(seq + 2, std::memory_order_release);
+    return -1.0f;
+}
+// ──────────────────────────────────
+// for drawing S to K
+// ──────────────────────────────────
+// --- Replace all highlighted lines with this ---
+
+// Use static/global waypoints so state is preserved between frames
+static Published<std::vector<Waypoint>> g_custom_waypoints;
+
+//for custom waypoints
+std::vector<Waypoint> g_loaded_waypoints;
+
+static unsigned g_custom_waypoints_load_gen = 0; // newer loads supersede ones still in flight
+
+// Parses on the pool, publishes on the sim thread. A reload from the file
+// watcher is diffed against the route being drawn; an unchanged file, or
+// one caught half written, leaves the current route in place.
+static void LoadCustomWaypointsAsync(const char* filename, bool reload) {
+    if (!reload) {
+        XPLMDebugString("Trying to load waypoints from: ");
+        XPLMDebugString(filename);
+        XPLMDebugString("\n");
+        strcpy(g_waypoint_status, "Loading");
+    }
+
+    std::string path = filename;
+    auto waypoints = std::make_shared<std::vector<Waypoint>>();
+    auto message = std::make_shared<const char*>("");
+    auto ok = std::make_shared<bool>(false);
+    auto diff = std::make_shared<WaypointDiff>();
+    unsigned gen = ++g_custom_waypoints_load_gen;
+    if (!reload) {
+        g_file_watcher.Watch("waypoints", path, [path] { LoadCustomWaypointsAsync(path.c_str(), true); });
+    }
+    g_pool.Submit(
+        [path, waypoints, message, ok, diff, reload] {
+            *ok = LoadCustomWaypoints(path.c_str(), *waypoints, message.get());
+            if (!*ok) return;
+            std::shared_ptr<const std::vector<Waypoint>> previous = reload ? g_custom_waypoints.Acquire() : nullptr;
+            *diff = DiffWaypoints(*waypoints, previous.get());
+        },
+        [waypoints, message, ok, diff, reload, gen] {
+            if (gen != g_custom_waypoints_load_gen) return;
+            if (reload) {
+                if (!*ok) {
+                    XPLMDebugString("Custom waypoint reload failed, keeping the previous route: ");
+                    XPLMDebugString(*message);
+                    strcpy(g_waypoint_status, "Reload failed, kept previous");
+                    return;
+                }
+                if (!diff->Any()) return;
+                g_custom_waypoints.Publish(waypoints);
+                char msg[128];
+                snprintf(msg, sizeof(msg), "Custom waypoints reloaded: %d changed, %d added, %d removed.\n",
+                         diff->changed, diff->added, diff->removed);
+                XPLMDebugString(msg);
+                strcpy(g_waypoint_status, "Reloaded");
+                return;
+            }
+            XPLMDebugString(*message);
+            if (*ok) {
+                g_custom_waypoints.Publish(waypoints);
+                XPLMDebugString("Custom waypoints loaded successfully.\n");
+                strcpy(g_waypoint_status, "Loaded");
+            } else {
+                // Nothing from an earlier load stays on screen
+                g_custom_waypoints.Publish(nullptr);
+                XPLMDebugString("Failed to load custom waypoints.\n");
+                strcpy(g_waypoint_status, "Failed");
+            }
+        });
+}
+
+static size_t CustomWaypointCount() {
+    std::shared_ptr<const std::vector<Waypoint>> route = g_custom_waypoints.Acquire();
+    return route ? route->size() : 0;
+}
+
+// callback for drawing custom waypoints
+static void DrawCustomWaypointsLayer()
+{
+    std::shared_ptr<const std::vector<Waypoint>> route = g_custom_waypoints.Acquire();
+    if (!route || route->empty()) return;
+    const std::vector<Waypoint>& waypoints = *route;
+
+    // Draw lines and boxes similar to Seattle to Kelowna
+    int n = (int)waypoints.size();
+    FrameVector<std::array<double, 3>> box_xyz(n);
+
+    for (int i = 0; i < n; ++i) {
+        XPLMWorldToLocal(
+            waypoints[i].lat,
+            waypoints[i].lon,
+            waypoints[i].alt_m,
+            &box_xyz[i][0], &box_xyz[i][1], &box_xyz[i][2]);
+    }
+
+    // Draw line strip
+    glColor4f(0.0f, 1.0f, 1.0f, 0.7f); // Cyan, semi-transparent
+    SetLineWidth(2.0f);
+    glBegin(GL_LINE_STRIP);
+    for (int i = 0; i < n; ++i) {
+        glVertex3f((float)box_xyz[i][0], (float)box_xyz[i][1], (float)box_xyz[i][2]);
+    }
+    glEnd();
+
+    // Draw boxes, far ones only when quality allows
+    static XPLMDataRef lat_ref = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef lon_ref = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    double ac_lat = XPLMGetDatad(lat_ref), ac_lon = XPLMGetDatad(lon_ref);
+    double route_box_m = Quality().route_box_m;
+    for (int i = 0; i < n; ++i) {
+        if (haversine_m(ac_lat, ac_lon, waypoints[i].lat, waypoints[i].lon) > route_box_m) continue;
+        double box_x = box_xyz[i][0];
+        double box_y = box_xyz[i][1];
+        double box_z = box_xyz[i][2];
+
+        double next_box_x = box_x, next_box_y = box_y, next_box_z = box_z;
+        float heading_to_next = waypoints[i].heading_to_next;
+        if (i < n - 1) {
+            next_box_x = box_xyz[i+1][0];
+            next_box_y = box_xyz[i+1][1];
+            next_box_z = box_xyz[i+1][2];
+        }
+
+        DrawLandingBox(
+            (float)box_x, (float)box_y, (float)box_z,
+            60.0f, 30.0f,
+            waypoints[i].direction,
+            (float)next_box_x, (float)next_box_y, (float)next_box_z,
+            heading_to_next
+        );
+    }
+}
+
+// ──────────────────────────────────
+// Route library: the route files in Resources/plugins/routes/ (.wpt or
+// .txt, one "lat lon alt_m direction" line per waypoint) are listed in the
+// Route Library menu. Picking one compiles it on the pool into a
+// CompiledRoute (densified legs, spatial index) unless it is still cached,
+// and the file after it is compiled behind it so stepping through the list
+// does not wait. Compiled routes and their local OpenGL positions stay in
+// an LRU cache bounded by g_route_cache_budget_bytes; the shown route is
+// never evicted.
+// ──────────────────────────────────
+static size_t g_route_cache_budget_bytes = 8u << 20; // compiled routes kept in memory
+static double g_route_densify_m = 2000.0;            // max distance between leg points
+static double g_route_cell_deg = 0.1;                // spatial index cell size
+static double g_route_draw_range_m = 80000.0;        // route line drawn out to this distance
+
+struct RouteLibraryEntry {
+    std::string name; // file name, also the menu item
+    std::string path;
+    int    menu_item;
+    std::shared_ptr<const CompiledRoute> route; // NULL until compiled, or after eviction
+    bool   compiling;
+    bool   failed;
+    size_t bytes;     // compiled route plus local positions
+    int    last_used; // g_route_library_frame
+    // Local OpenGL position of every route point, redone when the origin moves
+    std::vector<float> local_xyz;
+    int    local_epoch;
+};
+
+static std::vector<RouteLibraryEntry> g_route_library;
+static int        g_route_library_shown = -1;
+static int        g_route_library_frame = 0;
+static size_t     g_route_library_bytes = 0;
+static unsigned   g_route_library_gen = 0; // bumped on rescan, compiles for the old list are dropped
+
+
+static std::string RouteLibraryDirectory()
+{
+    char sys_path[512];
+    XPLMGetSystemPath(sys_path);
+    const char* sep = XPLMGetDirectorySeparator();
+    return std::string(sys_path) + "Resources" + sep + "plugins" + sep + "routes" + sep;
+}
+
+static void UpdateRouteBytes(RouteLibraryEntry& e)
+{
+    g_route_library_bytes -= e.bytes;
+    e.bytes = e.route ? e.route->Bytes() + e.local_xyz.capacity() * sizeof(float) : 0;
+    g_route_library_bytes += e.bytes;
+}
+
+// Drops least recently used compiled routes until under budget
+static void EvictRoutes()
+{
+    while (g_route_library_bytes > g_route_cache_budget_bytes) {
+        int oldest = -1;
+        for (int i = 0; i < (int)g_route_library.size(); ++i) {
+            const RouteLibraryEntry& e = g_route_library[i];
+            if (!e.route || i == g_route_library_shown) continue;
+            if (oldest < 0 || e.last_used < g_route_library[oldest].last_used) oldest = i;
+        }
+        if (oldest < 0) return;
+        RouteLibraryEntry& e = g_route_library[oldest];
+        e.route.reset();
+        std::vector<float>().swap(e.local_xyz);
+        UpdateRouteBytes(e);
+    }
+}
+
+// Queues a compile of entry i unless it is cached, queued or known bad
+static void RequestLibraryRoute(int i)
+{
+    RouteLibraryEntry& e = g_route_library[i];
+    e.last_used = g_route_library_frame;
+    if (e.route || e.compiling || e.failed) return;
+    e.compiling = true;
+
+    std::string path = e.path;
+    double spacing_m = g_route_densify_m;
+    double cell_deg = g_route_cell_deg;
+    unsigned gen = g_route_library_gen;
+    auto route = std::make_shared<CompiledRoute>();
+    auto message = std::make_shared<const char*>("");
+    auto ok = std::make_shared<bool>(false);
+    g_pool.Submit(
+        [path, spacing_m, cell_deg, route, message, ok] {
+            *ok = CompileRoute(path.c_str(), spacing_m, cell_deg, *route, message.get());
+        },
+        [i, gen, route, message, ok] {
+            if (gen != g_route_library_gen) return;
+            RouteLibraryEntry& e = g_route_library[i];
+            e.compiling = false;
+            if (!*ok) {
+                e.failed = true;
+                // Loader messages carry their own newline, compile messages may not
+                std::string line = "HUDPlugin: route " + e.name + ": " + *message;
+                if (line.back() != '\n') line += '\n';
+                XPLMDebugString(line.c_str());
+                return;
+            }
+            e.route = route;
+            // Sized here so the draw path only overwrites it when the origin moves
+            e.local_xyz.resize(route->points.size() * 3);
+            e.local_epoch = -1;
+            UpdateRouteBytes(e);
+            EvictRoutes();
+        });
+}
+
+static void CheckRouteMenu()
+{
+    for (int i = 0; i < (int)g_route_library.size(); ++i) {
+        XPLMCheckMenuItem(g_route_menu, g_route_library[i].menu_item,
+                          i == g_route_library_shown ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+    }
+}
+
+// Picking the shown route again hides it
+static void ShowLibraryRoute(int i)
+{
+    g_route_library_shown = i == g_route_library_shown ? -1 : i;
+    bool shown = g_route_library_shown >= 0;
+    CheckRouteMenu();
+    if (!shown) return;
+
+    RequestLibraryRoute(i);
+    if (i + 1 < (int)g_route_library.size()) RequestLibraryRoute(i + 1);
+}
+
+// Lists the route files and rebuilds the menu. Cached routes are dropped so
+// edited files are picked up; the shown route is reselected by name.
+static void ScanRouteLibrary()
+{
+    std::string shown = g_route_library_shown >= 0 ? g_route_library[g_route_library_shown].name : "";
+    if (g_route_library_shown >= 0) ShowLibraryRoute(g_route_library_shown);
+    ++g_route_library_gen;
+    g_route_library.clear();
+    g_route_library_bytes = 0;
+
+    std::string dir = RouteLibraryDirectory();
+    std::vector<std::string> files;
+    char names[8192];
+    char* indices[256];
+    int first = 0;
+    for (;;) {
+        int total = 0, returned = 0;
+        int done = XPLMGetDirectoryContents(dir.c_str(), first, names, sizeof(names), indices, 256, &total, &returned);
+        for (int k = 0; k < returned; ++k) files.push_back(indices[k]);
+        first += returned;
+        if (done || returned == 0) break;
+    }
+    std::sort(files.begin(), files.end());
+
+    XPLMClearAllMenuItems(g_route_menu);
+    XPLMAppendMenuItem(g_route_menu, "Rescan Routes", (void*)(intptr_t)-1, 1);
+    XPLMAppendMenuSeparator(g_route_menu);
+    int reshow = -1;
+    for (const std::string& name : files) {
+        size_t dot = name.find_last_of('.');
+        std::string ext = dot == std::string::npos ? "" : name.substr(dot);
+        if (ext != ".wpt" && ext != ".txt") continue;
+        int i = (int)g_route_library.size();
+        RouteLibraryEntry e = { name, dir + name, 0, nullptr, false, false, 0, 0, {}, -1 };
+        g_route_library.push_back(e);
+        g_route_library[i].menu_item = XPLMAppendMenuItem(g_route_menu, name.c_str(), (void*)(intptr_t)i, 1);
+        if (name == shown) reshow = i;
+    }
+
+    char msg[256];
+    snprintf(msg, sizeof(msg), "HUDPlugin: %d routes in %s\n", (int)g_route_library.size(), dir.c_str());
+    XPLMDebugString(msg);
+    if (reshow >= 0) ShowLibraryRoute(reshow);
+    else CheckRouteMenu();
+}
+
+// Call after the pool has stopped, pending compiles will never complete
+static void StopRouteLibrary()
+{
+    ++g_route_library_gen;
+    for (RouteLibraryEntry& e : g_route_library) e.compiling = false;
+}
+
+static void route_menu_handler(void* in_menu_ref, void* in_item_ref)
+{
+    int item = (int)(intptr_t)in_item_ref;
+    if (item < 0) ScanRouteLibrary();
+    else if (item < (int)g_route_library.size()) ShowLibraryRoute(item);
+}
+
+static void DrawRouteLibraryLayer()
+{
+    ++g_route_library_frame;
+    RouteLibraryEntry& e = g_route_library[g_route_library_shown];
+    e.last_used = g_route_library_frame;
+    if (!e.route) return; // still compiling
+    const CompiledRoute& route = *e.route;
+
+    int epoch = LocalOriginEpoch();
+    if (e.local_epoch != epoch) {
+        for (size_t k = 0; k < route.points.size(); ++k) {
+            const RouteVertex& p = route.points[k];
+            double x, y, z;
+            XPLMWorldToLocal(p.lat, p.lon, p.alt_m, &x, &y, &z);
+            e.local_xyz[3 * k + 0] = (float)x;
+            e.local_xyz[3 * k + 1] = (float)y;
+            e.local_xyz[3 * k + 2] = (float)z;
+        }
+        e.local_epoch = epoch;
+    }
+    const float* xyz = e.local_xyz.data();
+
+    static XPLMDataRef lat_ref = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef lon_ref = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    double ac_lat = XPLMGetDatad(lat_ref), ac_lon = XPLMGetDatad(lon_ref);
+    double ac_cos_lat = cos(ac_lat * M_PI / 180.0);
+
+    // Only the legs near the aircraft, from the spatial index
+    FrameVector<int> segments;
+    route.SegmentsNear(ac_lat, ac_lon, g_route_draw_range_m, segments);
+    glColor4f(1.0f, 0.5f, 0.0f, 0.7f); // Orange, semi-transparent
+    SetLineWidth(2.0f);
+    glBegin(GL_LINES);
+    for (int s : segments) {
+        glVertex3fv(xyz + 3 * s);
+        glVertex3fv(xyz + 3 * (s + 1));
+    }
+    glEnd();
+
+    // Waypoint boxes, far ones only when quality allows
+    double route_box_m = Quality().route_box_m;
+    int n = (int)route.waypoints.size();
+    for (int i = 0; i < n; ++i) {
+        const Waypoint& wp = route.waypoints[i];
+        const RouteVertex& p = route.points[route.waypoint_point[i]];
+        if (haversine_m(ac_lat, ac_lon, ac_cos_lat, p.lat, p.lon, p.cos_lat) > route_box_m) continue;
+        const float* box = xyz + 3 * route.waypoint_point[i];
+        const float* next = i < n - 1 ? xyz + 3 * route.waypoint_point[i + 1] : box;
+        DrawLandingBox(
+            box[0], box[1], box[2],
+            60.0f, 30.0f,
+            wp.direction,
+            next[0], next[1], next[2],
+            wp.heading_to_next
+        );
+    }
+}
+
+// Seattle to Kelowna route, baked from assets/seattle_to_kelowna.wpt with
+// trig, bearings and leg lengths precomputed
+static const BakedWaypoint* const g_waypoints = g_baked_seattle_to_kelowna;
+
+// Add at file scope:
+static const int g_num_waypoints = g_baked_seattle_to_kelowna_count;
+static RouteProgress g_route;
+
+static void DrawSeattleToKelownaLayer()
+{
+    // Get aircraft position
+    float ac_lat = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/latitude"));
+    float ac_lon = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/longitude"));
+    double ac_cos_lat = cos(ac_lat * M_PI / 180.0);
+
+    // Waypoint sequencing runs in guidance_flight_loop. No active waypoint
+    // means all are passed, or one was passed this frame and its box is not drawn.
+    if (g_route.active == -1) return;
+
+    // Flashing logic (1 Hz flash)
+    double now = XPLMGetElapsedTime();
+    bool flash = ((int)(now * 1.0) % 2) == 0;
+
+    // --- Store all box positions for line drawing ---
+    double box_xyz[g_num_waypoints][3];
+    for (int i = 0; i < g_num_waypoints; ++i) {
+        XPLMWorldToLocal(g_waypoints[i].lat, g_waypoints[i].lon, g_waypoints[i].alt_m, &box_xyz[i][0], &box_xyz[i][1], &box_xyz[i][2]);
+    }
+
+    // --- Draw lines connecting the boxes ---
+    glColor4f(1.0f, 1.0f, 0.0f, 0.7f); // Yellow, semi-transparent
+    SetLineWidth(2.0f);
+    glBegin(GL_LINE_STRIP);
+    for (int i = 0; i < g_num_waypoints; ++i) {
+        glVertex3f((float)box_xyz[i][0], (float)box_xyz[i][1], (float)box_xyz[i][2]);
+    }
+    glEnd();
+
+    // --- Draw the boxes as before, far ones only when quality allows ---
+    double route_box_m = Quality().route_box_m;
+    for (int i = 0; i < g_num_waypoints; ++i) {
+        if (i != g_route.active && haversine_m(ac_lat, ac_lon, ac_cos_lat, g_waypoints[i]) > route_box_m) continue;
+        double box_x = box_xyz[i][0];
+        double box_y = box_xyz[i][1];
+        double box_z = box_xyz[i][2];
+
+        // Next box (or repeat current if last)
+        double next_box_x = box_x, next_box_y = box_y, next_box_z = box_z;
+        float heading_to_next = 0.0f;
+        if (i < g_num_waypoints - 1) {
+            next_box_x = box_xyz[i+1][0];
+            next_box_y = box_xyz[i+1][1];
+            next_box_z = box_xyz[i+1][2];
+            heading_to_next = (float)g_waypoints[i].bearing_deg;
+        }
+
+        if (i == g_route.active) {
+            if (flash) {
+                DrawLandingBox(
+                    (float)box_x, (float)box_y, (float)box_z,
+                    60.0f, 30.0f,
+                    g_waypoints[i].direction,
+                    (float)next_box_x, (float)next_box_y, (float)next_box_z,
+                    heading_to_next
+                );
+            }
+        } else {
+            DrawLandingBox(
+                (float)box_x, (float)box_y, (float)box_z,
+                60.0f, 30.0f,
+                g_waypoints[i].direction,
+                (float)next_box_x, (float)next_box_y, (float)next_box_z,
+                heading_to_next
+            );
+        }
+    }
+}
+
+// ──────────────────────────────────
+// Guidance state: values the HUD and route callbacks draw from, computed
+// once per frame before drawing and published as datarefs under
+// hudplugin/guidance/ so other plugins and the UI read them instead of
+// recomputing them.
+// ──────────────────────────────────
+struct GuidanceState {
+    float runway_dist_m;       // to the nearer runway end
+    float vertical_dev_m;      // radar altitude above the landing assist path, + = too high
+    float lateral_offset_m;    // from the runway centerline, + = east
+    int   active_waypoint;     // Seattle to Kelowna, -1 = none
+    int   waypoints_passed;
+    float waypoint_dist_m;     // to the active waypoint, -1 = none
+    float heading_to_next_deg; // bearing of the leg leaving the active waypoint
+    float nearest_traffic_m;   // -1 = no traffic
+    int   traffic_count;
+    float traffic_range_m[g_max_traffic];
+    float traffic_t_cpa_s[g_max_traffic];
+    int   traffic_threat[g_max_traffic]; // TrafficThreat
+};
+static GuidanceState g_guidance;
+static std::vector<XPLMDataRef> g_guidance_refs;
+
+static void UpdateRunwayGuidance(float ac_lat, float ac_lon, float radalt_m)
+{
+    // Path starts at the radar altitude the landing assist was switched on at
+    if (g_landing_assist_visible && !radout_init_set) {
+        radout_init = radalt_m;
+        radout_init_set = true;
+    }
+    RunwayEnds runway = { lat1, lon1, lat2, lon2 };
+    RunwayGuidance g = ComputeRunwayGuidance(runway, ac_lat, ac_lon, radalt_m, radout_init);
+    g_guidance.runway_dist_m = (float)g.runway_dist_m;
+    g_guidance.vertical_dev_m = (float)g.vertical_dev_m;
+    g_guidance.lateral_offset_m = (float)g.lateral_offset_m;
+}
+
+// Waypoint sequencing for the Seattle to Kelowna route, runs while it is shown
+static void UpdateRouteProgress(float ac_lat, float ac_lon)
+{
+    if (g_route.passed.size() != (size_t)g_num_waypoints) g_route.Reset(g_num_waypoints);
+    double ac_cos_lat = cos(ac_lat * M_PI / 180.0);
+    g_route.Update([&](int i) { return haversine_m(ac_lat, ac_lon, ac_cos_lat, g_waypoints[i]); });
+}
+
+static float guidance_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    static XPLMDataRef lat_ref = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef lon_ref = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    float ac_lat = XPLMGetDataf(lat_ref);
+    float ac_lon = XPLMGetDataf(lon_ref);
+    float radalt_m = g_radar_alt_ref ? XPLMGetDataf(g_radar_alt_ref) : 0.0f;
+
+    UpdateRunwayGuidance(ac_lat, ac_lon, radalt_m);
+
+    if (g_seattle_to_kelowna_visible) UpdateRouteProgress(ac_lat, ac_lon);
+    g_guidance.active_waypoint = g_route.active;
+    g_guidance.waypoints_passed = g_route.PassedCount();
+    bool active = g_route.active >= 0;
+    g_guidance.waypoint_dist_m = (active && g_route.prev_dist < 1e9) ? (float)g_route.prev_dist : -1.0f;
+    g_guidance.heading_to_next_deg = active ? (float)g_waypoints[g_route.active].bearing_deg : 0.0f;
+
+    // Traffic is copied only when a new conflict pass was published
+    static unsigned traffic_epoch = 0;
+    if (g_traffic.Epoch() != traffic_epoch) {
+        traffic_epoch = g_traffic.Epoch();
+        std::shared_ptr<const TrafficTable> traffic = g_traffic.Acquire();
+        const int n = traffic ? traffic->count : 0;
+        float nearest = -1.0f;
+        for (int k = 0; k < n; ++k) {
+            float r = traffic->range_m[k];
+            g_guidance.traffic_range_m[k] = r;
+            g_guidance.traffic_t_cpa_s[k] = traffic->t_cpa_s[k];
+            g_guidance.traffic_threat[k] = (int)traffic->threat[k];
+            if (nearest < 0.0f || r < nearest) nearest = r;
+        }
+        g_guidance.traffic_count = n;
+        g_guidance.nearest_traffic_m = nearest;
+    }
+    return -1.0f;
+}
+
+// ─── Dataref accessors, plain reads of g_guidance ───
+
+static float GetGuidanceFloat(void* inRefcon) { return *(const float*)inRefcon; }
+static int GetGuidanceInt(void* inRefcon) { return *(const int*)inRefcon; }
+
+static int GetTrafficFloats(const float* values, float* outValues, int inOffset, int inMax)
+{
+    int count = g_guidance.traffic_count;
+    if (!outValues) return count;
+    int n = inOffset < count ? std::min(inMax, count - inOffset) : 0;
+    if (n > 0) memcpy(outValues, values + inOffset, n * sizeof(float));
+    return n;
+}
+static int GetTrafficRange(void* inRefcon, float* outValues, int inOffset, int inMax)
+{
+    return GetTrafficFloats(g_guidance.traffic_range_m, outValues, inOffset, inMax);
+}
+static int GetTrafficTcpa(void* inRefcon, float* outValues, int inOffset, int inMax)
+{
+    return GetTrafficFloats(g_guidance.traffic_t_cpa_s, outValues, inOffset, inMax);
+}
+static int GetTrafficThreat(void* inRefcon, int* outValues, int inOffset, int inMax)
+{
+    int count = g_guidance.traffic_count;
+    if (!outValues) return count;
+    int n = inOffset < count ? std::min(inMax, count - inOffset) : 0;
+    if (n > 0) memcpy(outValues, g_guidance.traffic_threat + inOffset, n * sizeof(int));
+    return n;
+}
+
+static void RegisterGuidanceFloat(const char* name, float* value)
+{
+    g_guidance_refs.push_back(XPLMRegisterDataAccessor(name, xplmType_Float, 0,
+        NULL, NULL, GetGuidanceFloat, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, value, NULL));
+}
+
+static void RegisterGuidanceInt(const char* name, int* value)
+{
+    g_guidance_refs.push_back(XPLMRegisterDataAccessor(name, xplmType_Int, 0,
+        GetGuidanceInt, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, value, NULL));
+}
+
+static void RegisterGuidanceDataRefs()
+{
+    memset(&g_guidance, 0, sizeof(g_guidance));
+    g_guidance.active_waypoint = -1;
+    g_guidance.waypoint_dist_m = -1.0f;
+    g_guidance.nearest_traffic_m = -1.0f;
+
+    RegisterGuidanceFloat("hudplugin/guidance/runway_dist_m", &g_guidance.runway_dist_m);
+    RegisterGuidanceFloat("hudplugin/guidance/vertical_dev_m", &g_guidance.vertical_dev_m);
+    RegisterGuidanceFloat("hudplugin/guidance/lateral_offset_m", &g_guidance.lateral_offset_m);
+    RegisterGuidanceInt("hudplugin/guidance/active_waypoint", &g_guidance.active_waypoint);
+    RegisterGuidanceInt("hudplugin/guidance/waypoints_passed", &g_guidance.waypoints_passed);
+    RegisterGuidanceFloat("hudplugin/guidance/waypoint_dist_m", &g_guidance.waypoint_dist_m);
+    RegisterGuidanceFloat("hudplugin/guidance/heading_to_next_deg", &g_guidance.heading_to_next_deg);
+    RegisterGuidanceFloat("hudplugin/traffic/nearest_m", &g_guidance.nearest_traffic_m);
+    RegisterGuidanceInt("hudplugin/traffic/count", &g_guidance.traffic_count);
+    g_guidance_refs.push_back(XPLMRegisterDataAccessor("hudplugin/traffic/range_m", xplmType_FloatArray, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, GetTrafficRange, NULL, NULL, NULL, NULL, NULL));
+    g_guidance_refs.push_back(XPLMRegisterDataAccessor("hudplugin/traffic/t_cpa_s", xplmType_FloatArray, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, GetTrafficTcpa, NULL, NULL, NULL, NULL, NULL));
+    g_guidance_refs.push_back(XPLMRegisterDataAccessor("hudplugin/traffic/threat", xplmType_IntArray, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, GetTrafficThreat, NULL, NULL, NULL, NULL, NULL, NULL, NULL));
+}
+
+static void UnregisterGuidanceDataRefs()
+{
+    for (XPLMDataRef ref : g_guidance_refs) XPLMUnregisterDataAccessor(ref);
+    g_guidance_refs.clear();
+}
+
+// ──────────────────────────────────
+// Instructor station stream: HUD inputs, route progress and traffic sent
+// over UDP at a fixed rate. Every field is quantized to an integer and only
+// fields that changed since the last send go out, as zigzag varint deltas.
+// Records never straddle datagrams, so each datagram can be applied on its
+// own; a periodic keyframe of absolute records lets a receiver that lost a
+// datagram resynchronise. tools/instructor_receiver.py documents the wire
+// format and stands in for the station on the loopback interface.
+// ──────────────────────────────────
+static const char* g_instructor_host       = "127.0.0.1";
+static int         g_instructor_port       = 49101;
+static float       g_instructor_rate_hz    = 10.0f;
+static float       g_instructor_keyframe_s = 2.0f;
+static const int   g_instructor_mtu        = 1200;       // datagram payload bytes
+static const int   g_instructor_max_record = 96;         // worst case record size (own ship)
+static const unsigned g_instructor_magic   = 0x49445548; // "HUDI"
+static const unsigned char g_instructor_version = 1;
+
+// Own ship fields, in wire order, with their quantization step
+enum InstructorField {
+    IF_LAT, IF_LON,          // 1e-7 deg
+    IF_ELEVATION, IF_AGL,    // 0.1 m
+    IF_IAS, IF_TAS,          // 0.1 kt
+    IF_VS,                   // 1 ft/min
+    IF_MACH,                 // 0.001
+    IF_PITCH, IF_ROLL, IF_HEADING, IF_AOA, // 0.01 deg
+    IF_ROUTE_ACTIVE,         // active waypoint index, -1 = none
+    IF_ROUTE_PASSED,         // waypoints passed
+    IF_ROUTE_DIST,           // 1 m to the active waypoint, -1 = unknown
+    IF_THREAT,               // worst TrafficThreat
+    IF_COUNT
+};
+
+// Traffic record field mask
+enum {
+    TF_LAT = 1, TF_LON = 2, TF_ALT = 4, TF_THREAT = 8, TF_TCPA = 16, TF_LABEL = 32,
+    TF_ABSOLUTE = 64, // values are not deltas
+    TF_REMOVED = 128
+};
+
+struct InstructorTarget {
+    bool live;
+    int  lat, lon, alt, threat, t_cpa; // 1e-7 deg, 1 m, TrafficThreat, 0.1 s
+    unsigned generation;               // trail slot generation, a new one is a new target
+};
+
+struct InstructorStream {
+    FeedSocket    sock;
+    sockaddr_in   to;
+    unsigned      seq;      // datagrams sent
+    unsigned short snapshot;
+    float         next_keyframe;
+    int           own[IF_COUNT];
+    InstructorTarget targets[g_max_traffic]; // by trail index
+    bool          seen[g_max_traffic];
+    unsigned char buf[g_instructor_mtu];
+    int           len;
+    bool          keyframe;
+    double        bytes_sent;
+};
+static InstructorStream g_instructor;
+
+static int QuantizeField(double v, double step) { return (int)lround(v / step); }
+
+static void PutInstructorByte(InstructorStream& s, unsigned v) { s.buf[s.len++] = (unsigned char)v; }
+
+static void PutInstructorVarint(InstructorStream& s, unsigned v)
+{
+    while (v >= 0x80) {
+        s.buf[s.len++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    s.buf[s.len++] = (unsigned char)v;
+}
+
+// Wrapping difference, zigzagged so small negative deltas stay short
+static void PutInstructorDelta(InstructorStream& s, int now, int before)
+{
+    unsigned d = (unsigned)now - (unsigned)before;
+    PutInstructorVarint(s, (d << 1) ^ (0u - (d >> 31)));
+}
+
+static void BeginInstructorDatagram(InstructorStream& s)
+{
+    s.len = 0;
+    for (int i = 0; i < 4; ++i) PutInstructorByte(s, g_instructor_magic >> (8 * i));
+    PutInstructorByte(s, g_instructor_version);
+    PutInstructorByte(s, s.keyframe ? 1 : 0);
+    PutInstructorByte(s, s.snapshot);
+    PutInstructorByte(s, s.snapshot >> 8);
+    for (int i = 0; i < 4; ++i) PutInstructorByte(s, s.seq >> (8 * i));
+}
+
+static const int g_instructor_header = 12;
+
+static void FlushInstructorDatagram(InstructorStream& s)
+{
+    if (s.len > g_instructor_header) {
+        int sent = (int)sendto(s.sock, (const char*)s.buf, s.len, 0, (const sockaddr*)&s.to, sizeof(s.to));
+        // A full send buffer drops the datagram, the next keyframe repairs it
+        if (sent > 0) s.bytes_sent += sent;
+        ++s.seq;
+    }
+    BeginInstructorDatagram(s);
+}
+
+static void ReserveInstructorRecord(InstructorStream& s)
+{
+    if (s.len + g_instructor_max_record > g_instructor_mtu) FlushInstructorDatagram(s);
+}
+
+static void PutOwnShipRecord(InstructorStream& s, const int (&q)[IF_COUNT])
+{
+    unsigned mask = 0;
+    for (int f = 0; f < IF_COUNT; ++f) {
+        if (s.keyframe || q[f] != s.own[f]) mask |= 1u << f;
+    }
+    if (!mask) return;
+    ReserveInstructorRecord(s);
+    PutInstructorByte(s, s.keyframe ? 'A' : 'a');
+    PutInstructorVarint(s, mask);
+    for (int f = 0; f < IF_COUNT; ++f) {
+        if (!(mask & (1u << f))) continue;
+        PutInstructorDelta(s, q[f], s.keyframe ? 0 : s.own[f]);
+        s.own[f] = q[f];
+    }
+}
+
+static void PutTrafficRecord(InstructorStream& s, int key, const InstructorTarget& q, const char* label)
+{
+    InstructorTarget& last = s.targets[key];
+    // A feed trail can be handed to another target between two sends,
+    // the new one needs its label and no deltas from the old one
+    bool absolute = s.keyframe || !last.live || q.generation != last.generation;
+    unsigned mask = absolute ? (TF_LAT | TF_LON | TF_ALT | TF_THREAT | TF_TCPA | TF_LABEL | TF_ABSOLUTE) : 0;
+    if (!absolute) {
+        if (q.lat != last.lat) mask |= TF_LAT;
+        if (q.lon != last.lon) mask |= TF_LON;
+        if (q.alt != last.alt) mask |= TF_ALT;
+        if (q.threat != last.threat) mask |= TF_THREAT;
+        if (q.t_cpa != last.t_cpa) mask |= TF_TCPA;
+        if (!mask) return;
+    }
+    ReserveInstructorRecord(s);
+    PutInstructorByte(s, 'T');
+    PutInstructorVarint(s, (unsigned)key);
+    PutInstructorByte(s, mask);
+    InstructorTarget base = absolute ? InstructorTarget{ true, 0, 0, 0, 0, 0, 0 } : last;
+    if (mask & TF_LAT)    PutInstructorDelta(s, q.lat, base.lat);
+    if (mask & TF_LON)    PutInstructorDelta(s, q.lon, base.lon);
+    if (mask & TF_ALT)    PutInstructorDelta(s, q.alt, base.alt);
+    if (mask & TF_THREAT) PutInstructorDelta(s, q.threat, base.threat);
+    if (mask & TF_TCPA)   PutInstructorDelta(s, q.t_cpa, base.t_cpa);
+    if (mask & TF_LABEL) {
+        size_t n = strnlen(label, 8);
+        PutInstructorByte(s, (unsigned)n);
+        memcpy(s.buf + s.len, label, n);
+        s.len += (int)n;
+    }
+    last = q;
+    last.live = true;
+}
+
+static float instructor_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    InstructorStream& s = g_instructor;
+    if (s.sock == g_no_socket) return 0.0f;
+
+    float now = XPLMGetElapsedTime();
+    s.keyframe = now >= s.next_keyframe;
+    if (s.keyframe) s.next_keyframe = now + g_instructor_keyframe_s;
+    ++s.snapshot;
+    BeginInstructorDatagram(s);
+
+    // Same inputs the HUD and the route callback work from, see guidance_flight_loop
+    TelemetryAircraft a;
+    WriteTelemetryAircraft(a);
+    std::shared_ptr<const TrafficTable> traffic = g_traffic.Acquire();
+
+    int q[IF_COUNT];
+    q[IF_LAT]          = QuantizeField(a.lat, 1e-7);
+    q[IF_LON]          = QuantizeField(a.lon, 1e-7);
+    q[IF_ELEVATION]    = QuantizeField(a.elevation_m, 0.1);
+    q[IF_AGL]          = QuantizeField(a.agl_m, 0.1);
+    q[IF_IAS]          = QuantizeField(a.ias_kt, 0.1);
+    q[IF_TAS]          = QuantizeField(a.tas_kt, 0.1);
+    q[IF_VS]           = QuantizeField(a.vs_fpm, 1.0);
+    q[IF_MACH]         = QuantizeField(a.mach, 0.001);
+    q[IF_PITCH]        = QuantizeField(a.pitch_deg, 0.01);
+    q[IF_ROLL]         = QuantizeField(a.roll_deg, 0.01);
+    q[IF_HEADING]      = QuantizeField(a.heading_deg, 0.01);
+    q[IF_AOA]          = QuantizeField(a.aoa_deg, 0.01);
+    q[IF_ROUTE_ACTIVE] = g_guidance.active_waypoint;
+    q[IF_ROUTE_PASSED] = g_guidance.waypoints_passed;
+    q[IF_ROUTE_DIST]   = g_guidance.waypoint_dist_m < 0.0f ? -1 : QuantizeField(g_guidance.waypoint_dist_m, 1.0);
+    q[IF_THREAT]       = traffic ? (int)traffic->worst : 0;
+    PutOwnShipRecord(s, q);
+
+    if (traffic) {
+        const TrafficTable& t = *traffic;
+        for (int k = 0; k < t.count; ++k) {
+            int key = t.trail[k];
+            if (key <= 0) continue; // no stable identity without a trail
+            double lat, lon, alt;
+            XPLMLocalToWorld(t.x[k], t.y[k], t.z[k], &lat, &lon, &alt);
+            InstructorTarget target = {
+                true, QuantizeField(lat, 1e-7), QuantizeField(lon, 1e-7), QuantizeField(alt, 1.0),
+                (int)t.threat[k], QuantizeField(t.t_cpa_s[k], 0.1), t.trail_gen[k]
+            };
+            PutTrafficRecord(s, key, target, t.label[k]);
+            s.seen[key] = true;
+        }
+    }
+    for (int key = 1; key < g_max_traffic; ++key) {
+        if (s.targets[key].live && !s.seen[key]) {
+            ReserveInstructorRecord(s);
+            PutInstructorByte(s, 'T');
+            PutInstructorVarint(s, (unsigned)key);
+            PutInstructorByte(s, TF_REMOVED);
+            s.targets[key].live = false;
+        }
+        s.seen[key] = false;
+    }
 
-        // Convert to local OpenGL coordinates
-        double x1L, y1L, z1L, x2L, y2L, z2L;
-        double x1R, y1R, z1R, x2R, y2R, z2R;
-        XPLMWorldToLocal(lat1L, lon1L, elev_m, &x1L, &y1L, &z1L);
-        XPLMWorldToLocal(lat2L, lon2L, elev_m, &x2L, &y2L, &z2L);
-        XPLMWorldToLocal(lat1R, lon1R, elev_m, &x1R, &y1R, &z1R);
-        XPLMWorldToLocal(lat2R, lon2R, elev_m, &x2R, &y2R, &z2R);
+    FlushInstructorDatagram(s);
+    return 1.0f / g_instructor_rate_hz;
+}
 
-        // Draw the two edge lines in 3D
-        glColor4f(0.0f, 1.0f, 0.0f, 1.0f);
-        glLineWidth(4.0f);
-        glBegin(GL_LINES);
-        glVertex3f((float)x1L, (float)y1L, (float)z1L);
-        glVertex3f((float)x2L, (float)y2L, (float)z2L);
-        glVertex3f((float)x1R, (float)y1R, (float)z1R);
-        glVertex3f((float)x2R, (float)y2R, (float)z2R);
-        glEnd();
-        glLineWidth(1.0f);
+static bool StartInstructorStream()
+{
+#if IBM
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    InstructorStream& s = g_instructor;
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons((unsigned short)g_instructor_port);
+    FeedSocket sock = g_no_socket;
+    if (inet_pton(AF_INET, g_instructor_host, &to.sin_addr) == 1) {
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    }
+    bool ok = sock != g_no_socket;
+#if IBM
+    u_long nonblocking = 1;
+    ok = ok && ioctlsocket(sock, FIONBIO, &nonblocking) == 0;
+    if (!ok) { if (sock != g_no_socket) closesocket(sock); WSACleanup(); return false; }
+#else
+    ok = ok && fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) == 0;
+    if (!ok) { if (sock != g_no_socket) close(sock); return false; }
+#endif
+    memset(&s, 0, sizeof(s));
+    s.sock = sock;
+    s.to = to;
+    s.next_keyframe = 0.0f; // first snapshot is a keyframe
+    g_instructor_stream_active = true;
+    XPLMRegisterFlightLoopCallback(instructor_flight_loop, -1.0f, NULL);
+    return true;
+}
 
-        // ──────────────────────────────
-        // Drawing centerline
-        // ──────────────────────────────
+static void StopInstructorStream()
+{
+    InstructorStream& s = g_instructor;
+    if (!g_instructor_stream_active) return;
+    g_instructor_stream_active = false;
+    XPLMUnregisterFlightLoopCallback(instructor_flight_loop, NULL);
+#if IBM
+    closesocket(s.sock);
+    WSACleanup();
+#else
+    close(s.sock);
+#endif
+    s.sock = g_no_socket;
 
-        // Calculate the centerline coordinates (midpoint between left and right edges)
-        double lat1C = (lat1L + lat1R) / 2.0;
-        double lon1C = (lon1L + lon1R) / 2.0;
-        double lat2C = (lat2L + lat2R) / 2.0;
-        double lon2C = (lon2L + lon2R) / 2.0;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Instructor stream stopped: %u datagrams, %.0f kB.\n", s.seq, s.bytes_sent / 1024.0);
+    XPLMDebugString(msg);
+}
 
-        double x1C, y1C, z1C, x2C, y2C, z2C;
-        XPLMWorldToLocal(lat1C, lon1C, elev_m, &x1C, &y1C, &z1C);
-        XPLMWorldToLocal(lat2C, lon2C, elev_m, &x2C, &y2C, &z2C);
+// ──────────────────────────────────
+// Session recorder: own ship and traffic written at a fixed rate to
+// Resources/plugins/session_<date>_<time>.csv, in the session log format
+// tools/flight_analysis.cpp scores and tools/hud_replay.cpp replays:
+//     own,time_s,lat,lon,elevation_m,agl_m,track_deg,gs_mps,vs_mps
+//     time_s,id,lat,lon,alt_m,track_deg,gs_mps,vs_mps,callsign
+// Traffic lines are in the feed format, keyed by trail slot like the
+// instructor stream, so a replay feeds them back through "Replay Recorded
+// Traffic". Times count from the start of the recording.
+// ──────────────────────────────────
+static float g_session_record_hz = 4.0f;
 
-        // Draw the centerline in a different color (e.g., white)
-        glColor4f(1.0f, 1.0f, 1.0f, 1.0f); // White
-        glLineWidth(2.0f);  
-        glBegin(GL_LINES);
-            glVertex3f((float)x1C, (float)y1C, (float)z1C);
-            glVertex3f((float)x2C, (float)y2C, (float)z2C);
-        glEnd();
-        glLineWidth(1.0f);
+static FILE* g_session_file = NULL;
+static float g_session_start_s = 0.0f;
+static unsigned g_session_traffic_epoch = 0;
+static int g_session_samples = 0;
 
-        // ──────────────────────────────
-        // Draw a 2D "fly-through" box above the runway threshold
-        // ──────────────────────────────
+static float session_record_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    if (!g_session_file) return 0.0f;
+    static XPLMDataRef lat_ref   = XPLMFindDataRef("sim/flightmodel/position/latitude");
+    static XPLMDataRef lon_ref   = XPLMFindDataRef("sim/flightmodel/position/longitude");
+    static XPLMDataRef elev_ref  = XPLMFindDataRef("sim/flightmodel/position/elevation");
+    static XPLMDataRef agl_ref   = XPLMFindDataRef("sim/flightmodel/position/y_agl");
+    static XPLMDataRef track_ref = XPLMFindDataRef("sim/flightmodel/position/hpath");
+    static XPLMDataRef gs_ref    = XPLMFindDataRef("sim/flightmodel/position/groundspeed");
+    static XPLMDataRef vs_ref    = XPLMFindDataRef("sim/flightmodel/position/vh_ind");
+
+    float now = XPLMGetElapsedTime();
+    fprintf(g_session_file, "own,%.2f,%.7f,%.7f,%.1f,%.1f,%.1f,%.1f,%.2f\n", now - g_session_start_s,
+            XPLMGetDatad(lat_ref), XPLMGetDatad(lon_ref), XPLMGetDatad(elev_ref), XPLMGetDataf(agl_ref),
+            XPLMGetDataf(track_ref), XPLMGetDataf(gs_ref), XPLMGetDataf(vs_ref));
+    ++g_session_samples;
+
+    // Traffic is only written when a new conflict pass was published
+    unsigned epoch = g_traffic.Epoch();
+    std::shared_ptr<const TrafficTable> traffic = epoch != g_session_traffic_epoch ? g_traffic.Acquire() : nullptr;
+    if (traffic) {
+        g_session_traffic_epoch = epoch;
+        const TrafficTable& t = *traffic;
+        for (int k = 0; k < t.count; ++k) {
+            int key = t.trail[k];
+            if (key <= 0) continue; // no stable identity without a trail
+            double lat, lon, alt;
+            XPLMLocalToWorld(t.x[k], t.y[k], t.z[k], &lat, &lon, &alt);
+            double track = atan2(t.vx[k], -t.vz[k]) * 180.0 / M_PI;
+            if (track < 0.0) track += 360.0;
+            fprintf(g_session_file, "%.2f,%d,%.7f,%.7f,%.1f,%.1f,%.1f,%.2f,%s\n", t.time_s - g_session_start_s, key,
+                    lat, lon, alt, track, hypot(t.vx[k], t.vz[k]), t.vy[k], t.label[k]);
+        }
+    }
+    return 1.0f / g_session_record_hz;
+}
 
-        // Box center: 100 meters above north threshold (lat1, lon1)
-        // Box center: 100 meters above north threshold (lat1, lon1)
-        double box_lat = 47.495;
-        double box_lon = lon1;
-        double box_elev_m = elev_m + 300.0; // 100 meters above runway
+static bool StartSessionRecording()
+{
+    char sys_path[512];
+    XPLMGetSystemPath(sys_path);
+    const char* sep = XPLMGetDirectorySeparator();
+    char name[64];
+    time_t wall = time(NULL);
+    strftime(name, sizeof(name), "session_%Y%m%d_%H%M%S.csv", localtime(&wall));
+    std::string path = std::string(sys_path) + "Resources" + sep + "plugins" + sep + name;
+    g_session_file = fopen(path.c_str(), "w");
+    if (!g_session_file) return false;
+    setvbuf(g_session_file, NULL, _IOFBF, 1 << 16); // one write every few minutes of flight
+    fprintf(g_session_file, "# HUDPlugin session, see tools/flight_analysis.cpp for the format\n");
+    g_session_start_s = XPLMGetElapsedTime();
+    g_session_traffic_epoch = g_traffic.Epoch(); // the first pass written is one made while recording
+    g_session_samples = 0;
+    g_session_recording_active = true;
+    XPLMRegisterFlightLoopCallback(session_record_flight_loop, -1.0f, NULL);
+
+    XPLMDebugString("Recording session to: ");
+    XPLMDebugString(path.c_str());
+    XPLMDebugString("\n");
+    return true;
+}
 
-        // Convert box center to local coordinates
-        double box_x, box_y, box_z;
-        XPLMWorldToLocal(box_lat, box_lon, box_elev_m, &box_x, &box_y, &box_z);
+static void StopSessionRecording()
+{
+    if (!g_session_recording_active) return;
+    g_session_recording_active = false;
+    XPLMUnregisterFlightLoopCallback(session_record_flight_loop, NULL);
+    fclose(g_session_file);
+    g_session_file = NULL;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Session recording stopped: %d own ship samples.\n", g_session_samples);
+    XPLMDebugString(msg);
+}
 
-        // Box size (meters)
-        float box_w = 30.0f;
-        float box_h = 30.0f;
+// ──────────────────────────────────
+// HUD readout cache: a text field is only reformatted and laid out again
+// when its displayed (rounded) value changes, at most refresh_s apart
+// ──────────────────────────────────
+struct HudReadout {
+    const char* format;    // printf format, gets the rounded value (and value * aux_scale)
+    double      step;      // display resolution, e.g. 1 for "%.0f", 0.1 for "%.1f"
+    float       refresh_s; // minimum seconds between reformats, 0 = every change
+    double      aux_scale; // optional second argument, e.g. meters to feet
+    bool        valid = false;
+    double      shown = 0.0;     // value currently in text
+    float       last_update = 0.0f;
+    char        text[64] = "";
+    int         width_px = 0;    // laid out width in pixels (basic font is 8 px per char)
+};
 
-        // Draw the box as a wireframe square in the XY plane (facing forward)
-        glColor4f(1.0f, 1.0f, 0.0f, 1.0f); // Yellow
-        glLineWidth(3.0f);
-        glBegin(GL_LINE_LOOP);
-            glVertex3f((float)(box_x - box_w/2), (float)(box_y - box_h/2), (float)box_z);
-            glVertex3f((float)(box_x + box_w/2), (float)(box_y - box_h/2), (float)box_z);
-            glVertex3f((float)(box_x + box_w/2), (float)(box_y + box_h/2), (float)box_z);
-            glVertex3f((float)(box_x - box_w/2), (float)(box_y + box_h/2), (float)box_z);
-        glEnd();
-        glLineWidth(1.0f);
+enum HudReadoutId {
+    HUD_RO_IAS_BOX,
+    HUD_RO_IAS,
+    HUD_RO_TAS,
+    HUD_RO_VS,
+    HUD_RO_MACH,
+    HUD_RO_PALT,
+    HUD_RO_RALT,
+    HUD_RO_AOA,
+    HUD_RO_HDG,
+    HUD_RO_RWY_DIST,
+    HUD_RO_DBG_WPT_STATUS,
+    HUD_RO_DBG_WPT_COUNT,
+    HUD_RO_DBG_ZONE_STATUS,
+    HUD_RO_DBG_TRAFFIC_FEED,
+    HUD_RO_QUALITY,
+    HUD_RO_COUNT
+};
 
-        // Calculate center point between runway endpoints
-        double box2_lat = 47.485;
-        double box2_lon = lon1;
-        double box2_elev_m = elev_m + 200.0; // 300 meters above runway
+// Per-field refresh rates, tune here
+static HudReadout g_hud_readouts[HUD_RO_COUNT] = {
+    { "(%.0f)",                        1.0,  0.10f, 0.0 },
+    { "IAS: %.0f kt",                  1.0,  0.10f, 0.0 },
+    { "TAS: %.0f kt",                  1.0,  0.10f, 0.0 },
+    { "V/S: %.1f m/s",                 0.1,  0.20f, 0.0 },
+    { "Mach %.2f",                     0.01, 0.20f, 0.0 },
+    { "P ALT: %.0f ft",                1.0,  0.10f, 0.0 },
+    { "R ALT: %.0f ft",                1.0,  0.10f, 0.0 },
+    { "AOA: %.1f°",                    0.1,  0.20f, 0.0 },
+    { "HDG: %.0f°",                    1.0,  0.10f, 0.0 },
+    { "Runway Dist: %.0f m (%.0f ft)", 1.0,  0.25f, 3.28084 },
+    { "Waypoint Load: %s",             0.0,  0.0f,  0.0 },
+    { "Custom Waypoints: %.0f",        1.0,  0.0f,  0.0 },
+    { "Zone Load: %s",                 0.0,  0.0f,  0.0 },
+    { "Traffic Feed: %.0f targets",    1.0,  0.5f,  0.0 },
+    { "Quality: %s",                   0.0,  0.0f,  0.0 },
+};
 
-        // Convert box center to local coordinates
-        double box2_x, box2_y, box2_z;
-        XPLMWorldToLocal(box2_lat, box2_lon, box2_elev_m, &box2_x, &box2_y, &box2_z);
+// Returns the cached text for a numeric field, reformatting only on change
+static const char* HudReadoutText(HudReadoutId id, double value, float now)
+{
+    HudReadout& r = g_hud_readouts[id];
+    double rounded = floor(value / r.step + 0.5) * r.step;
 
-        // Box size (meters)
-        float box2_w = 30.0f;
-        float box2_h = 30.0f;
+    if (r.valid) {
+        if (rounded == r.shown) return r.text;
+        if (now - r.last_update < r.refresh_s) return r.text;
+    }
 
-        // Draw the box as a wireframe square in the XY plane (facing forward)
-        glColor4f(1.0f, 0.5f, 0.0f, 1.0f); // Orange for distinction
-        glLineWidth(3.0f);
-        glBegin(GL_LINE_LOOP);
-            glVertex3f((float)(box2_x - box2_w/2), (float)(box2_y - box2_h/2), (float)box2_z);
-            glVertex3f((float)(box2_x + box2_w/2), (float)(box2_y - box2_h/2), (float)box2_z);
-            glVertex3f((float)(box2_x + box2_w/2), (float)(box2_y + box2_h/2), (float)box2_z);
-            glVertex3f((float)(box2_x - box2_w/2), (float)(box2_y + box2_h/2), (float)box2_z);
-        glEnd();
-        glLineWidth(1.0f);
+    snprintf(r.text, sizeof(r.text), r.format, rounded, rounded * r.aux_scale);
+    r.shown = rounded;
+    r.last_update = now;
+    r.valid = true;
+    r.width_px = static_cast<int>(strlen(r.text)) * 8;
+    return r.text;
+}
+
+// Same as above for string fields (load status lines)
+static const char* HudReadoutText(HudReadoutId id, const char* value, float now)
+{
+    HudReadout& r = g_hud_readouts[id];
+    static char s_sources[HUD_RO_COUNT][64];
+
+    if (r.valid) {
+        if (!strcmp(s_sources[id], value)) return r.text;
+        if (now - r.last_update < r.refresh_s) return r.text;
     }
 
-    return 1.0f;
+    snprintf(s_sources[id], sizeof(s_sources[id]), "%s", value);
+    snprintf(r.text, sizeof(r.text), r.format, value);
+    r.last_update = now;
+    r.valid = true;
+    r.width_px = static_cast<int>(strlen(r.text)) * 8;
+    return r.text;
+}
+
+// Pitch ladder labels never change, format them once
+static const char* PitchLadderLabel(int deg)
+{
+    static char s_labels[(90 + 30) / 5 + 1][8];
+    static bool s_built = false;
+    if (!s_built) {
+        for (int d = -30; d <= 90; d += 5) {
+            snprintf(s_labels[(d + 30) / 5], sizeof(s_labels[0]), (d > 0 ? "+%d" : "%d"), d);
+        }
+        s_built = true;
+    }
+    return s_labels[(deg + 30) / 5];
 }
+
 // ──────────────────────────────────
-// traffic
+// HUD layout: where each HUD element sits is data, not code. The built-in
+// layout is baked from assets/hud_layout.hud; a hud_layout.hud in the
+// aircraft's folder, else in Resources/plugins, overrides it row by row
+// at load. For a given screen the layout is compiled once into vertex
+// batches: what never moves is drawn from static batches, and each moving
+// part (horizon, pitch ladder, compass rose, needles) is a batch built in
+// its own frame that the HUD only positions with a transform every frame.
 // ──────────────────────────────────
-static int draw_aircraft_highlight_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon) {
-    if (!g_aircraft_highlight_visible) return 1;
-
-    double user_lat = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/latitude"));
-    double user_lon = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/longitude"));
-    double user_alt = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/elevation"));
-    double user_x, user_y, user_z;
-    XPLMWorldToLocal(user_lat, user_lon, user_alt, &user_x, &user_y, &user_z);
-
-    for (int i = 1; i <= 19; i++) {
-        char lat_refname[64], lon_refname[64], alt_refname[64];
-        snprintf(lat_refname, sizeof(lat_refname), "sim/multiplayer/position/plane%d_lat", i);
-        snprintf(lon_refname, sizeof(lon_refname), "sim/multiplayer/position/plane%d_lon", i);
-        snprintf(alt_refname, sizeof(alt_refname), "sim/multiplayer/position/plane%d_el", i);
-
-        XPLMDataRef lat_ref = XPLMFindDataRef(lat_refname);
-        XPLMDataRef lon_ref = XPLMFindDataRef(lon_refname);
-        XPLMDataRef alt_ref = XPLMFindDataRef(alt_refname);
-
-        if (lat_ref && lon_ref && alt_ref) {
-            double lat = XPLMGetDataf(lat_ref);
-            double lon = XPLMGetDataf(lon_ref);
-            double alt = XPLMGetDataf(alt_ref);
-            double x, y, z;
-            XPLMWorldToLocal(lat, lon, alt, &x, &y, &z);
+enum HudElementId {
+    HUD_EL_SPEED_SCALE,
+    HUD_EL_IAS,
+    HUD_EL_TAS,
+    HUD_EL_VS_LEFT,
+    HUD_EL_MACH,
+    HUD_EL_PALT,
+    HUD_EL_RALT,
+    HUD_EL_VS,
+    HUD_EL_AOA,
+    HUD_EL_LADDER,
+    HUD_EL_LADDER_FLOOR,
+    HUD_EL_LADDER_CEILING,
+    HUD_EL_NOSE,
+    HUD_EL_COMPASS,
+    HUD_EL_HEADING,
+    HUD_EL_BRACKET,
+    HUD_EL_LATERAL,
+    HUD_EL_RUNWAY_DIST,
+    HUD_EL_DEBUG,
+    HUD_EL_TAWS_ALERT,
+    HUD_EL_TRAFFIC_ALERT,
+    HUD_EL_COUNT
+};
 
-            float dx = (float)(x - user_x);
-            float dy = (float)(y - user_y);
-            float dz = (float)(z - user_z);
-            float dist_km = sqrtf(dx*dx + dy*dy + dz*dz) / 1000.0f;
+// Row names in hud_layout.hud, in HudElementId order
+static const char* const g_hud_element_names[HUD_EL_COUNT] = {
+    "speed_scale", "ias", "tas", "vs_left", "mach", "palt", "ralt", "vs", "aoa",
+    "ladder", "ladder_floor", "ladder_ceiling", "nose", "compass", "heading",
+    "bracket", "lateral", "runway_dist", "debug", "taws_alert", "traffic_alert",
+};
 
-            // Determine color based on distance
-            float color[3];
-            if (dist_km < 1.0f) {
-                color[0] = 1.0f; color[1] = 0.0f; color[2] = 0.0f;
-            }
-            else if (dist_km < 2.0f) {
-                float t = (dist_km - 1.0f) / 1.0f;
-                color[0] = 1.0f;
-                color[1] = 0.5f * t;
-                color[2] = 0.0f;
-            }
-            else {
-                color[0] = 0.0f; color[1] = 1.0f; color[2] = 0.0f;
-            }
+struct HudElementSpec {
+    BakedHudAnchor anchor;
+    float x, y, w, h;
+};
+static HudElementSpec g_hud_layout[HUD_EL_COUNT];
+static unsigned       g_hud_layout_gen = 0; // bumped on every (re)load
+
+// Shape details the layout does not expose
+static const float g_hud_max_airspeed    = 488.0f; // top of the speed scale
+static const float g_hud_low_speed_kt    = 130.0f; // top of the low-speed bar
+static const int   g_hud_ladder_min_deg  = -30;
+static const int   g_hud_ladder_max_deg  = 90;
+static const int   g_hud_ladder_step_deg = 5;
+static const float g_hud_ladder_gap      = 25.0f;  // gap between the two halves of a rung
+static const int   g_hud_rung_verts      = 8;      // shadow and line for both halves
+
+static int HudElementByName(const char* name)
+{
+    for (int i = 0; i < HUD_EL_COUNT; ++i) {
+        if (!strcmp(g_hud_element_names[i], name)) return i;
+    }
+    return -1;
+}
 
-            char tailnum[32] = "N12345";
-            draw_highlight_box((float)x, (float)y, (float)z, color, tailnum);
+static bool HudAnchorByName(const std::string& name, BakedHudAnchor& anchor)
+{
+    if (name == "center") anchor = HUD_ANCHOR_CENTER;
+    else if (name == "bottom") anchor = HUD_ANCHOR_BOTTOM;
+    else if (name == "bottom_left") anchor = HUD_ANCHOR_BOTTOM_LEFT;
+    else if (name == "top") anchor = HUD_ANCHOR_TOP;
+    else return false;
+    return true;
+}
 
-            // ────── TRAIL LOGIC ──────
-            // Scale trail length: closer = shorter, farther = longer
-            int max_trail_points = 10 + (int)(dist_km * 600.0f);
-            if (max_trail_points > 1000) max_trail_points = 1000;
-            if (max_trail_points < 10) max_trail_points = 10;
-            // ...existing code...
-
-            auto& trail = g_ai_trails[i];
-            trail.push_back({(float)x, (float)y, (float)z});
-            while ((int)trail.size() > max_trail_points) trail.pop_front();
-
-            // Draw the trail as a line strip
-            glColor4f(color[0], color[1], color[2], 0.7f);
-            glLineWidth(2.0f);
-            glBegin(GL_LINE_STRIP);
-            for (const auto& pt : trail) {
-                glVertex3f(pt[0], pt[1], pt[2]);
-            }
-            glEnd();
-            glLineWidth(1.0f);
+// Applies the rows of a layout file over the current layout. Like the route
+// files, reading stops at the first malformed line; unknown elements are
+// skipped. Returns false if the file cannot be opened.
+static bool ReadHudLayoutFile(const std::string& path, int& rows)
+{
+    std::ifstream infile(path);
+    if (!infile) return false;
+
+    char msg[640];
+    std::string line;
+    int line_no = 0;
+    while (std::getline(infile, line)) {
+        ++line_no;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        std::istringstream fields(line);
+        std::string name, anchor;
+        HudElementSpec spec;
+        if (!(fields >> name >> anchor >> spec.x >> spec.y >> spec.w >> spec.h) ||
+            !HudAnchorByName(anchor, spec.anchor)) {
+            snprintf(msg, sizeof(msg), "HUDPlugin: %s:%d: bad HUD layout row, rest of the file ignored.\n", path.c_str(), line_no);
+            XPLMDebugString(msg);
+            break;
+        }
+        int id = HudElementByName(name.c_str());
+        if (id < 0) {
+            snprintf(msg, sizeof(msg), "HUDPlugin: %s:%d: unknown HUD element '%s'.\n", path.c_str(), line_no, name.c_str());
+            XPLMDebugString(msg);
+            continue;
         }
+        g_hud_layout[id] = spec;
+        ++rows;
     }
-    return 1;
+    return true;
 }
 
-// Modified to accept color parameter
-static void draw_highlight_box(float x, float y, float z, const float color[3], const char* tailnum) {
-    const float size = 5.0f; // Box size in meters
-    
-    glColor3fv(color); // Use the passed color
-    glLineWidth(2.0f);
-    
-    // Bottom square
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(x-size, y-size, z-size);
-    glVertex3f(x+size, y-size, z-size);
-    glVertex3f(x+size, y+size, z-size);
-    glVertex3f(x-size, y+size, z-size);
-    glEnd();
-    
-    // Top square
-    glBegin(GL_LINE_LOOP);
-    glVertex3f(x-size, y-size, z+size);
-    glVertex3f(x+size, y-size, z+size);
-    glVertex3f(x+size, y+size, z+size);
-    glVertex3f(x-size, y+size, z+size);
-    glEnd();
-    
-    // Vertical connectors
-    glBegin(GL_LINES);
-    glVertex3f(x-size, y-size, z-size);
-    glVertex3f(x-size, y-size, z+size);
-    glVertex3f(x+size, y-size, z-size);
-    glVertex3f(x+size, y-size, z+size);
-    glVertex3f(x+size, y+size, z-size);
-    glVertex3f(x+size, y+size, z+size);
-    glVertex3f(x-size, y+size, z-size);
-    glVertex3f(x-size, y+size, z+size);
-    glEnd();
+// The loaded aircraft's own layout if it has one, else the shared one
+static std::string HudLayoutPath()
+{
+    const char* sep = XPLMGetDirectorySeparator();
+    char acf_file[256] = "";
+    char acf_path[512] = "";
+    XPLMGetNthAircraftModel(0, acf_file, acf_path);
+    std::string acf = acf_path;
+    size_t slash = acf.find_last_of(sep);
+    if (slash != std::string::npos) {
+        std::string path = acf.substr(0, slash + 1) + "hud_layout.hud";
+        if (std::ifstream(path)) return path;
+    }
+
+    char sys_path[512];
+    XPLMGetSystemPath(sys_path);
+    return std::string(sys_path) + "Resources" + sep + "plugins" + sep + "hud_layout.hud";
 }
-// ──────────────────────────────────
-// for drawing S to K
-// ──────────────────────────────────
-// --- Replace all highlighted lines with this ---
 
-// Use static/global waypoints so state is preserved between frames
-struct Waypoint {
-    double lat, lon, alt_m;
-    int direction; // 1 = up arrow, 0 = dot, -1 = down arrow
+// The file is a few dozen lines, it is read on the sim thread. Called at
+// enable, when an aircraft loads and by the file watcher.
+static void LoadHudLayout(bool reload)
+{
+    // Baked rows first, a file only lists what it changes
+    for (int i = 0; i < g_baked_hud_layout_count; ++i) {
+        const BakedHudElement& e = g_baked_hud_layout[i];
+        int id = HudElementByName(e.name);
+        if (id >= 0) g_hud_layout[id] = HudElementSpec{ e.anchor, e.x, e.y, e.w, e.h };
+    }
+
+    std::string path = HudLayoutPath();
+    int rows = 0;
+    if (ReadHudLayoutFile(path, rows)) {
+        char msg[640];
+        snprintf(msg, sizeof(msg), "HUDPlugin: HUD layout from %s, %d elements overridden.\n", path.c_str(), rows);
+        XPLMDebugString(msg);
+    }
+    ++g_hud_layout_gen;
+
+    if (!reload) {
+        g_file_watcher.Watch("hud_layout", path, [] { LoadHudLayout(true); });
+    }
+}
+
+struct HudVertex {
+    float   x, y;
+    GLubyte rgba[4];
 };
-std::vector<Waypoint> g_custom_waypoints;
 
-//for custom waypoints
-std::vector<Waypoint> g_loaded_waypoints;
+// A run of vertices drawn with one call
+struct HudBatch {
+    GLenum mode;
+    float  line_width;
+    int    first, count;
+};
 
-bool LoadCustomWaypoints(const char* filename) {
-    g_custom_waypoints.clear();
-    XPLMDebugString("Trying to load waypoints from: ");
-    XPLMDebugString(filename);
-    XPLMDebugString("\n");
-    std::ifstream infile(filename);
-    if (!infile) {
-        XPLMDebugString("File not found or could not be opened.\n");
-        return false;
+// Element resolved to screen pixels
+struct HudPlacement {
+    float x, y, w, h;
+};
+
+struct HudStaticText {
+    float x, y;
+    char  text[16];
+};
+
+struct HudCompiledLayout {
+    unsigned layout_gen;
+    int      width, height;
+    unsigned revision; // bumped on every compile, keys the static layer texture
+    bool     valid;
+    HudPlacement at[HUD_EL_COUNT];
+
+    std::vector<HudVertex>     verts;
+    std::vector<HudBatch>      static_batches; // screen space
+    std::vector<HudBatch>      assist_batches; // screen space, landing assist only
+    std::vector<HudStaticText> static_text;
+
+    HudBatch horizon;      // ladder frame: origin on the ladder, rolled, shifted by pitch
+    HudBatch ladder;       // ladder frame, rungs from min to max degree
+    HudBatch compass_rose; // origin at the compass center, turned by heading
+    HudBatch ias_needle;   // origin at the bottom of the speed scale, shifted by airspeed
+    HudBatch gs_arrow;     // origin at the bracket center, shifted by glide path deviation
+    HudBatch lateral_ball; // origin at the lateral bar center, shifted by lateral offset
+
+    GLuint vbo; // 0 = drawn from verts
+};
+static HudCompiledLayout g_hud_compiled = {};
+
+// Appends vertices to the compiled layout one batch at a time
+class HudBatchBuilder {
+public:
+    explicit HudBatchBuilder(HudCompiledLayout& c) : m_c(c), m_batch{ GL_LINES, 1.0f, 0, 0 } {}
+
+    void Begin(GLenum mode, float line_width = 1.0f) {
+        m_batch = HudBatch{ mode, line_width, (int)m_c.verts.size(), 0 };
     }
-    double lat, lon, alt;
-    int dir;
-    while (infile >> lat >> lon >> alt >> dir) {
-        g_custom_waypoints.push_back({lat, lon, alt, dir});
+    void Color(float r, float g, float b, float a) {
+        m_rgba[0] = (GLubyte)(r * 255.0f + 0.5f);
+        m_rgba[1] = (GLubyte)(g * 255.0f + 0.5f);
+        m_rgba[2] = (GLubyte)(b * 255.0f + 0.5f);
+        m_rgba[3] = (GLubyte)(a * 255.0f + 0.5f);
     }
-    if (g_custom_waypoints.empty()) {
-        XPLMDebugString("File loaded but no waypoints found.\n");
-        return false;
+    void Vertex(float x, float y) {
+        m_c.verts.push_back(HudVertex{ x, y, { m_rgba[0], m_rgba[1], m_rgba[2], m_rgba[3] } });
+        ++m_batch.count;
     }
-    XPLMDebugString("Waypoints loaded successfully.\n");
-    return true;
-}
+    void Line(float x1, float y1, float x2, float y2) {
+        Vertex(x1, y1);
+        Vertex(x2, y2);
+    }
+    HudBatch End() { return m_batch; }
 
-// callback for drawing custom waypoints
-static float draw_custom_waypoints_callback(
-    XPLMDrawingPhase inPhase,
-    int inIsBefore,
-    void* inRefcon)
+private:
+    HudCompiledLayout& m_c;
+    HudBatch m_batch;
+    GLubyte  m_rgba[4] = { 255, 255, 255, 255 };
+};
+
+static HudPlacement PlaceHudElement(const HudElementSpec& e, int screen_w, int screen_h)
 {
-    if (!g_custom_waypoints_visible || g_custom_waypoints.empty()) return 1.0f;
+    float ax = screen_w * 0.5f, ay = screen_h * 0.5f;
+    switch (e.anchor) {
+    case HUD_ANCHOR_CENTER:                             break;
+    case HUD_ANCHOR_BOTTOM:      ay = 0.0f;             break;
+    case HUD_ANCHOR_BOTTOM_LEFT: ax = 0.0f; ay = 0.0f;  break;
+    case HUD_ANCHOR_TOP:         ay = (float)screen_h;  break;
+    }
+    return HudPlacement{ ax + e.x, ay + e.y, e.w, e.h };
+}
 
-    // Draw lines and boxes similar to Seattle to Kelowna
-    int n = (int)g_custom_waypoints.size();
-    std::vector<std::array<double, 3>> box_xyz(n);
+// The compass rings are compiled once per layout, so they keep full tessellation at every quality level
+static const int g_hud_compass_segments = 64;
 
-    for (int i = 0; i < n; ++i) {
-        XPLMWorldToLocal(
-            g_custom_waypoints[i].lat,
-            g_custom_waypoints[i].lon,
-            g_custom_waypoints[i].alt_m,
-            &box_xyz[i][0], &box_xyz[i][1], &box_xyz[i][2]);
+// Circle as GL_LINES pairs so it can share a batch with other lines
+static void AddHudCircle(HudBatchBuilder& b, float cx, float cy, float radius, int segments)
+{
+    for (int i = 0; i < segments; ++i) {
+        float a0 = i * 2.0f * (float)M_PI / segments;
+        float a1 = (i + 1) * 2.0f * (float)M_PI / segments;
+        b.Line(cx + cosf(a0) * radius, cy + sinf(a0) * radius, cx + cosf(a1) * radius, cy + sinf(a1) * radius);
     }
+}
 
-    // Draw line strip
-    glColor4f(0.0f, 1.0f, 1.0f, 0.7f); // Cyan, semi-transparent
-    glLineWidth(2.0f);
-    glBegin(GL_LINE_STRIP);
-    for (int i = 0; i < n; ++i) {
-        glVertex3f((float)box_xyz[i][0], (float)box_xyz[i][1], (float)box_xyz[i][2]);
+static void CompileHudLayout(int screen_w, int screen_h)
+{
+    HudCompiledLayout& c = g_hud_compiled;
+    for (int i = 0; i < HUD_EL_COUNT; ++i) c.at[i] = PlaceHudElement(g_hud_layout[i], screen_w, screen_h);
+    if (c.at[HUD_EL_LADDER].h <= 0.0f) c.at[HUD_EL_LADDER].h = 1.0f; // pixels per degree
+    c.verts.clear();
+    c.static_batches.clear();
+    c.assist_batches.clear();
+    c.static_text.clear();
+    HudBatchBuilder b(c);
+
+    const HudPlacement& speed = c.at[HUD_EL_SPEED_SCALE];
+    const HudPlacement& compass = c.at[HUD_EL_COMPASS];
+    const HudPlacement& nose = c.at[HUD_EL_NOSE];
+    const HudPlacement& bracket = c.at[HUD_EL_BRACKET];
+    const HudPlacement& lateral = c.at[HUD_EL_LATERAL];
+    const HudPlacement& ladder = c.at[HUD_EL_LADDER];
+    float speed_bottom = speed.y - speed.h / 2;
+    float speed_top = speed.y + speed.h / 2;
+    int segments = g_hud_compass_segments;
+
+    // Static: speed scale line, compass outer circle and inner ring
+    b.Begin(GL_LINES);
+    b.Color(0.0f, 1.0f, 0.0f, 1.0f);
+    b.Line(speed.x, speed_bottom, speed.x, speed_top);
+    b.Color(0.0f, 1.0f, 0.0f, 0.9f);
+    AddHudCircle(b, compass.x, compass.y, compass.w, segments);
+    b.Color(0.0f, 1.0f, 0.0f, 0.3f);
+    AddHudCircle(b, compass.x, compass.y, compass.w - 4.0f, segments);
+    c.static_batches.push_back(b.End());
+
+    // Low-speed bar (0 to g_hud_low_speed_kt)
+    float low_speed_top = speed_bottom + (g_hud_low_speed_kt / g_hud_max_airspeed) * speed.h;
+    b.Begin(GL_QUADS);
+    b.Color(0.0f, 1.0f, 0.0f, 1.0f);
+    b.Vertex(speed.x - speed.w, speed_bottom);
+    b.Vertex(speed.x + speed.w, speed_bottom);
+    b.Vertex(speed.x + speed.w, low_speed_top);
+    b.Vertex(speed.x - speed.w, low_speed_top);
+    c.static_batches.push_back(b.End());
+
+    // "|__|" nose marker
+    b.Begin(GL_LINES, 2.0f);
+    b.Color(0.0f, 1.0f, 0.0f, 0.9f);
+    b.Line(nose.x - nose.w, nose.y - nose.h, nose.x - nose.w, nose.y + nose.h);
+    b.Line(nose.x - nose.w, nose.y, nose.x + nose.w, nose.y);
+    b.Line(nose.x + nose.w, nose.y - nose.h, nose.x + nose.w, nose.y + nose.h);
+    c.static_batches.push_back(b.End());
+
+    // Heading pointer on top of the compass
+    b.Begin(GL_TRIANGLES);
+    b.Color(0.0f, 1.0f, 0.0f, 0.9f);
+    b.Vertex(compass.x, compass.y + compass.w + 12.0f);
+    b.Vertex(compass.x - 6.0f, compass.y + compass.w);
+    b.Vertex(compass.x + 6.0f, compass.y + compass.w);
+    c.static_batches.push_back(b.End());
+
+    HudStaticText top_label = { speed.x - 30.0f, speed_top - 6.0f, "" };
+    snprintf(top_label.text, sizeof(top_label.text), "%.0f", g_hud_max_airspeed);
+    c.static_text.push_back(top_label);
+    c.static_text.push_back(HudStaticText{ speed.x - 20.0f, speed_bottom - 6.0f, "0" });
+
+    // Landing assist: E-bracket frame, lateral deviation bar and its center mark
+    b.Begin(GL_LINES, 3.0f);
+    b.Color(0.0f, 1.0f, 0.0f, 1.0f);
+    b.Line(bracket.x - bracket.w, bracket.y + bracket.h, bracket.x + bracket.w, bracket.y + bracket.h);
+    b.Line(bracket.x - bracket.w, bracket.y + bracket.h, bracket.x - bracket.w, bracket.y - bracket.h);
+    b.Line(bracket.x - bracket.w, bracket.y, bracket.x + bracket.w, bracket.y);
+    b.Line(bracket.x - bracket.w, bracket.y - bracket.h, bracket.x + bracket.w, bracket.y - bracket.h);
+    b.Line(lateral.x - lateral.w, lateral.y, lateral.x + lateral.w, lateral.y);
+    c.assist_batches.push_back(b.End());
+    b.Begin(GL_LINES, 2.0f);
+    b.Line(lateral.x, lateral.y - lateral.h, lateral.x, lateral.y + lateral.h);
+    c.assist_batches.push_back(b.End());
+
+    // Horizon line, as wide as the screen either side of the ladder
+    b.Begin(GL_LINES, 2.0f);
+    b.Color(0.0f, 1.0f, 0.0f, 0.9f);
+    b.Line(-screen_w * 0.5f, 0.0f, screen_w * 0.5f, 0.0f);
+    c.horizon = b.End();
+
+    // Pitch ladder, g_hud_rung_verts per rung so a pitch range is one contiguous draw
+    b.Begin(GL_LINES);
+    for (int deg = g_hud_ladder_min_deg; deg <= g_hud_ladder_max_deg; deg += g_hud_ladder_step_deg) {
+        float y = deg * ladder.h;
+        float half_len = ((deg % 10 == 0) ? ladder.w : ladder.w * 0.5f) * 0.5f;
+        float half_gap = g_hud_ladder_gap * 0.5f;
+        b.Color(0.0f, 0.0f, 0.0f, 0.5f);
+        b.Line(-half_len + 1.0f, y + 1.0f, -half_gap + 1.0f, y + 1.0f);
+        b.Line(half_gap + 1.0f, y + 1.0f, half_len + 1.0f, y + 1.0f);
+        b.Color(0.0f, 1.0f, 0.0f, 0.9f);
+        b.Line(-half_len, y, -half_gap, y);
+        b.Line(half_gap, y, half_len, y);
+    }
+    c.ladder = b.End();
+
+    // Compass ticks every 30°, north up; the HUD turns them by -heading
+    b.Begin(GL_LINES);
+    b.Color(0.0f, 1.0f, 0.0f, 0.9f);
+    for (int i = 0; i < 360; i += 30) {
+        float a = i * (float)(M_PI / 180.0f);
+        b.Line(sinf(a) * (compass.w - 2.0f), -cosf(a) * (compass.w - 2.0f),
+               sinf(a) * (compass.w + 4.0f), -cosf(a) * (compass.w + 4.0f));
+    }
+    c.compass_rose = b.End();
+
+    b.Begin(GL_TRIANGLES);
+    b.Color(0.0f, 1.0f, 0.0f, 1.0f);
+    b.Vertex(-15.0f, 0.0f);
+    b.Vertex(-5.0f, 6.0f);
+    b.Vertex(-5.0f, -6.0f);
+    c.ias_needle = b.End();
+
+    b.Begin(GL_LINES, 3.0f);
+    b.Color(1.0f, 1.0f, 0.0f, 1.0f);
+    b.Line(-bracket.w, 0.0f, bracket.w, 0.0f);
+    c.gs_arrow = b.End();
+
+    b.Begin(GL_LINES, 3.0f);
+    b.Color(1.0f, 1.0f, 0.0f, 1.0f);
+    b.Line(0.0f, -12.0f, 0.0f, 12.0f);
+    c.lateral_ball = b.End();
+
+    if (GLHasVertexBuffers()) {
+        if (!c.vbo) p_glGenBuffers(1, &c.vbo);
+        p_glBindBuffer(GL_ARRAY_BUFFER, c.vbo);
+        p_glBufferData(GL_ARRAY_BUFFER, (ptrdiff_t)(c.verts.size() * sizeof(HudVertex)), c.verts.data(), GL_STATIC_DRAW);
+        p_glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
-    glEnd();
-    glLineWidth(1.0f);
-
-    // Draw boxes
-    for (int i = 0; i < n; ++i) {
-        double box_x = box_xyz[i][0];
-        double box_y = box_xyz[i][1];
-        double box_z = box_xyz[i][2];
 
-        double next_box_x = box_x, next_box_y = box_y, next_box_z = box_z;
-        float heading_to_next = 0.0f;
-        if (i < n - 1) {
-            next_box_x = box_xyz[i+1][0];
-            next_box_y = box_xyz[i+1][1];
-            next_box_z = box_xyz[i+1][2];
-            double dlat = g_custom_waypoints[i+1].lat - g_custom_waypoints[i].lat;
-            double dlon = g_custom_waypoints[i+1].lon - g_custom_waypoints[i].lon;
-            heading_to_next = (float)(atan2(dlon, dlat) * 180.0 / M_PI);
-            if (heading_to_next < 0) heading_to_next += 360.0f;
-        }
+    c.layout_gen = g_hud_layout_gen;
+    c.width = screen_w;
+    c.height = screen_h;
+    ++c.revision;
+    c.valid = true;
+}
 
-        DrawLandingBox(
-            (float)box_x, (float)box_y, (float)box_z,
-            60.0f, 30.0f,
-            g_custom_waypoints[i].direction,
-            (float)next_box_x, (float)next_box_y, (float)next_box_z,
-            heading_to_next
-        );
+// Recompiles the layout when it or the screen size changed. Compiling grows
+// the vertex arrays and uploads them, so it is kept off the draw path.
+static float hud_layout_flight_loop(float inElapsedSinceLastCall, float inElapsedTimeSinceLastFlightLoop, int inCounter, void* inRefcon)
+{
+    FrameCostScope cost_scope;
+    if (!g_hud_visible) return -1.0f;
+    int screen_w = 0, screen_h = 0;
+    XPLMGetScreenSize(&screen_w, &screen_h);
+    const HudCompiledLayout& c = g_hud_compiled;
+    if (!c.valid || c.layout_gen != g_hud_layout_gen || c.width != screen_w || c.height != screen_h) {
+        CompileHudLayout(screen_w, screen_h);
     }
+    return -1.0f;
+}
+
+static void BeginHudBatches(const HudCompiledLayout& c)
+{
+    const char* base = NULL;
+    if (c.vbo) p_glBindBuffer(GL_ARRAY_BUFFER, c.vbo);
+    else base = (const char*)c.verts.data();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(HudVertex), base);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(HudVertex), base + 2 * sizeof(float));
+}
+
+// Draws count vertices of the batch from its first + offset, count < 0 = all of it
+static void DrawHudBatch(const HudBatch& batch, int offset = 0, int count = -1)
+{
+    if (batch.mode == GL_LINES) SetLineWidth(batch.line_width);
+    glDrawArrays(batch.mode, batch.first + offset, count < 0 ? batch.count : count);
+}
+
+static void EndHudBatches(const HudCompiledLayout& c)
+{
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (c.vbo) p_glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void ReleaseHudBatches()
+{
+    HudCompiledLayout& c = g_hud_compiled;
+    if (c.vbo && p_glDeleteBuffers) p_glDeleteBuffers(1, &c.vbo);
+    c.vbo = 0;
+    c.valid = false;
+}
+
+static void DrawHudText(const HudCompiledLayout& hud, HudElementId id, float color[3], const char* text)
+{
+    DrawTextWithShadow(color, (int)hud.at[id].x, (int)hud.at[id].y, text);
+}
 
-    return 1.0f;
+// Centered on the element, the basic font is 8 px per character
+static void DrawHudTextCentered(const HudCompiledLayout& hud, HudElementId id, float color[3], const char* text)
+{
+    int text_width = static_cast<int>(strlen(text)) * 8;
+    DrawTextWithShadow(color, (int)(hud.at[id].x - text_width / 2), (int)hud.at[id].y, text);
 }
 
-// formatted in lat, long, alt_meters, and direction, 1 = up arrow, 0 = dot, -1 = down arrow
-static const Waypoint g_waypoints[] = {
-    {47.4476, -122.3078, 433 * 0.3048, 1},
-    {47.4988, -122.307, 3016 * 0.3048, 1},
-    {47.5554, -122.31, 5766 * 0.3048, 1},
-    {48.5815, -121.191, 26999 * 0.3048, 1},
-    {48.8338, -120.937, 31111 * 0.3048, 0},
-    {48.9321, -120.837, 32656 * 0.3048, 0},
-    {49.0000, -120.768, 33705 * 0.3048, 0},
-    {49.0516, -120.712, 34492 * 0.3048, 0},
-    {49.8416, -119.434, 4234 * 0.3048, -1},
-    {49.8596, -119.388, 3509 * 0.3048, -1},
-    {49.8939, -119.369, 2759 * 0.3048, -1},
-    {49.9572, -119.378, 1409 * 0.3048, -1},
+// ──────────────────────────────────
+// HUD static layer: the static batches of the compiled layout are drawn
+// once into an offscreen texture and composited with a single quad every frame
+// ──────────────────────────────────
+struct HudLayerCache {
+    GLuint   fbo;
+    int      tex;
+    int      width, height;
+    bool     landing_assist;  // bracket and lateral bar only exist in landing assist mode
+    unsigned layout_revision; // HudCompiledLayout::revision drawn into it
+    bool     valid;
 };
+static HudLayerCache g_hud_static_layer = { 0, 0, 0, 0, false, 0, false };
 
-// Add at file scope:
-static const int g_num_waypoints = sizeof(g_waypoints) / sizeof(g_waypoints[0]);
-static int g_active_waypoint = -1;
-static double g_prev_dist = 1e9;
-static bool g_passed_waypoint[sizeof(g_waypoints)/sizeof(g_waypoints[0])] = {0};
-
-static float draw_seattle_to_kelowna_callback(
-    XPLMDrawingPhase inPhase,
-    int inIsBefore,
-    void* inRefcon)
+// Draws every static HUD element in screen coordinates
+static void DrawHudStaticLayer(const HudCompiledLayout& hud, bool landing_assist)
 {
-    if (!g_seattle_to_kelowna_visible) return 1.0f;
-
-    // Get aircraft position
-    float ac_lat = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/latitude"));
-    float ac_lon = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/longitude"));
-
-    // If all waypoints passed, do nothing
-    bool any_left = false;
-    for (int i = 0; i < g_num_waypoints; ++i) {
-        if (!g_passed_waypoint[i]) {
-            any_left = true;
-            break;
-        }
+    BeginHudBatches(hud);
+    for (const HudBatch& batch : hud.static_batches) DrawHudBatch(batch);
+    if (landing_assist) {
+        for (const HudBatch& batch : hud.assist_batches) DrawHudBatch(batch);
     }
-    if (!any_left) return 1.0f;
+    EndHudBatches(hud);
 
-    // If no active waypoint or the current one is passed, pick the closest unpassed waypoint
-    if (g_active_waypoint == -1 || g_passed_waypoint[g_active_waypoint]) {
-        double min_dist = 1e9;
-        int min_idx = -1;
-        for (int i = 0; i < g_num_waypoints; ++i) {
-            if (g_passed_waypoint[i]) continue;
-            double d = haversine_m(ac_lat, ac_lon, g_waypoints[i].lat, g_waypoints[i].lon);
-            if (d < min_dist) {
-                min_dist = d;
-                min_idx = i;
-            }
-        }
-        g_active_waypoint = min_idx;
-        g_prev_dist = 1e9;
+    float green[] = { 0.0f, 1.0f, 0.0f };
+    for (const HudStaticText& label : hud.static_text) {
+        DrawTextWithShadow(green, (int)label.x, (int)label.y, label.text);
     }
+}
 
-    // Check distance to active waypoint
-    double dist = haversine_m(ac_lat, ac_lon, g_waypoints[g_active_waypoint].lat, g_waypoints[g_active_waypoint].lon);
+// (Re)builds the static layer texture if the compiled layout or mode changed.
+// Returns false if framebuffer objects are unavailable.
+static bool UpdateHudStaticLayer(const HudCompiledLayout& hud, bool landing_assist)
+{
+    if (!LoadGLExtensions()) return false;
 
-    // If distance starts increasing (after decreasing), mark as passed and pick next closest
-    if (dist < g_prev_dist) {
-        g_prev_dist = dist;
-    } else if (dist > g_prev_dist + 5.0) { // 5m hysteresis
-        g_passed_waypoint[g_active_waypoint] = true;
-        g_active_waypoint = -1; // Force picking a new one next frame
-        g_prev_dist = 1e9;
-        return 1.0f; // Don't draw the just-passed box this frame
+    int screen_w = hud.width, screen_h = hud.height;
+    HudLayerCache& layer = g_hud_static_layer;
+    if (layer.valid && layer.width == screen_w && layer.height == screen_h &&
+        layer.landing_assist == landing_assist && layer.layout_revision == hud.revision) {
+        return true;
     }
 
-    // Flashing logic (1 Hz flash)
-    double now = XPLMGetElapsedTime();
-    bool flash = ((int)(now * 1.0) % 2) == 0;
+    if (layer.tex == 0) XPLMGenerateTextureNumbers(&layer.tex, 1);
+    if (layer.fbo == 0) p_glGenFramebuffers(1, &layer.fbo);
 
-    // --- Store all box positions for line drawing ---
-    double box_xyz[g_num_waypoints][3];
-    for (int i = 0; i < g_num_waypoints; ++i) {
-        XPLMWorldToLocal(g_waypoints[i].lat, g_waypoints[i].lon, g_waypoints[i].alt_m, &box_xyz[i][0], &box_xyz[i][1], &box_xyz[i][2]);
+    if (layer.width != screen_w || layer.height != screen_h) {
+        XPLMBindTexture2d(layer.tex, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, screen_w, screen_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
 
-    // --- Draw lines connecting the boxes ---
-    glColor4f(1.0f, 1.0f, 0.0f, 0.7f); // Yellow, semi-transparent
-    glLineWidth(2.0f);
-    glBegin(GL_LINE_STRIP);
-    for (int i = 0; i < g_num_waypoints; ++i) {
-        glVertex3f((float)box_xyz[i][0], (float)box_xyz[i][1], (float)box_xyz[i][2]);
+    // Save X-Plane's framebuffer and viewport, they must be restored exactly
+    GLint prev_fbo = 0;
+    GLint prev_viewport[4];
+    GLfloat prev_clear[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+    glGetIntegerv(GL_VIEWPORT, prev_viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, prev_clear);
+
+    p_glBindFramebuffer(GL_FRAMEBUFFER, layer.fbo);
+    p_glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer.tex, 0);
+    bool complete = p_glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (complete) {
+        glViewport(0, 0, screen_w, screen_h);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        // Premultiplied alpha so the layer composites like direct drawing would
+        XPLMSetGraphicsState(0, 0, 0, 0, 1, 0, 0);
+        p_glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        DrawHudStaticLayer(hud, landing_assist);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
-    glEnd();
-    glLineWidth(1.0f);
 
-    // --- Draw the boxes as before ---
-    for (int i = 0; i < g_num_waypoints; ++i) {
-        double box_x = box_xyz[i][0];
-        double box_y = box_xyz[i][1];
-        double box_z = box_xyz[i][2];
-
-        // Next box (or repeat current if last)
-        double next_box_x = box_x, next_box_y = box_y, next_box_z = box_z;
-        float heading_to_next = 0.0f;
-        if (i < g_num_waypoints - 1) {
-            next_box_x = box_xyz[i+1][0];
-            next_box_y = box_xyz[i+1][1];
-            next_box_z = box_xyz[i+1][2];
-            double dlat = g_waypoints[i+1].lat - g_waypoints[i].lat;
-            double dlon = g_waypoints[i+1].lon - g_waypoints[i].lon;
-            heading_to_next = (float)(atan2(dlon, dlat) * 180.0 / M_PI);
-            if (heading_to_next < 0) heading_to_next += 360.0f;
-        }
+    p_glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prev_fbo);
+    glViewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+    glClearColor(prev_clear[0], prev_clear[1], prev_clear[2], prev_clear[3]);
 
-        if (i == g_active_waypoint) {
-            if (flash) {
-                DrawLandingBox(
-                    (float)box_x, (float)box_y, (float)box_z,
-                    60.0f, 30.0f,
-                    g_waypoints[i].direction,
-                    (float)next_box_x, (float)next_box_y, (float)next_box_z,
-                    heading_to_next
-                );
-            }
-        } else {
-            DrawLandingBox(
-                (float)box_x, (float)box_y, (float)box_z,
-                60.0f, 30.0f,
-                g_waypoints[i].direction,
-                (float)next_box_x, (float)next_box_y, (float)next_box_z,
-                heading_to_next
-            );
-        }
+    if (!complete) {
+        XPLMDebugString("HUDPlugin: HUD layer framebuffer incomplete, HUD layers drawn directly.\n");
+        g_gl_fbo_ok = false;
+        return false;
     }
 
-    return 1.0f;
+    layer.width = screen_w;
+    layer.height = screen_h;
+    layer.landing_assist = landing_assist;
+    layer.layout_revision = hud.revision;
+    layer.valid = true;
+    return true;
 }
 
-static float
-draw_hud_callback(
-    XPLMDrawingPhase inPhase,
-    int              inIsBefore,
-    void*            inRefcon)
+// Draws the cached static layer as one screen-sized quad
+static void CompositeHudStaticLayer()
 {
+    const HudLayerCache& layer = g_hud_static_layer;
+
+    XPLMSetGraphicsState(0, 1, 0, 0, 1, 0, 0);
+    XPLMBindTexture2d(layer.tex, 0);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f); glVertex2f(0.0f, 0.0f);
+        glTexCoord2f(1.0f, 0.0f); glVertex2f((float)layer.width, 0.0f);
+        glTexCoord2f(1.0f, 1.0f); glVertex2f((float)layer.width, (float)layer.height);
+        glTexCoord2f(0.0f, 1.0f); glVertex2f(0.0f, (float)layer.height);
+    glEnd();
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    XPLMSetGraphicsState(0, 0, 0, 0, 1, 0, 0);
+}
 
-    if (!g_hud_visible) {
-        return 1.0f;
+static void ReleaseHudStaticLayer()
+{
+    HudLayerCache& layer = g_hud_static_layer;
+    if (layer.fbo && p_glDeleteFramebuffers) p_glDeleteFramebuffers(1, &layer.fbo);
+    if (layer.tex) {
+        GLuint tex = (GLuint)layer.tex;
+        glDeleteTextures(1, &tex);
     }
+    layer = HudLayerCache{ 0, 0, 0, 0, false, 0, false };
+}
+
+// ──────────────────────────────────
+// HUD frame layer: the HUD is drawn once per sim frame into a texture and
+// every view that shows it (each VR eye, each Window phase pass) only
+// composites that texture.
+// ──────────────────────────────────
+struct HudFrameLayer {
+    GLuint fbo;
+    int    tex;
+    int    width, height;
+    int    cycle; // XPLMGetCycleNumber() of the last render, -1 = never
+};
+static HudFrameLayer g_hud_frame_layer = { 0, 0, 0, 0, -1 };
+static bool g_hud_frame_pass = false; // true while DrawHudContents renders into the frame layer
 
+static const float g_hud_vr_distance_m = 1.0f;  // HUD plane distance ahead of the pilot's eye
+static const float g_hud_vr_half_fov_deg = 20.0f;
 
+// Blend mode for HUD drawing; inside the frame layer alpha is accumulated
+// premultiplied so the composite looks like direct drawing
+static void SetHudBlend()
+{
+    if (g_hud_frame_pass) {
+        p_glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    } else {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+}
 
+// Draws the whole HUD in screen coordinates, either straight to the current
+// view or into the frame layer
+static void
+DrawHudContents()
+{
+    if (!g_hud_compiled.valid) return; // shown since the last flight loop
     // 1) Setup 2D graphics state (disable fog, textures, lighting; enable alpha blending)
     XPLMSetGraphicsState(
         0,  // fog
@@ -1148,390 +5792,249 @@ draw_hud_callback(
         0,  // depth testing
         0   // depth writing
     );
+    SetHudBlend();
 
     // 2) Read flight data from DataRefs
     float ias_knots = 0.0f, tas_knots = 0.0f;
-    float pa_ft = 0.0f, radalt_ft = 0.0f, radalt_m = 0.0f;
+    float pa_ft = 0.0f, radalt_ft = 0.0f;
     float pitch_deg = 0.0f, roll_deg = 0.0f;
 
     if (g_airspeed_ias_ref) ias_knots = XPLMGetDataf(g_airspeed_ias_ref);
     if (g_airspeed_tas_ref) tas_knots = XPLMGetDataf(g_airspeed_tas_ref);
     if (g_altitude_pa_ref) pa_ft = XPLMGetDataf(g_altitude_pa_ref) * 3.28084f;     // meters to feet
     if (g_radar_alt_ref) radalt_ft = XPLMGetDataf(g_radar_alt_ref) * 3.28084f;  
-    if (g_radar_alt_ref) radalt_m = XPLMGetDataf(g_radar_alt_ref);
     if (g_pitch_ref) pitch_deg = XPLMGetDataf(g_pitch_ref);
     if (g_roll_ref) roll_deg = XPLMGetDataf(g_roll_ref);
 
-    // 3) Get screen center coordinates
-    int screen_w = 0, screen_h = 0;
-    XPLMGetScreenSize(&screen_w, &screen_h);
-    float cx = screen_w * 0.5f;
-    float cy = screen_h * 0.5f;
-
-    // 3.5) Draw the "real" horizon line (counter-pitch + counter-roll)
-    {
-        glPushMatrix();
+    float now = XPLMGetElapsedTime();
 
-            const float earth_radius_ft = 20925524.9f; // Earth radius in feet (~6371 km)
-            float horizon_angle_rad = acosf(earth_radius_ft / (earth_radius_ft + pa_ft));
-            float horizon_angle_deg = horizon_angle_rad * (180.0f / 3.14159265f);
+    // 3) Layout compiled for this screen by hud_layout_flight_loop
+    const HudCompiledLayout& hud = g_hud_compiled;
+    const HudPlacement& speed   = hud.at[HUD_EL_SPEED_SCALE];
+    const HudPlacement& ladder  = hud.at[HUD_EL_LADDER];
+    const HudPlacement& compass = hud.at[HUD_EL_COMPASS];
+    const HudPlacement& bracket = hud.at[HUD_EL_BRACKET];
+    const HudPlacement& lateral = hud.at[HUD_EL_LATERAL];
 
-            float adjusted_pitch = pitch_deg - horizon_angle_deg;
+    // 3.5) Static layer: speed scale, compass rings, nose marker, landing assist frames
+    if (UpdateHudStaticLayer(hud, g_landing_assist_visible)) {
+        CompositeHudStaticLayer();
+        SetHudBlend();
+    } else {
+        DrawHudStaticLayer(hud, g_landing_assist_visible);
+    }
 
-            // Move origin to screen center
-            glTranslatef(cx, cy, 0.0f);
+    // ──────────────────────────────
+    // 4) Moving batches: only their transforms come from this frame's values
+    // ──────────────────────────────
 
-            // Rotate by roll angle around screen center
-            glRotatef(roll_deg, 0.0f, 0.0f, 1.0f);
+    // The real horizon sits below pitch zero by the horizon dip at this altitude
+    const float earth_radius_ft = 20925524.9f; // Earth radius in feet (~6371 km)
+    float horizon_angle_deg = acosf(earth_radius_ft / (earth_radius_ft + pa_ft)) * (180.0f / 3.14159265f);
 
-            // Translate vertically by negative pitch offset (in rotated space)
-            glTranslatef(0.0f, -((pitch_deg + horizon_angle_deg) * g_ladder_spacing), 0.0f);
+    // Rungs between the ladder floor and ceiling at this pitch
+    float deg_low  = pitch_deg + (hud.at[HUD_EL_LADDER_FLOOR].y - ladder.y) / ladder.h;
+    float deg_high = pitch_deg + (hud.at[HUD_EL_LADDER_CEILING].y - ladder.y) / ladder.h;
+    int rung_first = std::max(0, (int)ceilf((deg_low - g_hud_ladder_min_deg) / g_hud_ladder_step_deg));
+    int rung_last  = std::min((g_hud_ladder_max_deg - g_hud_ladder_min_deg) / g_hud_ladder_step_deg,
+                              (int)floorf((deg_high - g_hud_ladder_min_deg) / g_hud_ladder_step_deg));
 
+    float heading_deg = XPLMGetDataf(gHeadingRef);
+    float ias_y = speed.y - speed.h / 2 + (ias_knots / g_hud_max_airspeed) * speed.h;
 
-            // Draw the horizon line centered at origin (now rotated and translated)
-            glColor4f(0.0f, 1.0f, 0.0f, 0.9f);
-            glLineWidth(2.0f);
-            glBegin(GL_LINES);
-                glVertex2f(-cx, 0.0f);
-                glVertex2f(cx, 0.0f);
-            glEnd();
-            glLineWidth(1.0f);
+    BeginHudBatches(hud);
 
+    // Horizon and pitch ladder roll about the ladder center
+    glPushMatrix();
+        glTranslatef(ladder.x, ladder.y, 0.0f);
+        glRotatef(roll_deg, 0.0f, 0.0f, 1.0f);
+        glPushMatrix();
+            glTranslatef(0.0f, -((pitch_deg + horizon_angle_deg) * ladder.h), 0.0f);
+            DrawHudBatch(hud.horizon);
         glPopMatrix();
-    };
-    
-    // ──────────────────────────────
-    // 4) Draw reversed pitch ladder lines (+30° to -30°) in 5° increments
-    //    with split segments on left and right, gap in middle, with shadows.
-    // ──────────────────────────────
-    struct LabelInfo 
-        {
-            float screen_x, screen_y;
-            char label[8];
-        };
-
-        {
-            const float gap = 25.0f;
-
-            // Calculate compass bottom edge y coordinate
-            float compass_y = 60.0f;       // same as in your compass code
-            float compass_radius = 50.0f;  // same as in your compass code
-            const float minY = compass_y + compass_radius + 150.0f;  // 10px padding above compass top edge
-            const float maxY = screen_h - 100.0f;  // top boundary for ladder lines, same as compass_top_y
-
-            std::vector<LabelInfo> label_list;
-
-                    glPushMatrix();
-                    glTranslatef(cx, cy, 0.0f);
-                    glRotatef(roll_deg, 0.0f, 0.0f, 1.0f);
-
-                    for (int deg = -30; deg <= 90; deg += 5) {
-                        float y_line = (deg - pitch_deg) * g_ladder_spacing;
-                        float abs_y = cy + y_line;
-
-                        // Only draw ladder lines within vertical bounds
-                        if (abs_y < minY || abs_y > maxY)
-                            continue;
-
-                        float total_len = (deg % 10 == 0) ? 80.0f : 40.0f;
-                        float half_len  = total_len * 0.5f;
-                        float half_gap  = gap * 0.5f;
-
-                        float x1 = -half_len;
-                        float x2 = -half_gap;
-                        float x3 = half_gap;
-                        float x4 = half_len;
-
-                        // Shadow lines
-                        glColor4f(0.0f, 0.0f, 0.0f, 0.5f);
-                        glBegin(GL_LINES);
-                        glVertex2f(x1 + 1, y_line + 1);
-                        glVertex2f(x2 + 1, y_line + 1);
-                        glEnd();
-                        glBegin(GL_LINES);
-                        glVertex2f(x3 + 1, y_line + 1);
-                        glVertex2f(x4 + 1, y_line + 1);
-                        glEnd();
-
-                        // Main ladder lines
-                        glColor4f(0.0f, 1.0f, 0.0f, 0.9f);
-                        glBegin(GL_LINES);
-                        glVertex2f(x1, y_line);
-                        glVertex2f(x2, y_line);
-                        glEnd();
-                        glBegin(GL_LINES);
-                        glVertex2f(x3, y_line);
-                        glVertex2f(x4, y_line);
-                        glEnd();
-
-                        // Store label position in screen coordinates
-                        float x_label = x4 + 5.0f;
-                        float y_label = y_line - 6.0f;
-
-                        // Rotate label point by roll
-                        float angle_rad = roll_deg * (3.1415926f / 180.0f);
-                        float rot_x = cosf(angle_rad) * x_label - sinf(angle_rad) * y_label;
-                        float rot_y = sinf(angle_rad) * x_label + cosf(angle_rad) * y_label;
-
-                        LabelInfo info;
-                        info.screen_x = cx + rot_x;
-                        info.screen_y = cy + rot_y;
-                        sprintf_s(info.label, sizeof(info.label), (deg > 0 ? "+%d" : "%d"), deg);
-                        label_list.push_back(info);
-                    }
+        glTranslatef(0.0f, -pitch_deg * ladder.h, 0.0f);
+        if (rung_first <= rung_last) {
+            DrawHudBatch(hud.ladder, rung_first * g_hud_rung_verts, (rung_last - rung_first + 1) * g_hud_rung_verts);
+        }
+    glPopMatrix();
 
-                glPopMatrix();
+    // Compass rose turns under the fixed heading pointer
+    glPushMatrix();
+        glTranslatef(compass.x, compass.y, 0.0f);
+        glRotatef(-heading_deg, 0.0f, 0.0f, 1.0f);
+        DrawHudBatch(hud.compass_rose);
+    glPopMatrix();
 
-                // Draw labels (after pop, in screen coords)
-                for (const auto& label : label_list) {
-                    float shadow_color[] = { 0.0f, 0.0f, 0.0f };
-                    float text_color[]   = { 0.0f, 1.0f, 0.0f };
+    // IAS needle slides along the speed scale
+    glPushMatrix();
+        glTranslatef(speed.x, ias_y, 0.0f);
+        DrawHudBatch(hud.ias_needle);
+    glPopMatrix();
 
-                    DrawTextWithShadow(shadow_color, (int)(label.screen_x + 1), (int)(label.screen_y + 1), label.label);
-                    DrawTextWithShadow(text_color,   (int)(label.screen_x),     (int)(label.screen_y),     label.label);
-                }
-        }
-            
+    // Landing assist meatballs, deviations come from guidance_flight_loop
+    if (g_landing_assist_visible) {
+        // Vertical deviation (positive = too high, negative = too low), clamped to
+        // [-radout_init, radout_init]: center = on path, up = too high, down = too low
+        double deviation = g_guidance.vertical_dev_m;
+        if (deviation > radout_init) deviation = radout_init;
+        if (deviation < -radout_init) deviation = -radout_init;
+        float arrow_offset = (float)(-(deviation / radout_init) * bracket.h);
 
-    // ──────────────────────────────
-    // 5) Draw "||__||" fixed nose line at screen center
-    // ──────────────────────────────
-    {
-        glColor4f(0.0f, 1.0f, 0.0f, 0.9f);
-        glLineWidth(2.0f);
+        // Lateral offset from runway centerline, +/- 30 meters = line edge
+        double lateral_offset_m = g_guidance.lateral_offset_m;
+        float max_offset_m = 30.0f;
+        if (lateral_offset_m > max_offset_m) lateral_offset_m = max_offset_m;
+        if (lateral_offset_m < -max_offset_m) lateral_offset_m = -max_offset_m;
+        float ball_offset = (float)(lateral_offset_m / max_offset_m) * lateral.w;
 
-        // Left vertical line
-        glBegin(GL_LINES);
-        glVertex2f(cx - 10.0f, cy - 2.0f);
-        glVertex2f(cx - 10.0f, cy + 2.0f);
-        glEnd();
+        glPushMatrix();
+            glTranslatef(bracket.x, bracket.y + arrow_offset, 0.0f);
+            DrawHudBatch(hud.gs_arrow);
+        glPopMatrix();
+        glPushMatrix();
+            glTranslatef(lateral.x + ball_offset, lateral.y, 0.0f);
+            DrawHudBatch(hud.lateral_ball);
+        glPopMatrix();
+    }
 
-        // Horizontal line connecting two vertical lines
-        glBegin(GL_LINES);
-        glVertex2f(cx - 10.0f, cy);
-        glVertex2f(cx + 10.0f, cy);
-        glEnd();
+    EndHudBatches(hud);
 
-        // Right vertical line
-        glBegin(GL_LINES);
-        glVertex2f(cx + 10.0f, cy - 2.0f);
-        glVertex2f(cx + 10.0f, cy + 2.0f);
-        glEnd();
+    float green[] = { 0.0f, 1.0f, 0.0f };
 
-        glLineWidth(1.0f);
+    // ──────────────────────────────
+    // 5) Pitch ladder labels, right of each visible rung, rolled with the ladder
+    // ──────────────────────────────
+    {
+        float shadow_color[] = { 0.0f, 0.0f, 0.0f };
+        float angle_rad = roll_deg * (3.1415926f / 180.0f);
+        for (int rung = rung_first; rung <= rung_last; ++rung) {
+            int deg = g_hud_ladder_min_deg + rung * g_hud_ladder_step_deg;
+            float half_len = ((deg % 10 == 0) ? ladder.w : ladder.w * 0.5f) * 0.5f;
+            float x_label = half_len + 5.0f;
+            float y_label = (deg - pitch_deg) * ladder.h - 6.0f;
+            float label_x = ladder.x + cosf(angle_rad) * x_label - sinf(angle_rad) * y_label;
+            float label_y = ladder.y + sinf(angle_rad) * x_label + cosf(angle_rad) * y_label;
+
+            const char* label = PitchLadderLabel(deg);
+            DrawTextWithShadow(shadow_color, (int)(label_x + 1), (int)(label_y + 1), label);
+            DrawTextWithShadow(green,        (int)label_x,       (int)label_y,       label);
+        }
     }
 
     // ──────────────────────────────
-    // 6) Draw Indicated Airspeed (IAS) and True Airspeed (TAS) on the left side
+    // 6) Indicated Airspeed (IAS) by the needle, climb rate and Mach at the
+    //    ends of the speed scale, IAS and TAS beside it
     // ──────────────────────────────
     {
-        // Add these before the HUD drawing code (ideally in your update or draw function)
         static XPLMDataRef gClimbRateRef = XPLMFindDataRef("sim/flightmodel/position/vh_ind_fpm"); // ft/min
         static XPLMDataRef gMachRef = XPLMFindDataRef("sim/flightmodel/misc/machno");
 
-        // --- Get values each frame
         float mach = XPLMGetDataf(gMachRef);
+        float climb_rate_ms = XPLMGetDataf(gClimbRateRef) * 0.00508f;  // Convert ft/min to m/s
 
-        float green[] = { 0.0f, 1.0f, 0.0f };
-
-        // Constants
-        float max_airspeed = 488.0f;
-        float bar_width = 8.0f;
-        float bar_height = 300.0f;
-        float scale_x = cx - 300.0f;
-        float scale_top_y = cy + bar_height / 2;
-        float scale_bottom_y = cy - bar_height / 2;
-
-        // Draw vertical scale line
-        glColor4f(0.0f, 1.0f, 0.0f, 1.0f);
-        glBegin(GL_LINES);
-        glVertex2f(scale_x, scale_bottom_y);
-        glVertex2f(scale_x, scale_top_y);
-        glEnd();
-
-        // Draw top (max) and bottom (0) labels
-        char label_top[16], label_bottom[16];
-        sprintf_s(label_top, sizeof(label_top), "%.0f", max_airspeed);
-        sprintf_s(label_bottom, sizeof(label_bottom), "0");
-        DrawTextWithShadow(green, (int)(scale_x - 30), (int)(scale_top_y - 6), label_top);
-        DrawTextWithShadow(green, (int)(scale_x - 20), (int)(scale_bottom_y - 6), label_bottom);
-
-        // Draw IAS indicator (arrow + number in brackets)
-        float ias_y = scale_bottom_y + (ias_knots / max_airspeed) * bar_height;
-        glBegin(GL_TRIANGLES);
-        glVertex2f(scale_x - 15, ias_y);
-        glVertex2f(scale_x - 5, ias_y + 6);
-        glVertex2f(scale_x - 5, ias_y - 6);
-        glEnd();
-
-        char ias_display[32];
-        sprintf_s(ias_display, sizeof(ias_display), "(%.0f)", ias_knots);
-        DrawTextWithShadow(green, (int)(scale_x - 60), (int)(ias_y - 5), ias_display);
-
-        // Draw low-speed bar (e.g. from 0 to 130 kt)
-        float low_speed_top = scale_bottom_y + (130.0f / max_airspeed) * bar_height;
-        float low_speed_bottom = scale_bottom_y;
-        glBegin(GL_QUADS);
-        glVertex2f(scale_x - bar_width, low_speed_bottom);
-        glVertex2f(scale_x + bar_width, low_speed_bottom);
-        glVertex2f(scale_x + bar_width, low_speed_top);
-        glVertex2f(scale_x - bar_width, low_speed_top);
-        glEnd();
-
-        // Draw climb rate above the bar
-        float climb_rate_fpm = XPLMGetDataf(gClimbRateRef);
-        float climb_rate_ms = climb_rate_fpm * 0.00508f;  // Convert ft/min to m/s
-        char climb_rate_text[32];
-        sprintf_s(climb_rate_text, sizeof(climb_rate_text), "V/S: %.1f m/s", climb_rate_ms);
-        DrawTextWithShadow(green, (int)(scale_x - 40), (int)(scale_top_y + 20), climb_rate_text);
-
-        // Draw Mach number below the bar
-        char mach_text[32];
-        sprintf_s(mach_text, sizeof(mach_text), "Mach %.2f", mach);
-        DrawTextWithShadow(green, (int)(scale_x - 40), (int)(scale_bottom_y - 30), mach_text);
-
-        // IAS and TAS on the right side of the bar
-        char ias_label[32], tas_label[32];
-        sprintf_s(ias_label, sizeof(ias_label), "IAS: %.0f kt", ias_knots);
-        sprintf_s(tas_label, sizeof(tas_label), "TAS: %.0f kt", tas_knots);
-
-        float label_x = scale_x + 60.0f;
-        float y_ias  = cy + 20.0f;
-        float y_tas  = cy - 10.0f;
-
-        DrawTextWithShadow(green, (int)label_x, (int)y_ias, ias_label);
-        DrawTextWithShadow(green, (int)label_x, (int)y_tas, tas_label);
+        DrawTextWithShadow(green, (int)(speed.x - 60), (int)(ias_y - 5), HudReadoutText(HUD_RO_IAS_BOX, ias_knots, now));
+        DrawHudText(hud, HUD_EL_VS_LEFT, green, HudReadoutText(HUD_RO_VS, climb_rate_ms, now));
+        DrawHudText(hud, HUD_EL_MACH, green, HudReadoutText(HUD_RO_MACH, mach, now));
+        DrawHudText(hud, HUD_EL_IAS, green, HudReadoutText(HUD_RO_IAS, ias_knots, now));
+        DrawHudText(hud, HUD_EL_TAS, green, HudReadoutText(HUD_RO_TAS, tas_knots, now));
     }
 
     // ──────────────────────────────
-    // 7) Draw Pressure Altitude (P ALT) and Radar Altitude (R ALT) on the right side
+    // 7) Pressure Altitude (P ALT), Radar Altitude (R ALT), V/S and AOA on the right side
     // ──────────────────────────────
     {
-        char pa_buf[32], radalt_buf[32];
-        sprintf_s(pa_buf, sizeof(pa_buf), "P ALT: %.0f ft", pa_ft);
-        sprintf_s(radalt_buf, sizeof(radalt_buf), "R ALT: %.0f ft", radalt_ft);
-
-        float right_color[] = { 0.0f, 1.0f, 0.0f };
-        float x_right = cx + 200.0f;
-        float y_pa    = cy + 20.0f;
-        float y_radar = cy - 10.0f;
+        DrawHudText(hud, HUD_EL_PALT, green, HudReadoutText(HUD_RO_PALT, pa_ft, now));
+        DrawHudText(hud, HUD_EL_RALT, green, HudReadoutText(HUD_RO_RALT, radalt_ft, now));
 
-        DrawTextWithShadow(right_color, (int)x_right, (int)y_pa, pa_buf);
-        DrawTextWithShadow(right_color, (int)x_right, (int)y_radar, radalt_buf);
+        // V/S, already formatted for the left side this frame
+        DrawHudText(hud, HUD_EL_VS, green, g_hud_readouts[HUD_RO_VS].text);
 
-        // Draw V/S 
-        static XPLMDataRef gClimbRateRef = XPLMFindDataRef("sim/flightmodel/position/vh_ind_fpm"); // ft/min
-        float climb_rate_fpm = XPLMGetDataf(gClimbRateRef);
-        float climb_rate_ms = climb_rate_fpm * 0.00508f;  // Convert ft/min to m/s
-        char climb_rate_text[32];
-        sprintf_s(climb_rate_text, sizeof(climb_rate_text), "V/S: %.1f m/s", climb_rate_ms);
-        float y_vs = y_pa + 30.0f; // height control
-        DrawTextWithShadow(right_color, (int)x_right, (int)y_vs, climb_rate_text);
-
-
-        // draw AOA 
         if (g_aoa_ref) {
             float aoa = XPLMGetDataf(g_aoa_ref);
-            char aoa_buf[32];
-            sprintf_s(aoa_buf, sizeof(aoa_buf), "AOA: %.1f°", aoa);
-            float y_aoa = y_pa + 60.0f; // height control 
-            DrawTextWithShadow(right_color, (int)x_right, (int)y_aoa, aoa_buf);
+            DrawHudText(hud, HUD_EL_AOA, green, HudReadoutText(HUD_RO_AOA, aoa, now));
         }
     }
 
+    // Distance to the runway, from guidance_flight_loop
+    if (g_landing_assist_visible) {
+        DrawHudText(hud, HUD_EL_RUNWAY_DIST, green, HudReadoutText(HUD_RO_RWY_DIST, g_guidance.runway_dist_m, now));
+    }
+
     // ──────────────────────────────
-    // 8) Draw Debug Information lower left with ladder spacing and slider visualization
+    // 8) Debug information, one line every h pixels of the debug element
     // ──────────────────────────────
     {
         float debug_color[] = { 1.0f, 1.0f, 0.0f }; // Yellow
-        int debug_x = 30;
-        int debug_y = 80;
+        const HudPlacement& debug = hud.at[HUD_EL_DEBUG];
+        int debug_x = (int)debug.x;
+        int debug_y = (int)debug.y;
+        int line = (int)debug.h;
 
-        char debug_text[128];
+        // Overlay quality chosen by the governor
+        DrawTextWithShadow(debug_color, debug_x, debug_y - line, HudReadoutText(HUD_RO_QUALITY, Quality().name, now));
 
         // Print load status
-        sprintf_s(debug_text, sizeof(debug_text), "Waypoint Load: %s", g_waypoint_status);
-        DrawTextWithShadow(debug_color, debug_x, debug_y, debug_text);
+        DrawTextWithShadow(debug_color, debug_x, debug_y, HudReadoutText(HUD_RO_DBG_WPT_STATUS, g_waypoint_status, now));
 
         // Example: print number of custom waypoints loaded
-        sprintf_s(debug_text, sizeof(debug_text), "Custom Waypoints: %zu", g_custom_waypoints.size());
-        DrawTextWithShadow(debug_color, debug_x, debug_y + 20, debug_text);
+        DrawTextWithShadow(debug_color, debug_x, debug_y + line,
+            HudReadoutText(HUD_RO_DBG_WPT_COUNT, (double)CustomWaypointCount(), now));
         // debug text for custom zone
-        sprintf_s(debug_text, sizeof(debug_text), "Zone Load: %s", g_zone_status);
-        DrawTextWithShadow(debug_color, debug_x, debug_y + 40, debug_text);
+        DrawTextWithShadow(debug_color, debug_x, debug_y + 2 * line, HudReadoutText(HUD_RO_DBG_ZONE_STATUS, g_zone_status, now));
+        if (g_taws.alert == TAWS_NO_DATA) {
+            DrawTextWithShadow(debug_color, debug_x, debug_y + 3 * line, "TAWS: no terrain data ahead");
+        }
+        if (g_traffic_replay_active || g_traffic_udp_active) {
+            DrawTextWithShadow(debug_color, debug_x, debug_y + 4 * line,
+                HudReadoutText(HUD_RO_DBG_TRAFFIC_FEED, (double)TrafficFeedCount(), now));
+        }
     }
+
     // ──────────────────────────────
-    // 9) Rotating Compass
+    // 8.5) Terrain awareness alert above the nose line
     // ──────────────────────────────
-
-    {
-        float green[] = { 0.0f, 1.0f, 0.0f };
-        float heading_deg = XPLMGetDataf(gHeadingRef);
-        float heading_rad = heading_deg * (float)(M_PI / 180.0f);
-
-        float compass_radius = 50.0f;
-        float compass_y = 80.0f;  // From bottom
-        float compass_center_x = cx;
-
-        // Heading text
-        char heading_text[32];
-        sprintf_s(heading_text, sizeof(heading_text), "HDG: %.0f°", heading_deg);
-        int text_width = static_cast<int>(strlen(heading_text)) * 8;
-        float text_y = compass_y + compass_radius + 30.0f;
-        DrawTextWithShadow(green, (int)(compass_center_x - text_width / 2 + 10), (int)text_y, heading_text);
-
-        // Outer circle
-        glColor4f(0.0f, 1.0f, 0.0f, 0.9f);
-        glBegin(GL_LINE_LOOP);
-        for (int i = 0; i < 64; ++i) {
-            float angle = i * 2.0f * (float)M_PI / 64;
-            glVertex2f(compass_center_x + cosf(angle) * compass_radius,
-                    compass_y + sinf(angle) * compass_radius);
+    if (g_taws.alert == TAWS_CAUTION || g_taws.alert == TAWS_WARNING) {
+        float amber[] = { 1.0f, 0.75f, 0.0f };
+        float red[]   = { 1.0f, 0.0f, 0.0f };
+        bool warning = g_taws.alert == TAWS_WARNING;
+        bool flash = ((int)(now * 2.0f) % 2) == 0;
+        if (!warning || flash) {
+            DrawHudTextCentered(hud, HUD_EL_TAWS_ALERT, warning ? red : amber, warning ? "PULL UP" : "TERRAIN AHEAD");
         }
-        glEnd();
-
-        // Inner ring for depth
-        glColor4f(0.0f, 1.0f, 0.0f, 0.3f);
-        glBegin(GL_LINE_LOOP);
-        for (int i = 0; i < 64; ++i) {
-            float angle = i * 2.0f * (float)M_PI / 64;
-            glVertex2f(compass_center_x + cosf(angle) * (compass_radius - 4.0f),
-                    compass_y + sinf(angle) * (compass_radius - 4.0f));
-        }
-        glEnd();
-
-        // Tick marks every 30°
-        for (int i = 0; i < 360; i += 30) {
-            float rel_angle = (i - heading_deg) * (float)(M_PI / 180.0f);
-            float x1 = compass_center_x + sinf(rel_angle) * (compass_radius - 2.0f);
-            float y1 = compass_y - cosf(rel_angle) * (compass_radius - 2.0f);
-            float x2 = compass_center_x + sinf(rel_angle) * (compass_radius + 4.0f);
-            float y2 = compass_y - cosf(rel_angle) * (compass_radius + 4.0f);
-
-            glBegin(GL_LINES);
-            glVertex2f(x1, y1);
-            glVertex2f(x2, y2);
-            glEnd();
+    }
+    // ──────────────────────────────
+    // 8.6) Traffic conflict alert, below the terrain alert
+    // ──────────────────────────────
+    {
+        std::shared_ptr<const TrafficTable> traffic = g_traffic.Acquire();
+        if (traffic && traffic->worst >= THREAT_CAUTION) {
+            float amber[] = { 1.0f, 0.75f, 0.0f };
+            float red[]   = { 1.0f, 0.0f, 0.0f };
+            bool warning = traffic->worst == THREAT_WARNING;
+            bool flash = ((int)(now * 2.0f) % 2) == 0;
+            if (!warning || flash) {
+                char text[48];
+                snprintf(text, sizeof(text), "TRAFFIC %.0fs", traffic->t_cpa_s[traffic->worst_index]);
+                DrawHudTextCentered(hud, HUD_EL_TRAFFIC_ALERT, warning ? red : amber, text);
+            }
         }
+    }
+    // ──────────────────────────────
+    // 9) Compass heading and NESW labels, the rose itself is a batch
+    // ──────────────────────────────
+    {
+        DrawHudTextCentered(hud, HUD_EL_HEADING, green, HudReadoutText(HUD_RO_HDG, heading_deg, now));
 
-        // NESW labels
         const char* labels[] = {"N", "E", "S", "W"};
         float angles[] = {0.0f, 90.0f, 180.0f, 270.0f};
+        float label_radius = compass.w + 10.0f;
 
         for (int i = 0; i < 4; ++i) {
             float rel_angle = (angles[i] - heading_deg) * (float)(M_PI / 180.0f);
-            float x = compass_center_x + sinf(rel_angle) * (compass_radius + 10.0f);
-            float y = compass_y - cosf(rel_angle) * (compass_radius + 10.0f);
+            float x = compass.x + sinf(rel_angle) * label_radius;
+            float y = compass.y - cosf(rel_angle) * label_radius;
             DrawTextWithShadow(green, (int)(x - 4), (int)(y - 4), labels[i]);
         }
-
-        // Heading indicator (bold triangle)
-        glColor4f(0.0f, 1.0f, 0.0f, 0.9f);
-        glBegin(GL_TRIANGLES);
-        glVertex2f(compass_center_x, compass_y + compass_radius + 12);
-        glVertex2f(compass_center_x - 6, compass_y + compass_radius);
-        glVertex2f(compass_center_x + 6, compass_y + compass_radius);
-        glEnd();
     }
 
     // ──────────────────────────────
@@ -1553,151 +6056,238 @@ draw_hud_callback(
 //⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠘⣇⠀⠁⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⢀⠀⢀⣿⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀
 //⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠈⠉⠛⠶⣄⡀⠀⠀⠀⠀⠀⠀⠀⣠⣴⠞⠿⠋⠁⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀
 //⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠉⠉⠉⠉⠉⠉⠉⠉⠉⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀⠀
+}
 
+// Renders the HUD into the frame layer unless that already happened this
+// sim frame. Returns false when the HUD has to be drawn directly instead.
+static bool UpdateHudFrameLayer(int screen_w, int screen_h)
+{
+    if (!LoadGLExtensions() || screen_w <= 0 || screen_h <= 0) return false;
 
-    
-    // ──────────────────────────────
-    // 11) meatball for landing assist
-    // ──────────────────────────────
+    HudFrameLayer& layer = g_hud_frame_layer;
+    int cycle = XPLMGetCycleNumber();
+    if (layer.cycle == cycle && layer.width == screen_w && layer.height == screen_h) {
+        return true;
+    }
 
-    // Draw E-Bracket/Meatball indicator (only in landing assist mode)
-    if (g_landing_assist_visible) {
-        // Position (below AoA/altitude)
-        float x_bracket = cx + 220.0f;
-        float y_bracket = cy - 100.0f;
+    if (layer.tex == 0) XPLMGenerateTextureNumbers(&layer.tex, 1);
+    if (layer.fbo == 0) p_glGenFramebuffers(1, &layer.fbo);
+
+    if (layer.width != screen_w || layer.height != screen_h) {
+        XPLMBindTexture2d(layer.tex, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, screen_w, screen_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        // Linear so the VR quad resamples smoothly; the 2D composite is pixel aligned
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        layer.width = screen_w;
+        layer.height = screen_h;
+    }
 
-        // Bracket size
-        float bracket_width = 12.0f;
-        float bracket_height = 40.0f;
+    GLint prev_fbo = 0;
+    GLint prev_viewport[4];
+    GLfloat prev_clear[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prev_fbo);
+    glGetIntegerv(GL_VIEWPORT, prev_viewport);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, prev_clear);
 
-        // ──────────────────────────────
-        // Arrow logic
-        // ──────────────────────────────
+    p_glBindFramebuffer(GL_FRAMEBUFFER, layer.fbo);
+    p_glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, layer.tex, 0);
+    bool complete = p_glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
 
-        // find distance to runway
-        // Get aircraft position (add this before using ac_lat/ac_lon)
-        float ac_lat = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/latitude"));
-        float ac_lon = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/longitude"));
-        double dist1 = haversine_m(ac_lat, ac_lon, lat1, lon1);
-        double dist2 = haversine_m(ac_lat, ac_lon, lat2, lon2);
-        // find the shortest distance to runway
-        double runway_dist_m = (dist1 < dist2) ? dist1 : dist2 - 400;
-
-        // Format as meters and feet
-        char runway_dist_text[64];
-        sprintf_s(runway_dist_text, sizeof(runway_dist_text), "Runway Dist: %.0f m (%.0f ft)",
-            runway_dist_m, runway_dist_m * 3.28084);
-
-        // Draw at lower left
-        float left_color[] = { 0.0f, 1.0f, 0.0f };
-        int x = 30;
-        int y = 40;
-        DrawTextWithShadow(left_color, x, y, runway_dist_text);
-
-        // Set radout_init only the first frame after assist is enabled
-        if (!radout_init_set) {
-            radout_init = radalt_m;
-            radout_init_set = true;
-        }
-
-        // Calculate target altitude based on distance to runway
-        double target_alt = radout_init * (runway_dist_m / (runway_dist_m + 1.0)); // Avoid div by zero
-        // Compute the vertical deviation (positive = too high, negative = too low)
-        double deviation = radalt_m - target_alt;
-        
-        // Map deviation to arrow offset: center = on path, up = too high, down = too low
-        // Clamp deviation to [-radout_init, radout_init] for display
-        if (deviation > radout_init) deviation = radout_init;
-        if (deviation < -radout_init) deviation = -radout_init;
-        float arrow_offset = (float)(-(deviation / radout_init) * bracket_height);
-            
-        // Draw bracket (fixed)
-        glColor4f(0.0f, 1.0f, 0.0f, 1.0f);
-        glLineWidth(3.0f);
-        glBegin(GL_LINES);
-            // Top bar
-            glVertex2f(x_bracket - bracket_width, y_bracket + bracket_height);
-            glVertex2f(x_bracket + bracket_width, y_bracket + bracket_height);
-            // Left vertical
-            glVertex2f(x_bracket - bracket_width, y_bracket + bracket_height);
-            glVertex2f(x_bracket - bracket_width, y_bracket - bracket_height);
-            // Middle bar
-            glVertex2f(x_bracket - bracket_width, y_bracket);
-            glVertex2f(x_bracket + bracket_width, y_bracket);
-            // Bottom bar
-            glVertex2f(x_bracket - bracket_width, y_bracket - bracket_height);
-            glVertex2f(x_bracket + bracket_width, y_bracket - bracket_height);
-        glEnd();
+    if (complete) {
+        glViewport(0, 0, screen_w, screen_h);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
 
-        // Draw arrow (moves up/down)
-        glColor4f(1.0f, 1.0f, 0.0f, 1.0f); // Yellow
-        glLineWidth(3.0f);
-        glBegin(GL_LINES);
-            // Arrow stem
-            glVertex2f(x_bracket - bracket_width, y_bracket + arrow_offset);
-            glVertex2f(x_bracket + bracket_width, y_bracket + arrow_offset);
-        glEnd();
-        glLineWidth(1.0f);
+        // The first caller may be a 3D phase, so set up window coordinates explicitly
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glOrtho(0.0, screen_w, 0.0, screen_h, -1.0, 1.0);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+
+        g_hud_frame_pass = true;
+        DrawHudContents();
+        g_hud_frame_pass = false;
+        InvalidateGLState(); // the HUD sets state behind the tracker's back
+
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopMatrix();
     }
 
-    // 12) Horizontal meatball for landing assist (line style)
-    if (g_landing_assist_visible) {
-        // Horizontal line position (below the vertical one)
-        float y_horiz = cy - 170.0f;
-        float x_horiz = cx + 220.0f;
+    p_glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)prev_fbo);
+    glViewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+    glClearColor(prev_clear[0], prev_clear[1], prev_clear[2], prev_clear[3]);
 
-        float line_half = 40.0f; // half-length of the horizontal line
+    if (!complete) {
+        XPLMDebugString("HUDPlugin: HUD frame framebuffer incomplete, HUD drawn directly.\n");
+        g_gl_fbo_ok = false;
+        return false;
+    }
 
-        // Calculate lateral offset from runway centerline (in meters)
-        float ac_lat = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/latitude"));
-        float ac_lon = XPLMGetDataf(XPLMFindDataRef("sim/flightmodel/position/longitude"));
+    layer.cycle = cycle;
+    return true;
+}
 
-        double dist1 = haversine_m(ac_lat, ac_lon, lat1, lon1);
-        double dist2 = haversine_m(ac_lat, ac_lon, lat2, lon2);
+// Draws the frame layer as a textured quad with premultiplied alpha
+static void DrawHudFrameQuad(float x0, float y0, float x1, float y1, float z)
+{
+    SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    XPLMBindTexture2d(g_hud_frame_layer.tex, 0);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f); glVertex3f(x0, y0, z);
+        glTexCoord2f(1.0f, 0.0f); glVertex3f(x1, y0, z);
+        glTexCoord2f(1.0f, 1.0f); glVertex3f(x1, y1, z);
+        glTexCoord2f(0.0f, 1.0f); glVertex3f(x0, y1, z);
+    glEnd();
+}
 
-        // Interpolate centerline longitude at aircraft's latitude
-        double frac = (ac_lat - lat2) / (lat1 - lat2);
-        double centerline_lon = lon2 + frac * (lon1 - lon2);
+static void ReleaseHudFrameLayer()
+{
+    HudFrameLayer& layer = g_hud_frame_layer;
+    if (layer.fbo && p_glDeleteFramebuffers) p_glDeleteFramebuffers(1, &layer.fbo);
+    if (layer.tex) {
+        GLuint tex = (GLuint)layer.tex;
+        glDeleteTextures(1, &tex);
+    }
+    layer = HudFrameLayer{ 0, 0, 0, 0, -1 };
+}
 
-        // Lateral offset in meters
-        double meters_per_deg_lon = 111320.0 * cos(ac_lat * M_PI / 180.0);
-        double lateral_offset_m = (ac_lon - centerline_lon) * meters_per_deg_lon;
+static bool HudInVr()
+{
+    static XPLMDataRef vr_ref = XPLMFindDataRef("sim/graphics/VR/enabled");
+    return vr_ref && XPLMGetDatai(vr_ref) != 0;
+}
 
-        // Clamp and scale for display
-        float max_offset_m = 30.0f; // +/- 30 meters = line edge
-        if (lateral_offset_m > max_offset_m) lateral_offset_m = max_offset_m;
-        if (lateral_offset_m < -max_offset_m) lateral_offset_m = -max_offset_m;
-        float arrow_x = x_horiz + (float)(lateral_offset_m / max_offset_m) * line_half;
+static void DrawHudLayer()
+{
+    int screen_w = 0, screen_h = 0;
+    XPLMGetScreenSize(&screen_w, &screen_h);
 
-        // Draw horizontal centerline
-        glColor4f(0.0f, 1.0f, 0.0f, 1.0f);
-        glLineWidth(3.0f);
-        glBegin(GL_LINES);
-            glVertex2f(x_horiz - line_half, y_horiz);
-            glVertex2f(x_horiz + line_half, y_horiz);
-        glEnd();
+    if (UpdateHudFrameLayer(screen_w, screen_h)) {
+        // In VR the HUD is already in the headset from the 3D pass; this
+        // only mirrors it to the monitor window
+        SetGraphicsState(0, 1, 0, 0, 1, 0, 0);
+        DrawHudFrameQuad(0.0f, 0.0f, (float)screen_w, (float)screen_h, 0.0f);
+    } else if (!HudInVr()) {
+        DrawHudContents();
+    }
+}
 
-        // Draw vertical centerline (shows perfect center)
-        glColor4f(0.0f, 1.0f, 0.0f, 1.0f); // Green
-        glLineWidth(2.0f);
-        glBegin(GL_LINES);
-            glVertex2f(x_horiz, y_horiz - 14.0f);
-            glVertex2f(x_horiz, y_horiz + 14.0f);
-        glEnd();
+// VR: Window phase drawing never reaches the headset, so the frame layer is
+// shown on a plane fixed in the cockpit ahead of the pilot's eye. Both eyes
+// run this callback but the HUD itself is only rendered once.
+static void DrawHudVrLayer()
+{
+    if (!HudInVr()) return;
 
-        // Draw vertical "meatball" line
-        glColor4f(1.0f, 1.0f, 0.0f, 1.0f); // Yellow
-        glLineWidth(3.0f);
-        glBegin(GL_LINES);
-            glVertex2f(arrow_x, y_horiz - 12.0f);
-            glVertex2f(arrow_x, y_horiz + 12.0f);
-        glEnd();
-        glLineWidth(1.0f);
+    int screen_w = 0, screen_h = 0;
+    XPLMGetScreenSize(&screen_w, &screen_h);
+    if (!UpdateHudFrameLayer(screen_w, screen_h)) return;
+
+    static XPLMDataRef x_ref     = XPLMFindDataRef("sim/flightmodel/position/local_x");
+    static XPLMDataRef y_ref     = XPLMFindDataRef("sim/flightmodel/position/local_y");
+    static XPLMDataRef z_ref     = XPLMFindDataRef("sim/flightmodel/position/local_z");
+    static XPLMDataRef psi_ref   = XPLMFindDataRef("sim/flightmodel/position/psi");
+    static XPLMDataRef theta_ref = XPLMFindDataRef("sim/flightmodel/position/theta");
+    static XPLMDataRef phi_ref   = XPLMFindDataRef("sim/flightmodel/position/phi");
+    static XPLMDataRef pe_x_ref  = XPLMFindDataRef("sim/aircraft/view/acf_peX");
+    static XPLMDataRef pe_y_ref  = XPLMFindDataRef("sim/aircraft/view/acf_peY");
+    static XPLMDataRef pe_z_ref  = XPLMFindDataRef("sim/aircraft/view/acf_peZ");
+
+    float half_w = g_hud_vr_distance_m * tanf(g_hud_vr_half_fov_deg * (float)M_PI / 180.0f);
+    float half_h = half_w * (float)screen_h / (float)screen_w;
+
+    // Aircraft body frame: x right, y up, z aft
+    glPushMatrix();
+    glTranslatef((float)XPLMGetDatad(x_ref), (float)XPLMGetDatad(y_ref), (float)XPLMGetDatad(z_ref));
+    glRotatef(-XPLMGetDataf(psi_ref), 0.0f, 1.0f, 0.0f);
+    glRotatef(XPLMGetDataf(theta_ref), 1.0f, 0.0f, 0.0f);
+    glRotatef(-XPLMGetDataf(phi_ref), 0.0f, 0.0f, 1.0f);
+    glTranslatef(XPLMGetDataf(pe_x_ref), XPLMGetDataf(pe_y_ref), XPLMGetDataf(pe_z_ref));
+
+    // No depth test: the HUD sits in front of the panel like a combiner glass
+    SetGraphicsState(0, 1, 0, 0, 1, 0, 0);
+    DrawHudFrameQuad(-half_w, -half_h, half_w, half_h, -g_hud_vr_distance_m);
+    glPopMatrix();
+}
+
+// ──────────────────────────────────
+// Overlay layers. Each phase has one draw callback that walks its layers in
+// order, so drawing order no longer depends on which menu item was clicked
+// first. A layer declares the graphics state it draws with and the
+// dispatcher applies it through the state tracker, so consecutive layers
+// that agree (most of the 3D line overlays) change no state between them.
+// Untracked layers draw text through XPLMDrawString or set state themselves;
+// the tracker forgets everything around them.
+// ──────────────────────────────────
+struct OverlayLayer {
+    const char*   name;
+    bool        (*enabled)();
+    void        (*draw)();
+    GraphicsState state;
+    bool          tracked;
+};
+
+// Back to front: terrain first, translucent zones after every opaque line
+// they may cover, the VR HUD quad last since it is not depth tested
+static const OverlayLayer g_airplanes_layers[] = {
+    { "svs terrain",        [] { return g_svs_visible; },                           DrawSvsTerrainLayer,        { 0, 0, 0, 0, 1, 1, 0 }, true },
+    { "landing assist",     [] { return g_landing_assist_visible; },                DrawLandingAssistLayer,     { 0, 0, 0, 0, 1, 0, 0 }, true },
+    { "seattle to kelowna", [] { return g_seattle_to_kelowna_visible; },            DrawSeattleToKelownaLayer,  { 0, 0, 0, 0, 1, 0, 0 }, true },
+    { "custom waypoints",   [] { return g_custom_waypoints_visible; },              DrawCustomWaypointsLayer,   { 0, 0, 0, 0, 1, 0, 0 }, true },
+    { "route library",      [] { return g_route_library_shown >= 0; },              DrawRouteLibraryLayer,      { 0, 0, 0, 0, 1, 0, 0 }, true },
+    { "aircraft highlight", [] { return g_aircraft_highlight_visible; },            DrawAircraftHighlightLayer, { 0, 0, 0, 0, 1, 0, 0 }, true },
+    { "zones",              [] { return g_zones_visible || g_custom_zone_visible; }, DrawZonesLayer,             { 0, 0, 0, 0, 1, 1, 0 }, true },
+    { "hud vr",             [] { return g_hud_visible; },                           DrawHudVrLayer,             { 0, 1, 0, 0, 1, 0, 0 }, true },
+};
+
+// Labels under the HUD, as when each had its own window phase callback
+static const OverlayLayer g_window_layers[] = {
+    { "labels", [] { return true; },          DrawLabelsLayer, { 0, 0, 0, 0, 1, 0, 0 }, false },
+    { "hud",    [] { return g_hud_visible; }, DrawHudLayer,    { 0, 0, 0, 0, 1, 0, 0 }, false },
+};
+
+template <size_t N>
+static void DispatchOverlayLayers(const OverlayLayer (&layers)[N])
+{
+    DrawAllocScope alloc_scope;
+    FrameCostScope cost_scope;
+
+    // X-Plane and other plugins drew since the last dispatch
+    InvalidateGLState();
+    for (const OverlayLayer& layer : layers) {
+        if (!layer.enabled()) continue;
+        if (layer.tracked) {
+            SetGraphicsState(layer.state);
+            SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            layer.draw();
+        } else {
+            layer.draw();
+            InvalidateGLState();
+        }
     }
 
-    // draw text using the baked font texture
-    // Inside draw_landing_assist_callback or draw_hud_callback
+    // Leave the defaults the sim expects from a plugin
+    SetLineWidth(1.0f);
+    SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
 
+static int draw_airplanes_layers_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon)
+{
+    DispatchOverlayLayers(g_airplanes_layers);
+    return 1;
+}
 
-    return 1.0f;
+static int draw_window_layers_callback(XPLMDrawingPhase inPhase, int inIsBefore, void* inRefcon)
+{
+    DispatchOverlayLayers(g_window_layers);
+    return 1;
 }
@@ -0,0 +1,64 @@
+# Steps of the profile-guided build, run with cmake -P from the pgo_train
+# and pgo_report targets in CMakeLists.txt.
+#
+#   MODE=train   replays SESSIONS through the instrumented PLUGIN, merges the
+#                profile if MERGE (llvm-profdata) is set and rewrites
+#                STAMP_HEADER so the optimized plugin is rebuilt
+#   MODE=report  replays SESSIONS through PLUGIN and PGO_PLUGIN and prints
+#                the time per callback of both
+
+# Session folders stand for the *.csv files in them
+set(session_files "")
+foreach(entry IN LISTS SESSIONS)
+    if(IS_DIRECTORY "${entry}")
+        file(GLOB found "${entry}/*.csv")
+        list(SORT found)
+        list(APPEND session_files ${found})
+    else()
+        list(APPEND session_files "${entry}")
+    endif()
+endforeach()
+list(LENGTH session_files session_count)
+if(session_count EQUAL 0)
+    message(FATAL_ERROR "No session logs in '${SESSIONS}'")
+endif()
+
+if(NOT ROOT)
+    set(ROOT "${PGO_DIR}/root")
+endif()
+file(MAKE_DIRECTORY "${ROOT}")
+
+function(replay plugin report)
+    execute_process(
+        COMMAND "${REPLAY}" --plugin "${plugin}" --root "${ROOT}" --fps "${FPS}" --report "${report}" ${ARGN} ${session_files}
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "hud_replay failed on ${plugin}")
+    endif()
+endfunction()
+
+if(MODE STREQUAL "train")
+    # Start from an empty profile, runs would otherwise accumulate
+    file(REMOVE_RECURSE "${PGO_DIR}/data")
+    file(MAKE_DIRECTORY "${PGO_DIR}/data")
+    message(STATUS "Training on ${session_count} sessions")
+    replay("${PLUGIN}" "${PGO_DIR}/train.csv")
+
+    if(MERGE)
+        file(GLOB raw "${PGO_DIR}/data/*.profraw")
+        execute_process(COMMAND "${MERGE}" merge -o "${PGO_DIR}/hud.profdata" ${raw} RESULT_VARIABLE result)
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "llvm-profdata merge failed")
+        endif()
+    endif()
+
+    string(TIMESTAMP now "%Y-%m-%d %H:%M:%S")
+    file(WRITE "${STAMP_HEADER}" "// Profile from ${session_count} sessions, trained ${now}\n")
+elseif(MODE STREQUAL "report")
+    message(STATUS "Release build")
+    replay("${PLUGIN}" "${PGO_DIR}/release.csv")
+    message(STATUS "Profile-guided build, speedup over the release build")
+    replay("${PGO_PLUGIN}" "${PGO_DIR}/pgo.csv" --compare "${PGO_DIR}/release.csv")
+else()
+    message(FATAL_ERROR "MODE must be train or report")
+endif()
@@ -0,0 +1,80 @@
+// Generated by tools/bake_assets.py, do not edit.
+#pragma once
+
+// Waypoint with everything the route logic needs precomputed
+struct BakedWaypoint {
+    double lat, lon, alt_m;
+    int direction; // 1 = up arrow, 0 = dot, -1 = down arrow
+    double sin_lat, cos_lat, sin_lon, cos_lon;
+    double ecef_x, ecef_y, ecef_z; // WGS84, meters
+    double bearing_deg;            // initial great-circle bearing to the next waypoint
+    double leg_m;                  // great-circle distance to the next waypoint
+};
+
+struct BakedZonePoint {
+    double lat, lon, alt_m;
+    double sin_lat, cos_lat, sin_lon, cos_lon;
+};
+
+// Screen point a HUD element's offset is measured from
+enum BakedHudAnchor { HUD_ANCHOR_CENTER, HUD_ANCHOR_BOTTOM, HUD_ANCHOR_BOTTOM_LEFT, HUD_ANCHOR_TOP };
+
+struct BakedHudElement {
+    const char* name;
+    BakedHudAnchor anchor;
+    float x, y; // pixels from the anchor
+    float w, h; // element specific sizes, see assets/hud_layout.hud
+};
+
+// seattle_to_kelowna.wpt
+static constexpr BakedWaypoint g_baked_seattle_to_kelowna[] = {
+    { 47.4476, -122.3078, 131.9784, 1, 0.7366591658322644, 0.6762642038399729, -0.8451890809681658, -0.5344674147337583, -2309567.9197513857, -3652274.2710154187, 4675657.127694257, 0.6048112120376459, 5693.497758004427 },
+    { 47.4988, -122.307, 919.2768, 1, 0.7372631871202016, 0.6756056489679187, -0.8451965434586841, -0.5344556136158481, -2307559.0657045105, -3649210.330050072, 4680085.358888836, 357.95135490456346, 6297.662430308965 },
+    { 47.5554, -122.31, 1757.4768, 1, 0.7379302286136958, 0.6748770093121699, -0.8451685582696296, -0.5344998672707373, -2305571.2061508936, -3645644.1088384967, 4684953.69875639, 35.667403150960354, 141175.98756915017 },
+    { 48.5815, -121.191, 8229.2952, 1, 0.7498975022481389, 0.6615540311433394, -0.8554456210998889, -0.5178926426789875, -2192183.162076822, -3621008.162902044, 4766069.162976767, 33.502629819972924, 33681.200540842554 },
+    { 48.8338, -120.937, 9482.6328, 0, 0.7528033528844769, 0.6582454799585712, -0.857733096360402, -0.5140952590794797, -2165681.992191547, -3613293.622315307, 4785551.289175435, 33.743755282049676, 13150.770946933699 },
+    { 48.9321, -120.837, 9953.5488, 0, 0.7539315689527935, 0.6569529582370257, -0.8586290549969654, -0.5125974501643742, -2155303.0694991536, -3610251.7427714183, 4793105.701423115, 33.68288693598589, 9076.122640648608 },
+    { 49.0, -120.768, 10273.284, 0, 0.754709580222772, 0.6560590289905073, -0.8592457416337836, -0.5115630513281907, -2148142.6835677037, -3608123.081768791, 4798312.093327221, 35.41577867115012, 7042.193183624639 },
+    { 49.0516, -120.712, 10513.1616, 0, 0.75530011421613, 0.6553790792092017, -0.859745324880301, -0.5107229937514717, -2142479.1222781236, -3606625.179536396, 4802262.149753532, 45.96131101601634, 127483.05477832413 },
+    { 49.8416, -119.434, 1290.5232, -1, 0.764264466324864, 0.644902958214002, -0.8709223495920874, -0.49142065583469124, -2025723.018853402, -3590096.2449491653, 4852431.780882072, 58.72979216514733, 3857.8652006631028 },
+    { 49.8596, -119.388, 1069.5432, -1, 0.7644670308461722, 0.6446628256299859, -0.8713166066533126, -0.49072127625583606, -2022019.0352591411, -3590263.658084963, 4853554.011704488, 19.63803465736072, 4049.7117841949353 },
+    { 49.8939, -119.369, 840.9432, -1, 0.764852819906852, 0.6442050635322083, -0.8714792880799673, -0.4904323097509311, -2019325.1773538787, -3588262.912074526, 4855838.143121409, 354.77355897515815, 7068.063250190816 },
+    { 49.9572, -119.378, 429.4632, -1, 0.7655640664975644, 0.64335966619591, -0.8714022404017695, -0.4905691953463617, -2017115.58277131, -3583019.5916301263, 4860056.4116189545, 0.0, 0.0 },
+};
+static constexpr int g_baked_seattle_to_kelowna_count = 12;
+
+// seattle_zone.zone
+static constexpr BakedZonePoint g_baked_seattle_zone[] = {
+    { 47.591114, -122.341964, 0.0, 0.7383507542167893, 0.6744169064810716, -0.8448702415605899, -0.5349712842063119 },
+    { 47.591565, -122.286117, 0.0, 0.738356062822708, 0.6744110945802635, -0.8453912841511534, -0.5341475233315829 },
+    { 47.642684, -122.278412, 0.0, 0.7389574749852112, 0.6737520687637857, -0.8454631073938726, -0.5340338322951992 },
+    { 47.663445, -122.431298, 0.0, 0.739201559052723, 0.6734842649193994, -0.8440351024717823, -0.5362879318010504 },
+    { 47.63, -122.4, 0.0, 0.7388083032884133, 0.6739156408572929, -0.844327925502015, -0.5358267949789969 },
+};
+static constexpr int g_baked_seattle_zone_count = 5;
+
+// hud_layout.hud
+static constexpr BakedHudElement g_baked_hud_layout[] = {
+    { "speed_scale", HUD_ANCHOR_CENTER, -300.0f, 0.0f, 8.0f, 300.0f },
+    { "ias", HUD_ANCHOR_CENTER, -240.0f, 20.0f, 0.0f, 0.0f },
+    { "tas", HUD_ANCHOR_CENTER, -240.0f, -10.0f, 0.0f, 0.0f },
+    { "vs_left", HUD_ANCHOR_CENTER, -340.0f, 170.0f, 0.0f, 0.0f },
+    { "mach", HUD_ANCHOR_CENTER, -340.0f, -180.0f, 0.0f, 0.0f },
+    { "palt", HUD_ANCHOR_CENTER, 200.0f, 20.0f, 0.0f, 0.0f },
+    { "ralt", HUD_ANCHOR_CENTER, 200.0f, -10.0f, 0.0f, 0.0f },
+    { "vs", HUD_ANCHOR_CENTER, 200.0f, 50.0f, 0.0f, 0.0f },
+    { "aoa", HUD_ANCHOR_CENTER, 200.0f, 80.0f, 0.0f, 0.0f },
+    { "ladder", HUD_ANCHOR_CENTER, 0.0f, 0.0f, 80.0f, 30.0f },
+    { "ladder_floor", HUD_ANCHOR_BOTTOM, 0.0f, 260.0f, 0.0f, 0.0f },
+    { "ladder_ceiling", HUD_ANCHOR_TOP, 0.0f, -100.0f, 0.0f, 0.0f },
+    { "nose", HUD_ANCHOR_CENTER, 0.0f, 0.0f, 10.0f, 2.0f },
+    { "compass", HUD_ANCHOR_BOTTOM, 0.0f, 80.0f, 50.0f, 0.0f },
+    { "heading", HUD_ANCHOR_BOTTOM, 10.0f, 160.0f, 0.0f, 0.0f },
+    { "bracket", HUD_ANCHOR_CENTER, 220.0f, -100.0f, 12.0f, 40.0f },
+    { "lateral", HUD_ANCHOR_CENTER, 220.0f, -170.0f, 40.0f, 14.0f },
+    { "runway_dist", HUD_ANCHOR_BOTTOM_LEFT, 30.0f, 40.0f, 0.0f, 0.0f },
+    { "debug", HUD_ANCHOR_BOTTOM_LEFT, 30.0f, 80.0f, 0.0f, 20.0f },
+    { "taws_alert", HUD_ANCHOR_CENTER, 0.0f, 150.0f, 0.0f, 0.0f },
+    { "traffic_alert", HUD_ANCHOR_CENTER, 0.0f, 130.0f, 0.0f, 0.0f },
+};
+static constexpr int g_baked_hud_layout_count = 21;
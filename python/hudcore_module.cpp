@@ -0,0 +1,189 @@
+// Python bindings for HudCore.h, so the Qt UI runs the plugin's own
+// geodesy, route sequencing and zone code instead of a Python copy.
+//
+// Array arguments are taken as contiguous float64 without copying when the
+// caller already passes that (anything else is converted once). Results are
+// handed to NumPy as arrays that own the C++ buffers they were computed in.
+// Batch functions release the GIL.
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <string>
+#include <utility>
+
+#include "HudCore.h"
+
+namespace py = pybind11;
+
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> DoubleArray;
+
+// Moves 'values' to the heap and wraps it as an array that frees it
+template <typename T>
+static py::array_t<T> AdoptVector(std::vector<T>&& values, std::vector<py::ssize_t> shape)
+{
+    auto* owned = new std::vector<T>(std::move(values));
+    py::capsule free_when_done(owned, [](void* p) { delete static_cast<std::vector<T>*>(p); });
+    return py::array_t<T>(shape, owned->data(), free_when_done);
+}
+
+static void RequireColumns(const DoubleArray& a, py::ssize_t min_cols, const char* what)
+{
+    if (a.ndim() != 2 || a.shape(1) < min_cols) {
+        throw py::value_error(std::string(what) + " must be an (N, " + std::to_string(min_cols) + "+) array");
+    }
+}
+
+static ZoneGeometry ZoneFromArray(const DoubleArray& points)
+{
+    RequireColumns(points, 2, "zone points");
+    auto p = points.unchecked<2>();
+    ZoneGeometry zone;
+    zone.points.reserve(p.shape(0));
+    for (py::ssize_t i = 0; i < p.shape(0); ++i) {
+        zone.points.emplace_back(p(i, 0), p(i, 1), p.shape(1) > 2 ? p(i, 2) : 0.0);
+    }
+    return zone;
+}
+
+static py::array_t<int> TrianglesToArray(std::vector<int>&& tris)
+{
+    py::ssize_t n = (py::ssize_t)tris.size() / 3;
+    return AdoptVector(std::move(tris), { n, 3 });
+}
+
+// Columns: lat, lon, alt_m, direction, heading_to_next
+static py::array_t<double> LoadWaypoints(const std::string& path)
+{
+    std::vector<Waypoint> route;
+    const char* message = "";
+    if (!LoadCustomWaypoints(path.c_str(), route, &message)) {
+        throw py::value_error(path + ": " + message);
+    }
+    DiffWaypoints(route, nullptr);
+    std::vector<double> table;
+    table.reserve(route.size() * 5);
+    for (const Waypoint& w : route) {
+        table.insert(table.end(), { w.lat, w.lon, w.alt_m, (double)w.direction, (double)w.heading_to_next });
+    }
+    return AdoptVector(std::move(table), { (py::ssize_t)route.size(), 5 });
+}
+
+static py::tuple LoadZone(const std::string& path)
+{
+    ZoneGeometry zone;
+    const char* status = "";
+    bool changed = true;
+    if (!LoadCustomZonePoints(path.c_str(), zone, &status, nullptr, &changed)) {
+        throw py::value_error(path + ": " + status);
+    }
+    std::vector<double> points;
+    points.reserve(zone.points.size() * 3);
+    for (const auto& p : zone.points) {
+        points.insert(points.end(), { std::get<0>(p), std::get<1>(p), std::get<2>(p) });
+    }
+    py::ssize_t n = (py::ssize_t)zone.points.size();
+    return py::make_tuple(AdoptVector(std::move(points), { n, 3 }), TrianglesToArray(std::move(zone.cap_triangles)));
+}
+
+static py::array_t<bool> PointsInZone(const DoubleArray& zone_points, const DoubleArray& lat, const DoubleArray& lon)
+{
+    if (lat.size() != lon.size()) throw py::value_error("lat and lon must have the same size");
+    ZoneGeometry zone = ZoneFromArray(zone_points);
+    py::array_t<bool> inside(lat.size());
+    const double* la = lat.data();
+    const double* lo = lon.data();
+    bool* out = inside.mutable_data();
+    py::ssize_t n = lat.size();
+    {
+        py::gil_scoped_release release;
+        for (py::ssize_t i = 0; i < n; ++i) out[i] = PointInZone(zone, la[i], lo[i]);
+    }
+    return inside;
+}
+
+// RouteProgress over a route given as an (N, 2+) lat/lon array
+class PyRouteProgress {
+public:
+    explicit PyRouteProgress(const DoubleArray& waypoints) {
+        RequireColumns(waypoints, 2, "waypoints");
+        auto w = waypoints.unchecked<2>();
+        for (py::ssize_t i = 0; i < w.shape(0); ++i) {
+            m_lat.push_back(w(i, 0));
+            m_lon.push_back(w(i, 1));
+            m_cos_lat.push_back(cos(w(i, 0) * M_PI / 180.0));
+        }
+        m_route.Reset((int)m_lat.size());
+    }
+
+    void Reset() { m_route.Reset((int)m_lat.size()); }
+
+    // Same step the plugin's guidance loop runs once per frame
+    int Update(double lat, double lon) {
+        double cos_lat = cos(lat * M_PI / 180.0);
+        return m_route.Update([&](int i) { return haversine_m(lat, lon, cos_lat, m_lat[i], m_lon[i], m_cos_lat[i]); });
+    }
+
+    // Runs Update over a track, returns the active waypoint after each sample
+    py::array_t<int> Replay(const DoubleArray& lat, const DoubleArray& lon) {
+        if (lat.size() != lon.size()) throw py::value_error("lat and lon must have the same size");
+        py::array_t<int> active(lat.size());
+        const double* la = lat.data();
+        const double* lo = lon.data();
+        int* out = active.mutable_data();
+        py::ssize_t n = lat.size();
+        {
+            py::gil_scoped_release release;
+            for (py::ssize_t i = 0; i < n; ++i) {
+                Update(la[i], lo[i]);
+                out[i] = m_route.active;
+            }
+        }
+        return active;
+    }
+
+    int Active() const { return m_route.active; }
+    double PrevDist() const { return m_route.prev_dist; }
+    int PassedCount() const { return m_route.PassedCount(); }
+    std::vector<unsigned char>& Passed() { return m_route.passed; }
+
+private:
+    std::vector<double> m_lat, m_lon, m_cos_lat;
+    RouteProgress m_route;
+};
+
+PYBIND11_MODULE(hudcore, m)
+{
+    m.doc() = "Geodesy, route sequencing and zone logic shared with the X-Plane HUD plugin";
+
+    m.def("haversine_m", py::vectorize(static_cast<double (*)(double, double, double, double)>(&haversine_m)),
+          py::arg("lat1"), py::arg("lon1"), py::arg("lat2"), py::arg("lon2"),
+          "Great-circle distance in meters, broadcasts over arrays");
+
+    m.def("load_waypoints", &LoadWaypoints, py::arg("path"),
+          "Parses a waypoint file into an (N, 5) array: lat, lon, alt_m, direction, heading_to_next");
+    m.def("load_zone", &LoadZone, py::arg("path"),
+          "Parses a zone file into ((N, 3) lat/lon/alt_m points, (M, 3) cap triangle indices)");
+    m.def("triangulate_zone",
+          [](const DoubleArray& points) { return TrianglesToArray(TriangulateZone(ZoneFromArray(points).points)); },
+          py::arg("points"), "Ear-clips a zone outline, returns (M, 3) indices into points");
+    m.def("points_in_zone", &PointsInZone, py::arg("zone_points"), py::arg("lat"), py::arg("lon"),
+          "Boolean array, true where (lat, lon) is inside the zone outline");
+
+    py::class_<PyRouteProgress>(m, "RouteProgress")
+        .def(py::init<const DoubleArray&>(), py::arg("waypoints"))
+        .def("reset", &PyRouteProgress::Reset)
+        .def("update", &PyRouteProgress::Update, py::arg("lat"), py::arg("lon"),
+             "Advances the sequencing by one position, returns the waypoint passed or -1")
+        .def("replay", &PyRouteProgress::Replay, py::arg("lat"), py::arg("lon"),
+             "Runs update over a track, returns the active waypoint after each sample")
+        .def_property_readonly("active", &PyRouteProgress::Active)
+        .def_property_readonly("prev_dist", &PyRouteProgress::PrevDist)
+        .def_property_readonly("passed_count", &PyRouteProgress::PassedCount)
+        // Copy of the passed flags, a view would change under the caller on update() and reset()
+        .def_property_readonly("passed", [](PyRouteProgress& self) {
+            const std::vector<unsigned char>& passed = self.Passed();
+            return py::array_t<bool>({ (py::ssize_t)passed.size() }, { (py::ssize_t)1 },
+                                     reinterpret_cast<const bool*>(passed.data()));
+        });
+}
@@ -0,0 +1,27 @@
+"""Builds the hudcore extension module from HudCore.h.
+
+usage: pip install ./python        (pybind11 comes from pyproject.toml)
+   or: python python/setup.py build_ext --inplace   (pybind11 installed beforehand)
+"""
+import os
+
+from pybind11.setup_helpers import Pybind11Extension, build_ext
+from setuptools import setup
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+setup(
+    name="hudcore",
+    version="1.0",
+    description="Geodesy, route and zone logic shared with the X-Plane HUD plugin",
+    ext_modules=[
+        Pybind11Extension(
+            "hudcore",
+            [os.path.join(HERE, "hudcore_module.cpp")],
+            include_dirs=[os.path.dirname(HERE)],
+            cxx_std=17,
+        ),
+    ],
+    cmdclass={"build_ext": build_ext},
+    install_requires=["numpy"],
+)
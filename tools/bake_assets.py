@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Compiles waypoint, zone and HUD layout text files into a C++ header of constexpr tables.
+
+Routes use the same format as custom_waypoints.txt (lat lon alt_m direction),
+zones the same format as custom_zones.txt (lat lon alt_m), HUD layouts the
+format of assets/hud_layout.hud (name anchor x y w h). '#' starts a comment.
+
+Everything the plugin would otherwise compute at runtime for the built-in
+scenarios (sin/cos of lat/lon, WGS84 ECEF position, bearing and length of
+each leg) is computed here once.
+
+usage: bake_assets.py -o generated/BakedAssets.h \
+           --route seattle_to_kelowna=assets/seattle_to_kelowna.wpt \
+           --zone seattle_zone=assets/seattle_zone.zone \
+           --hud-layout hud_layout=assets/hud_layout.hud
+"""
+import argparse
+import math
+import os
+import sys
+
+EARTH_RADIUS_M = 6371000.0      # same as haversine_m in Main.cpp
+WGS84_A = 6378137.0
+WGS84_E2 = 6.69437999014e-3
+
+
+def parse_rows(path, ncols):
+    rows = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split('#', 1)[0].strip()
+            if not line:
+                continue
+            fields = line.split()
+            if len(fields) != ncols:
+                sys.exit(f"{path}:{lineno}: expected {ncols} fields, got {len(fields)}")
+            rows.append(fields)
+    return rows
+
+
+def ecef(lat_deg, lon_deg, alt_m):
+    lat, lon = math.radians(lat_deg), math.radians(lon_deg)
+    n = WGS84_A / math.sqrt(1.0 - WGS84_E2 * math.sin(lat) ** 2)
+    return ((n + alt_m) * math.cos(lat) * math.cos(lon),
+            (n + alt_m) * math.cos(lat) * math.sin(lon),
+            (n * (1.0 - WGS84_E2) + alt_m) * math.sin(lat))
+
+
+def haversine_m(lat1, lon1, lat2, lon2):
+    dlat = math.radians(lat2 - lat1)
+    dlon = math.radians(lon2 - lon1)
+    a = (math.sin(dlat / 2) ** 2 +
+         math.cos(math.radians(lat1)) * math.cos(math.radians(lat2)) * math.sin(dlon / 2) ** 2)
+    return EARTH_RADIUS_M * 2 * math.atan2(math.sqrt(a), math.sqrt(1 - a))
+
+
+def bearing_deg(lat1, lon1, lat2, lon2):
+    p1, p2 = math.radians(lat1), math.radians(lat2)
+    dl = math.radians(lon2 - lon1)
+    y = math.sin(dl) * math.cos(p2)
+    x = math.cos(p1) * math.sin(p2) - math.sin(p1) * math.cos(p2) * math.cos(dl)
+    return (math.degrees(math.atan2(y, x)) + 360.0) % 360.0
+
+
+def num(v):
+    return repr(float(v))
+
+
+HUD_ANCHORS = {
+    'center': 'HUD_ANCHOR_CENTER',
+    'bottom': 'HUD_ANCHOR_BOTTOM',
+    'bottom_left': 'HUD_ANCHOR_BOTTOM_LEFT',
+    'top': 'HUD_ANCHOR_TOP',
+}
+
+
+def emit_route(out, name, path):
+    rows = [(float(a), float(b), float(c), int(d)) for a, b, c, d in parse_rows(path, 4)]
+    if not rows:
+        sys.exit(f"{path}: no waypoints")
+    out.append(f"// {os.path.basename(path)}")
+    out.append(f"static constexpr BakedWaypoint g_baked_{name}[] = {{")
+    for i, (lat, lon, alt, direction) in enumerate(rows):
+        x, y, z = ecef(lat, lon, alt)
+        if i + 1 < len(rows):
+            nlat, nlon = rows[i + 1][0], rows[i + 1][1]
+            brg, leg = bearing_deg(lat, lon, nlat, nlon), haversine_m(lat, lon, nlat, nlon)
+        else:
+            brg, leg = 0.0, 0.0
+        r_lat, r_lon = math.radians(lat), math.radians(lon)
+        fields = [num(lat), num(lon), num(alt), str(direction),
+                  num(math.sin(r_lat)), num(math.cos(r_lat)), num(math.sin(r_lon)), num(math.cos(r_lon)),
+                  num(x), num(y), num(z), num(brg), num(leg)]
+        out.append("    { " + ", ".join(fields) + " },")
+    out.append("};")
+    out.append(f"static constexpr int g_baked_{name}_count = {len(rows)};")
+    out.append("")
+
+
+def emit_zone(out, name, path):
+    rows = [(float(a), float(b), float(c)) for a, b, c in parse_rows(path, 3)]
+    if len(rows) < 3:
+        sys.exit(f"{path}: a zone needs at least 3 points")
+    out.append(f"// {os.path.basename(path)}")
+    out.append(f"static constexpr BakedZonePoint g_baked_{name}[] = {{")
+    for lat, lon, alt in rows:
+        r_lat, r_lon = math.radians(lat), math.radians(lon)
+        fields = [num(lat), num(lon), num(alt),
+                  num(math.sin(r_lat)), num(math.cos(r_lat)), num(math.sin(r_lon)), num(math.cos(r_lon))]
+        out.append("    { " + ", ".join(fields) + " },")
+    out.append("};")
+    out.append(f"static constexpr int g_baked_{name}_count = {len(rows)};")
+    out.append("")
+
+
+def emit_hud_layout(out, name, path):
+    rows = parse_rows(path, 6)
+    if not rows:
+        sys.exit(f"{path}: no layout elements")
+    out.append(f"// {os.path.basename(path)}")
+    out.append(f"static constexpr BakedHudElement g_baked_{name}[] = {{")
+    for element, anchor, x, y, w, h in rows:
+        if anchor not in HUD_ANCHORS:
+            sys.exit(f"{path}: {element}: unknown anchor '{anchor}'")
+        fields = [f'"{element}"', HUD_ANCHORS[anchor]] + [num(v) + 'f' for v in (x, y, w, h)]
+        out.append("    { " + ", ".join(fields) + " },")
+    out.append("};")
+    out.append(f"static constexpr int g_baked_{name}_count = {len(rows)};")
+    out.append("")
+
+
+HEADER = """\
+// Generated by tools/bake_assets.py, do not edit.
+#pragma once
+
+// Waypoint with everything the route logic needs precomputed
+struct BakedWaypoint {
+    double lat, lon, alt_m;
+    int direction; // 1 = up arrow, 0 = dot, -1 = down arrow
+    double sin_lat, cos_lat, sin_lon, cos_lon;
+    double ecef_x, ecef_y, ecef_z; // WGS84, meters
+    double bearing_deg;            // initial great-circle bearing to the next waypoint
+    double leg_m;                  // great-circle distance to the next waypoint
+};
+
+struct BakedZonePoint {
+    double lat, lon, alt_m;
+    double sin_lat, cos_lat, sin_lon, cos_lon;
+};
+
+// Screen point a HUD element's offset is measured from
+enum BakedHudAnchor { HUD_ANCHOR_CENTER, HUD_ANCHOR_BOTTOM, HUD_ANCHOR_BOTTOM_LEFT, HUD_ANCHOR_TOP };
+
+struct BakedHudElement {
+    const char* name;
+    BakedHudAnchor anchor;
+    float x, y; // pixels from the anchor
+    float w, h; // element specific sizes, see assets/hud_layout.hud
+};
+"""
+
+
+def split_arg(arg):
+    if '=' not in arg:
+        sys.exit(f"expected NAME=PATH, got '{arg}'")
+    return arg.split('=', 1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('-o', '--output', required=True)
+    ap.add_argument('--route', action='append', default=[], metavar='NAME=PATH')
+    ap.add_argument('--zone', action='append', default=[], metavar='NAME=PATH')
+    ap.add_argument('--hud-layout', action='append', default=[], metavar='NAME=PATH')
+    args = ap.parse_args()
+
+    out = [HEADER]
+    for arg in args.route:
+        emit_route(out, *split_arg(arg))
+    for arg in args.zone:
+        emit_zone(out, *split_arg(arg))
+    for arg in args.hud_layout:
+        emit_hud_layout(out, *split_arg(arg))
+    text = "\n".join(out)
+
+    # Only touch the output when it changes so the plugin is not rebuilt needlessly
+    if os.path.exists(args.output):
+        with open(args.output) as f:
+            if f.read() == text:
+                return
+    os.makedirs(os.path.dirname(args.output) or '.', exist_ok=True)
+    with open(args.output, 'w') as f:
+        f.write(text)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,366 @@
+// Scores recorded training flights offline, using the plugin's own zone,
+// route sequencing, landing assist and traffic conflict code (HudCore.h),
+// so the numbers match what the pilot saw on the HUD.
+//
+// Every session log is processed on its own, so the logs are handed out to
+// one worker thread per core and nothing is shared between the workers
+// except the index of the next log to take.
+//
+// Session log, one sample per line in time order, '#' starts a comment:
+//     own,time_s,lat,lon,elevation_m,agl_m,track_deg,gs_mps,vs_mps
+//     time_s,id,lat,lon,alt_m,track_deg,gs_mps,vs_mps[,callsign]
+// The plugin's "Record Session" menu item writes these logs (see the
+// session recorder in Main.cpp). The second form is the traffic feed
+// format, so a traffic recording made for "Replay Recorded Traffic" can
+// also be merged into a session as is.
+//
+// Output is one CSV row per session, in the order the logs were given.
+//
+// build: g++ -std=c++17 -O2 -pthread -I. tools/flight_analysis.cpp -o flight_analysis
+// usage: flight_analysis [-j N] [-o summary.csv] [--zone file.zone] [--route file.wpt] session.csv...
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "HudCore.h"
+#ifdef HUD_BAKED_ASSETS_HEADER
+#include HUD_BAKED_ASSETS_HEADER
+#else
+#include "generated/BakedAssets.h"
+#endif
+
+// ──────────────────────────────────
+// Tunables, the same values the plugin uses
+// ──────────────────────────────────
+static float  g_zone_height_m          = 2500.0f;  // zones are drawn this far above their floor
+static double g_traffic_query_radius_m = 30000.0;  // feed targets further away are not drawn
+static float  g_traffic_stale_s        = 20.0f;    // targets silent this long are dropped
+
+// Scoring only, the plugin shows landing assist at any distance
+static double g_approach_m             = 15000.0;  // glide path is scored inside this runway distance
+
+// ──────────────────────────────────
+// Inputs shared by all workers, read only once the workers start
+// ──────────────────────────────────
+struct RoutePoint {
+    double lat, lon, cos_lat;
+};
+
+struct AnalysisSetup {
+    ZoneGeometry zone;
+    float zone_floor_m, zone_ceiling_m;
+    std::vector<RoutePoint> route;
+};
+
+struct SessionSummary {
+    bool ok;
+    std::string error;
+    int samples;
+    double start_s, end_s;
+    int zone_entries;
+    double zone_time_s;
+    int waypoints_passed;
+    double first_pass_s, last_pass_s; // -1 if none
+    int approach_samples;
+    double gp_rms_m, gp_max_m, loc_max_m;
+    int traffic_targets;
+    int caution_events, warning_events;
+    float min_range_m;                // -1 if no traffic was in range
+};
+
+struct TrackedTarget {
+    double t, lat, lon;
+    float alt_m, track_deg, gs_mps, vs_mps;
+    TrafficThreat threat; // at the last own-ship sample
+};
+
+// ──────────────────────────────────
+// One session
+// ──────────────────────────────────
+static bool ParseOwnLine(const char* line, double& t, double& lat, double& lon, float& elev_m, float& agl_m,
+                         float& track_deg, float& gs_mps, float& vs_mps)
+{
+    return sscanf(line, "own,%lf,%lf,%lf,%f,%f,%f,%f,%f", &t, &lat, &lon, &elev_m, &agl_m, &track_deg, &gs_mps, &vs_mps) == 8;
+}
+
+static bool ParseTrafficLine(const char* line, double& t, unsigned& id, TrackedTarget& out)
+{
+    return sscanf(line, "%lf,%u,%lf,%lf,%f,%f,%f,%f",
+        &t, &id, &out.lat, &out.lon, &out.alt_m, &out.track_deg, &out.gs_mps, &out.vs_mps) == 8;
+}
+
+static SessionSummary AnalyzeSession(const char* path, const AnalysisSetup& setup, TrafficTable& table)
+{
+    SessionSummary s = {};
+    s.first_pass_s = s.last_pass_s = -1.0;
+    s.min_range_m = -1.0f;
+
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        s.error = "cannot open";
+        return s;
+    }
+
+    RouteProgress route;
+    route.Reset((int)setup.route.size());
+    bool in_zone = false;
+    bool on_approach = false;
+    double radout_init = 0.0;
+    double gp_sum2 = 0.0;
+    double prev_t = 0.0;
+    std::unordered_map<unsigned, TrackedTarget> targets;
+    std::vector<unsigned> ids;
+
+    char line[512];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        ++line_no;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+
+        if (line[0] != 'o') {
+            double t;
+            unsigned id;
+            TrackedTarget target;
+            if (!ParseTrafficLine(line, t, id, target)) continue; // skips headers and bad lines
+            target.t = t;
+            auto it = targets.find(id);
+            target.threat = it != targets.end() ? it->second.threat : THREAT_NONE;
+            targets[id] = target;
+            continue;
+        }
+
+        double t, lat, lon;
+        float elev_m, agl_m, track_deg, gs_mps, vs_mps;
+        if (!ParseOwnLine(line, t, lat, lon, elev_m, agl_m, track_deg, gs_mps, vs_mps)) {
+            s.error = "bad own-ship line " + std::to_string(line_no);
+            fclose(f);
+            return s;
+        }
+        if (s.samples == 0) s.start_s = t;
+        double dt = s.samples ? t - prev_t : 0.0;
+        prev_t = t;
+        s.end_s = t;
+        ++s.samples;
+
+        // Zone, entries are counted on the way in
+        bool inside = elev_m >= setup.zone_floor_m && elev_m <= setup.zone_ceiling_m && PointInZone(setup.zone, lat, lon);
+        if (inside && !in_zone) ++s.zone_entries;
+        if (inside && in_zone) s.zone_time_s += dt;
+        in_zone = inside;
+
+        // Route, the guidance loop works on the single precision datarefs
+        float ac_lat = (float)lat, ac_lon = (float)lon;
+        double ac_cos_lat = cos(ac_lat * M_PI / 180.0);
+        int passed = route.Update([&](int i) {
+            const RoutePoint& w = setup.route[i];
+            return haversine_m(ac_lat, ac_lon, ac_cos_lat, w.lat, w.lon, w.cos_lat);
+        });
+        if (passed >= 0) {
+            ++s.waypoints_passed;
+            if (s.first_pass_s < 0.0) s.first_pass_s = t;
+            s.last_pass_s = t;
+        }
+
+        // Glide path, as if the landing assist was switched on when the approach began
+        RunwayGuidance g = ComputeRunwayGuidance(g_landing_runway, ac_lat, ac_lon, agl_m, radout_init);
+        if (g.runway_dist_m < g_approach_m) {
+            if (!on_approach) {
+                radout_init = agl_m;
+                g = ComputeRunwayGuidance(g_landing_runway, ac_lat, ac_lon, agl_m, radout_init);
+                on_approach = true;
+            }
+            ++s.approach_samples;
+            gp_sum2 += g.vertical_dev_m * g.vertical_dev_m;
+            s.gp_max_m = std::max(s.gp_max_m, fabs(g.vertical_dev_m));
+            s.loc_max_m = std::max(s.loc_max_m, fabs(g.lateral_offset_m));
+        } else {
+            on_approach = false;
+        }
+
+        // Traffic, in a flat frame around the aircraft with the plugin's axes
+        // (x east, y up, z south), dead-reckoned to this sample like AddFeedTraffic
+        if (targets.empty()) continue;
+        double m_per_deg_lon = 111320.0 * cos(lat * M_PI / 180.0);
+        double radius2 = g_traffic_query_radius_m * g_traffic_query_radius_m;
+        float trk = track_deg * (float)(M_PI / 180.0);
+        table.count = 0;
+        table.time_s = (float)t;
+        table.own_x = table.own_y = table.own_z = 0.0f;
+        table.own_vx = gs_mps * sinf(trk);
+        table.own_vy = vs_mps;
+        table.own_vz = -gs_mps * cosf(trk);
+        ids.clear();
+        for (auto it = targets.begin(); it != targets.end();) {
+            const TrackedTarget& f = it->second;
+            float age = (float)(t - f.t);
+            if (age > g_traffic_stale_s) {
+                it = targets.erase(it);
+                continue;
+            }
+            float ftrk = f.track_deg * (float)(M_PI / 180.0);
+            float vn = f.gs_mps * cosf(ftrk), ve = f.gs_mps * sinf(ftrk);
+            double dn = (f.lat - lat) * 111320.0 + vn * age;
+            double de = (f.lon - lon) * m_per_deg_lon + ve * age;
+            if (dn * dn + de * de <= radius2 && table.count < g_max_traffic) {
+                int k = table.count++;
+                table.x[k] = (float)de;
+                table.y[k] = f.alt_m + f.vs_mps * age - elev_m;
+                table.z[k] = (float)-dn;
+                table.vx[k] = ve;
+                table.vy[k] = f.vs_mps;
+                table.vz[k] = -vn;
+                table.ax[k] = table.ay[k] = table.az[k] = 0.0f;
+                ids.push_back(it->first);
+            }
+            ++it;
+        }
+        s.traffic_targets = std::max(s.traffic_targets, table.count);
+        ComputeTrafficConflicts(table);
+
+        // An event is a target stepping up into caution or warning
+        for (int k = 0; k < table.count; ++k) {
+            TrackedTarget& f = targets[ids[k]];
+            TrafficThreat now = table.threat[k];
+            if (now > f.threat && now == THREAT_CAUTION) ++s.caution_events;
+            if (now > f.threat && now == THREAT_WARNING) ++s.warning_events;
+            f.threat = now;
+            if (s.min_range_m < 0.0f || table.range_m[k] < s.min_range_m) s.min_range_m = table.range_m[k];
+        }
+    }
+    fclose(f);
+
+    if (s.samples == 0) {
+        s.error = "no own-ship samples";
+        return s;
+    }
+    if (s.approach_samples) s.gp_rms_m = sqrt(gp_sum2 / s.approach_samples);
+    s.ok = true;
+    return s;
+}
+
+// ──────────────────────────────────
+// Setup and output
+// ──────────────────────────────────
+static bool LoadSetup(const char* zone_path, const char* route_path, AnalysisSetup& setup)
+{
+    if (zone_path) {
+        const char* status = "";
+        bool changed = true;
+        if (!LoadCustomZonePoints(zone_path, setup.zone, &status, nullptr, &changed)) {
+            fprintf(stderr, "%s: %s\n", zone_path, status);
+            return false;
+        }
+    } else {
+        for (int i = 0; i < g_baked_seattle_zone_count; ++i) {
+            setup.zone.points.emplace_back(g_baked_seattle_zone[i].lat, g_baked_seattle_zone[i].lon, g_baked_seattle_zone[i].alt_m);
+        }
+    }
+    setup.zone_floor_m = (float)std::get<2>(setup.zone.points[0]);
+    setup.zone_ceiling_m = setup.zone_floor_m + g_zone_height_m;
+
+    if (route_path) {
+        std::vector<Waypoint> route;
+        const char* message = "";
+        if (!LoadCustomWaypoints(route_path, route, &message)) {
+            fprintf(stderr, "%s: %s", route_path, message);
+            return false;
+        }
+        for (const Waypoint& w : route) setup.route.push_back({ w.lat, w.lon, cos(w.lat * M_PI / 180.0) });
+    } else {
+        for (int i = 0; i < g_baked_seattle_to_kelowna_count; ++i) {
+            const BakedWaypoint& w = g_baked_seattle_to_kelowna[i];
+            setup.route.push_back({ w.lat, w.lon, w.cos_lat });
+        }
+    }
+    return true;
+}
+
+static void WriteSummary(FILE* out, const std::vector<const char*>& paths, const std::vector<SessionSummary>& results)
+{
+    fprintf(out, "session,status,samples,duration_s,zone_entries,zone_time_s,waypoints_passed,first_pass_s,last_pass_s,"
+                 "approach_samples,gp_rms_m,gp_max_m,loc_max_m,traffic_max,caution_events,warning_events,min_range_m\n");
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const SessionSummary& s = results[i];
+        if (!s.ok) {
+            fprintf(out, "%s,%s,,,,,,,,,,,,,,,\n", paths[i], s.error.c_str());
+            continue;
+        }
+        fprintf(out, "%s,ok,%d,%.1f,%d,%.1f,%d,%.1f,%.1f,%d,%.1f,%.1f,%.1f,%d,%d,%d,%.0f\n",
+            paths[i], s.samples, s.end_s - s.start_s, s.zone_entries, s.zone_time_s,
+            s.waypoints_passed, s.first_pass_s, s.last_pass_s,
+            s.approach_samples, s.gp_rms_m, s.gp_max_m, s.loc_max_m,
+            s.traffic_targets, s.caution_events, s.warning_events, s.min_range_m);
+    }
+}
+
+static void Usage()
+{
+    fprintf(stderr, "usage: flight_analysis [-j N] [-o summary.csv] [--zone file.zone] [--route file.wpt] session.csv...\n");
+}
+
+int main(int argc, char** argv)
+{
+    int jobs = (int)std::thread::hardware_concurrency();
+    const char* out_path = nullptr;
+    const char* zone_path = nullptr;
+    const char* route_path = nullptr;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "-j") && has_value) jobs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && has_value) out_path = argv[++i];
+        else if (!strcmp(argv[i], "--zone") && has_value) zone_path = argv[++i];
+        else if (!strcmp(argv[i], "--route") && has_value) route_path = argv[++i];
+        else if (argv[i][0] == '-') { Usage(); return 2; }
+        else paths.push_back(argv[i]);
+    }
+    if (paths.empty()) { Usage(); return 2; }
+
+    AnalysisSetup setup;
+    if (!LoadSetup(zone_path, route_path, setup)) return 1;
+
+    jobs = std::max(1, std::min(jobs, (int)paths.size()));
+    std::vector<SessionSummary> results(paths.size());
+    std::atomic<size_t> next(0);
+    auto start = std::chrono::steady_clock::now();
+
+    // Each worker keeps its own traffic table, results go to the slot of their log
+    auto worker = [&] {
+        std::unique_ptr<TrafficTable> table(new TrafficTable());
+        for (size_t i; (i = next.fetch_add(1)) < paths.size();) {
+            results[i] = AnalyzeSession(paths[i], setup, *table);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < jobs; ++i) threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads) t.join();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int failed = 0;
+    long long samples = 0;
+    for (const SessionSummary& s : results) {
+        failed += s.ok ? 0 : 1;
+        samples += s.samples;
+    }
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "%s: cannot open for writing\n", out_path);
+        return 1;
+    }
+    WriteSummary(out, paths, results);
+    if (out != stdout) fclose(out);
+
+    fprintf(stderr, "%zu sessions (%d failed), %lld samples in %.2f s on %d threads\n",
+        paths.size(), failed, samples, elapsed, jobs);
+    return failed ? 1 : 0;
+}
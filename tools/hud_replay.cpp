@@ -0,0 +1,816 @@
+// Headless stand-in for X-Plane that loads the plugin and replays recorded
+// sessions through its flight loops and draw callbacks, timing every
+// callback. It is the training run for the profile-guided build (see
+// CMakeLists.txt) and reports the per-callback speedup between two builds.
+//
+// The XPLM API the plugin uses and the OpenGL entry points it calls are
+// defined here and exported from the executable, so the dynamic linker
+// binds the plugin to them instead of to X-Plane and libGL. GL calls do
+// nothing: only the plugin's own CPU work is measured, which is also what
+// the compiler gets to optimize. Datarefs are plain values set from the
+// session, and the world is a flat projection around the first sample.
+//
+// Sessions use the flight_analysis format (own-ship lines plus traffic feed
+// lines). Traffic lines are written to the plugin's replay file and played
+// through "Replay Recorded Traffic". Fonts and DEM tiles are read from
+// --root like they would be from the X-Plane folder; without them the
+// plugin runs its fallbacks.
+//
+// Linux only.
+// usage: hud_replay --plugin lin.xpl [--root DIR] [--fps 30] [--menu NAME]...
+//                   [--report times.csv] [--compare baseline.csv] session.csv...
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+
+#include <GL/gl.h>
+#include <GL/glx.h>
+
+#include "XPLMDataAccess.h"
+#include "XPLMDisplay.h"
+#include "XPLMGraphics.h"
+#include "XPLMMenus.h"
+#include "XPLMPlanes.h"
+#include "XPLMProcessing.h"
+#include "XPLMScenery.h"
+#include "XPLMUtilities.h"
+
+// ──────────────────────────────────
+// Host state
+// ──────────────────────────────────
+static int   g_screen_w = 1920, g_screen_h = 1080;
+static float g_fov_deg  = 60.0f;
+static bool  g_verbose  = false;
+
+static std::string g_root = "./";
+static float g_sim_time = 0.0f;
+static int   g_cycle = 0;
+
+// Flat earth around the first own-ship sample: x east, y up, z south
+static double g_ref_lat = 0.0, g_ref_lon = 0.0, g_m_per_deg_lon = 111320.0;
+static const double g_m_per_deg_lat = 111320.0;
+
+// Camera for the matrices the plugin reads back, column major
+static float g_modelview[16], g_projection[16];
+
+struct DataRefValue {
+    double value;
+};
+static std::unordered_map<std::string, std::unique_ptr<DataRefValue>> g_datarefs;
+
+// Data the plugin publishes, kept only so they can be unregistered
+struct Accessor {
+    std::string name;
+};
+static std::vector<std::unique_ptr<Accessor>> g_accessors;
+
+struct Menu {
+    XPLMMenuHandler_f handler;
+    void* ref;
+};
+struct MenuItem {
+    Menu* menu;
+    std::string name;
+    void* ref;
+};
+static std::vector<std::unique_ptr<Menu>> g_menus;
+static std::vector<MenuItem> g_menu_items;
+static Menu g_plugins_menu = { NULL, NULL };
+
+// Timing per callback, keyed by name so toggled callbacks keep their totals
+struct CallbackStats {
+    long long calls;
+    double total_s;
+};
+static std::map<std::string, CallbackStats> g_stats;
+static std::unordered_map<void*, std::string> g_symbols; // function offset in the plugin -> name
+static void* g_plugin_base = NULL;
+
+struct DrawRegistration {
+    XPLMDrawCallback_f fn;
+    XPLMDrawingPhase phase;
+    int before;
+    void* refcon;
+    std::string name;
+};
+static std::vector<DrawRegistration> g_draw;
+
+struct FlightLoopRegistration {
+    XPLMFlightLoop_f fn;
+    void* refcon;
+    float interval;  // as returned by the callback, see XPLMFlightLoop_f
+    float next_time; // for positive intervals
+    int next_cycle;  // for negative intervals
+    float last_call;
+    int counter;
+    bool removed;
+    std::string name;
+};
+static std::vector<FlightLoopRegistration> g_loops;
+
+static DataRefValue* Ref(const char* name)
+{
+    std::unique_ptr<DataRefValue>& v = g_datarefs[name];
+    if (!v) v.reset(new DataRefValue{ 0.0 });
+    return v.get();
+}
+
+static void Set(const char* name, double value) { Ref(name)->value = value; }
+
+// Name of a plugin function from its symbol table, or a numbered fallback
+static std::string CallbackName(void* fn, const char* kind)
+{
+    auto it = g_symbols.find((void*)((char*)fn - (char*)g_plugin_base));
+    if (it != g_symbols.end()) return it->second;
+    char name[64];
+    snprintf(name, sizeof(name), "%s@%p", kind, (void*)((char*)fn - (char*)g_plugin_base));
+    return name;
+}
+
+// Static functions are not in the dynamic symbol table, so read the full
+// one with nm. Parameter lists and LTO suffixes (.lto_priv.0) are dropped.
+static void LoadPluginSymbols(const char* path)
+{
+    std::string cmd = std::string("nm -C --defined-only \"") + path + "\" 2>/dev/null";
+    FILE* p = popen(cmd.c_str(), "r");
+    if (!p) return;
+    char line[1024];
+    while (fgets(line, sizeof(line), p)) {
+        unsigned long long addr;
+        char type;
+        int name_at = 0;
+        if (sscanf(line, "%llx %c %n", &addr, &type, &name_at) != 2 || (type != 't' && type != 'T')) continue;
+        std::string name = line + name_at;
+        name = name.substr(0, name.find_first_of("(.\r\n"));
+        g_symbols[(void*)(uintptr_t)addr] = name;
+    }
+    pclose(p);
+}
+
+template <typename Fn>
+static auto Timed(const std::string& name, Fn fn) -> decltype(fn())
+{
+    auto start = std::chrono::steady_clock::now();
+    struct Record {
+        const std::string& name;
+        std::chrono::steady_clock::time_point start;
+        ~Record() {
+            CallbackStats& s = g_stats[name];
+            ++s.calls;
+            s.total_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    } record{ name, start };
+    return fn();
+}
+
+// ──────────────────────────────────
+// XPLM
+// ──────────────────────────────────
+XPLMDataRef XPLMFindDataRef(const char* inDataRefName) { return Ref(inDataRefName); }
+float XPLMGetDataf(XPLMDataRef inDataRef) { return inDataRef ? (float)((DataRefValue*)inDataRef)->value : 0.0f; }
+double XPLMGetDatad(XPLMDataRef inDataRef) { return inDataRef ? ((DataRefValue*)inDataRef)->value : 0.0; }
+int XPLMGetDatai(XPLMDataRef inDataRef) { return inDataRef ? (int)((DataRefValue*)inDataRef)->value : 0; }
+int XPLMGetDatab(XPLMDataRef, void*, int, int) { return 0; }
+
+XPLMDataRef XPLMRegisterDataAccessor(const char* inDataName, XPLMDataTypeID, int,
+    XPLMGetDatai_f, XPLMSetDatai_f, XPLMGetDataf_f, XPLMSetDataf_f, XPLMGetDatad_f, XPLMSetDatad_f,
+    XPLMGetDatavi_f, XPLMSetDatavi_f, XPLMGetDatavf_f, XPLMSetDatavf_f, XPLMGetDatab_f, XPLMSetDatab_f,
+    void*, void*)
+{
+    g_accessors.emplace_back(new Accessor{ inDataName });
+    return g_accessors.back().get();
+}
+
+void XPLMUnregisterDataAccessor(XPLMDataRef inDataRef)
+{
+    g_accessors.erase(std::remove_if(g_accessors.begin(), g_accessors.end(),
+        [&](const std::unique_ptr<Accessor>& a) { return a.get() == inDataRef; }), g_accessors.end());
+}
+
+void XPLMDebugString(const char* inString)
+{
+    if (g_verbose) fputs(inString, stderr);
+}
+
+void XPLMGetSystemPath(char* outSystemPath) { snprintf(outSystemPath, 512, "%s", g_root.c_str()); }
+const char* XPLMGetDirectorySeparator() { return "/"; }
+void XPLMGetNthAircraftModel(int inIndex, char* outFileName, char* outPath) { outFileName[0] = 0; outPath[0] = 0; }
+void XPLMCountAircraft(int* outTotalAircraft, int* outActiveAircraft, XPLMPluginID* outController)
+{
+    // Sessions only fly the own ship, traffic comes in through the feeds
+    if (outTotalAircraft) *outTotalAircraft = 20;
+    if (outActiveAircraft) *outActiveAircraft = 1;
+    if (outController) *outController = XPLM_NO_PLUGIN_ID;
+}
+
+int XPLMGetDirectoryContents(const char* inDirectoryPath, int inFirstReturn, char* outFileNames, int inFileNameBufSize,
+                             char** outIndices, int inIndexCount, int* outTotalFiles, int* outReturnedFiles)
+{
+    std::vector<std::string> names;
+    if (DIR* dir = opendir(inDirectoryPath)) {
+        while (dirent* ent = readdir(dir)) {
+            if (strcmp(ent->d_name, ".") && strcmp(ent->d_name, "..")) names.push_back(ent->d_name);
+        }
+        closedir(dir);
+    }
+    int returned = 0, used = 0;
+    for (int i = inFirstReturn; i < (int)names.size() && returned < inIndexCount; ++i) {
+        int len = (int)names[i].size() + 1;
+        if (used + len > inFileNameBufSize) break;
+        memcpy(outFileNames + used, names[i].c_str(), len);
+        if (outIndices) outIndices[returned] = outFileNames + used;
+        used += len;
+        ++returned;
+    }
+    if (outTotalFiles) *outTotalFiles = (int)names.size();
+    if (outReturnedFiles) *outReturnedFiles = returned;
+    return inFirstReturn + returned >= (int)names.size();
+}
+XPLMCommandRef XPLMFindCommand(const char*) { return NULL; }
+void XPLMCommandOnce(XPLMCommandRef) {}
+
+XPLMMenuID XPLMFindPluginsMenu() { return &g_plugins_menu; }
+XPLMMenuID XPLMFindAircraftMenu() { return NULL; }
+
+XPLMMenuID XPLMCreateMenu(const char*, XPLMMenuID, int, XPLMMenuHandler_f inHandler, void* inMenuRef)
+{
+    g_menus.emplace_back(new Menu{ inHandler, inMenuRef });
+    return g_menus.back().get();
+}
+
+void XPLMDestroyMenu(XPLMMenuID inMenuID)
+{
+    g_menu_items.erase(std::remove_if(g_menu_items.begin(), g_menu_items.end(),
+        [&](const MenuItem& m) { return m.menu == inMenuID; }), g_menu_items.end());
+}
+
+int XPLMAppendMenuItem(XPLMMenuID inMenu, const char* inItemName, void* inItemRef, int)
+{
+    g_menu_items.push_back({ (Menu*)inMenu, inItemName, inItemRef });
+    return (int)g_menu_items.size() - 1;
+}
+
+void XPLMAppendMenuSeparator(XPLMMenuID) {}
+void XPLMCheckMenuItem(XPLMMenuID, int, XPLMMenuCheck) {}
+
+void XPLMClearAllMenuItems(XPLMMenuID inMenuID)
+{
+    XPLMDestroyMenu(inMenuID);
+}
+int XPLMAppendMenuItemWithCommand(XPLMMenuID, const char*, XPLMCommandRef) { return -1; }
+
+int XPLMRegisterDrawCallback(XPLMDrawCallback_f inCallback, XPLMDrawingPhase inPhase, int inWantsBefore, void* inRefcon)
+{
+    g_draw.push_back({ inCallback, inPhase, inWantsBefore, inRefcon, CallbackName((void*)inCallback, "draw") });
+    return 1;
+}
+
+int XPLMUnregisterDrawCallback(XPLMDrawCallback_f inCallback, XPLMDrawingPhase inPhase, int inWantsBefore, void* inRefcon)
+{
+    for (size_t i = 0; i < g_draw.size(); ++i) {
+        const DrawRegistration& d = g_draw[i];
+        if (d.fn == inCallback && d.phase == inPhase && d.before == inWantsBefore && d.refcon == inRefcon) {
+            g_draw.erase(g_draw.begin() + i);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void XPLMGetScreenSize(int* outWidth, int* outHeight)
+{
+    if (outWidth) *outWidth = g_screen_w;
+    if (outHeight) *outHeight = g_screen_h;
+}
+
+float XPLMGetElapsedTime() { return g_sim_time; }
+int XPLMGetCycleNumber() { return g_cycle; }
+
+void XPLMRegisterFlightLoopCallback(XPLMFlightLoop_f inFlightLoop, float inInterval, void* inRefcon)
+{
+    g_loops.push_back({ inFlightLoop, inRefcon, inInterval, g_sim_time + inInterval, g_cycle - (int)inInterval,
+                        g_sim_time, 0, false, CallbackName((void*)inFlightLoop, "flight_loop") });
+}
+
+void XPLMUnregisterFlightLoopCallback(XPLMFlightLoop_f inFlightLoop, void* inRefcon)
+{
+    for (FlightLoopRegistration& l : g_loops) {
+        if (l.fn == inFlightLoop && l.refcon == inRefcon) l.removed = true;
+    }
+}
+
+void XPLMWorldToLocal(double inLatitude, double inLongitude, double inAltitude, double* outX, double* outY, double* outZ)
+{
+    *outX = (inLongitude - g_ref_lon) * g_m_per_deg_lon;
+    *outY = inAltitude;
+    *outZ = -(inLatitude - g_ref_lat) * g_m_per_deg_lat;
+}
+
+void XPLMLocalToWorld(double inX, double inY, double inZ, double* outLatitude, double* outLongitude, double* outAltitude)
+{
+    *outLatitude = g_ref_lat - inZ / g_m_per_deg_lat;
+    *outLongitude = g_ref_lon + inX / g_m_per_deg_lon;
+    *outAltitude = inY;
+}
+
+void XPLMSetGraphicsState(int, int, int, int, int, int, int) {}
+void XPLMBindTexture2d(int, int) {}
+
+void XPLMGenerateTextureNumbers(int* outTextureIDs, int inCount)
+{
+    static int next = 1;
+    for (int i = 0; i < inCount; ++i) outTextureIDs[i] = next++;
+}
+
+void XPLMDrawString(float*, int, int, char*, int*, XPLMFontID) {}
+
+// The ground is flat at the elevation the session reports under the aircraft
+static int g_probe;
+XPLMProbeRef XPLMCreateProbe(XPLMProbeType) { return &g_probe; }
+void XPLMDestroyProbe(XPLMProbeRef) {}
+
+XPLMProbeResult XPLMProbeTerrainXYZ(XPLMProbeRef, float inX, float, float inZ, XPLMProbeInfo_t* outInfo)
+{
+    outInfo->locationX = inX;
+    outInfo->locationY = (float)(XPLMGetDatad(Ref("sim/flightmodel/position/elevation")) -
+                                 XPLMGetDatad(Ref("sim/flightmodel/position/y_agl")));
+    outInfo->locationZ = inZ;
+    return xplm_ProbeHitTerrain;
+}
+
+// ──────────────────────────────────
+// OpenGL, calls are accepted and dropped
+// ──────────────────────────────────
+static GLuint g_next_gl_name = 1;
+
+static void GenNames(GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; ++i) names[i] = g_next_gl_name++;
+}
+
+void glBegin(GLenum) {}
+void glEnd() {}
+void glBlendFunc(GLenum, GLenum) {}
+void glClear(GLbitfield) {}
+void glClearColor(GLclampf, GLclampf, GLclampf, GLclampf) {}
+void glColor3fv(const GLfloat*) {}
+void glColor4f(GLfloat, GLfloat, GLfloat, GLfloat) {}
+void glColorPointer(GLint, GLenum, GLsizei, const GLvoid*) {}
+void glDeleteTextures(GLsizei, const GLuint*) {}
+void glDisable(GLenum) {}
+void glEnable(GLenum) {}
+void glDisableClientState(GLenum) {}
+void glDrawArrays(GLenum, GLint, GLsizei) {}
+void glDrawBuffer(GLenum) {}
+void glEnableClientState(GLenum) {}
+GLenum glGetError() { return GL_NO_ERROR; }
+void glDrawElements(GLenum, GLsizei, GLenum, const GLvoid*) {}
+void glLineWidth(GLfloat) {}
+void glLoadIdentity() {}
+void glMatrixMode(GLenum) {}
+void glMultMatrixd(const GLdouble*) {}
+void glOrtho(GLdouble, GLdouble, GLdouble, GLdouble, GLdouble, GLdouble) {}
+void glPolygonMode(GLenum, GLenum) {}
+void glPolygonOffset(GLfloat, GLfloat) {}
+void glPushMatrix() {}
+void glPopMatrix() {}
+void glRotatef(GLfloat, GLfloat, GLfloat, GLfloat) {}
+void glScalef(GLfloat, GLfloat, GLfloat) {}
+void glTranslatef(GLfloat, GLfloat, GLfloat) {}
+void glTexCoord2f(GLfloat, GLfloat) {}
+void glTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const GLvoid*) {}
+void glTexParameteri(GLenum, GLenum, GLint) {}
+void glVertex2f(GLfloat, GLfloat) {}
+void glVertex3f(GLfloat, GLfloat, GLfloat) {}
+void glVertex3fv(const GLfloat*) {}
+void glVertexPointer(GLint, GLenum, GLsizei, const GLvoid*) {}
+void glViewport(GLint, GLint, GLsizei, GLsizei) {}
+
+void glGetFloatv(GLenum pname, GLfloat* params)
+{
+    if (pname == GL_MODELVIEW_MATRIX) memcpy(params, g_modelview, sizeof(g_modelview));
+    else if (pname == GL_PROJECTION_MATRIX) memcpy(params, g_projection, sizeof(g_projection));
+    else params[0] = params[1] = params[2] = params[3] = 0.0f;
+}
+
+void glGetIntegerv(GLenum pname, GLint* params)
+{
+    if (pname == GL_VIEWPORT) {
+        params[0] = params[1] = 0;
+        params[2] = g_screen_w;
+        params[3] = g_screen_h;
+    } else {
+        params[0] = 0;
+    }
+}
+
+static void APIENTRY StubGenNames(GLsizei n, GLuint* names) { GenNames(n, names); }
+static void APIENTRY StubDeleteNames(GLsizei, const GLuint*) {}
+static void APIENTRY StubBind(GLenum, GLuint) {}
+static void APIENTRY StubFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint) {}
+static GLenum APIENTRY StubCheckFramebufferStatus(GLenum) { return 0x8CD5; } // GL_FRAMEBUFFER_COMPLETE
+static void APIENTRY StubBlendFuncSeparate(GLenum, GLenum, GLenum, GLenum) {}
+static void APIENTRY StubBufferData(GLenum, ptrdiff_t, const void*, GLenum) {}
+static void APIENTRY StubRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei) {}
+static void APIENTRY StubFramebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint) {}
+static void APIENTRY StubBlitFramebuffer(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum) {}
+static void APIENTRY StubDrawBuffers(GLsizei, const GLenum*) {}
+static GLuint APIENTRY StubCreateShader(GLenum) { return g_next_gl_name++; }
+static GLuint APIENTRY StubCreateProgram() { return g_next_gl_name++; }
+static void APIENTRY StubShaderSource(GLuint, GLsizei, const char* const*, const GLint*) {}
+static void APIENTRY StubName(GLuint) {}
+static void APIENTRY StubGetStatus(GLuint, GLenum, GLint* params) { *params = 1; } // compiled / linked
+static void APIENTRY StubGetInfoLog(GLuint, GLsizei, GLsizei*, char* log) { log[0] = 0; }
+static void APIENTRY StubAttachShader(GLuint, GLuint) {}
+static GLint APIENTRY StubGetUniformLocation(GLuint, const char*) { return 0; }
+static void APIENTRY StubUniform1i(GLint, GLint) {}
+static void APIENTRY StubUniform1f(GLint, GLfloat) {}
+
+void (*glXGetProcAddressARB(const GLubyte* procName))(void)
+{
+    static const struct { const char* name; void (*fn)(void); } procs[] = {
+        { "glGenFramebuffers",        (void (*)(void))StubGenNames },
+        { "glDeleteFramebuffers",     (void (*)(void))StubDeleteNames },
+        { "glBindFramebuffer",        (void (*)(void))StubBind },
+        { "glFramebufferTexture2D",   (void (*)(void))StubFramebufferTexture2D },
+        { "glCheckFramebufferStatus", (void (*)(void))StubCheckFramebufferStatus },
+        { "glBlendFuncSeparate",      (void (*)(void))StubBlendFuncSeparate },
+        { "glGenBuffers",             (void (*)(void))StubGenNames },
+        { "glDeleteBuffers",          (void (*)(void))StubDeleteNames },
+        { "glBindBuffer",             (void (*)(void))StubBind },
+        { "glBufferData",             (void (*)(void))StubBufferData },
+        { "glGenRenderbuffers",       (void (*)(void))StubGenNames },
+        { "glDeleteRenderbuffers",    (void (*)(void))StubDeleteNames },
+        { "glBindRenderbuffer",       (void (*)(void))StubBind },
+        { "glRenderbufferStorage",    (void (*)(void))StubRenderbufferStorage },
+        { "glFramebufferRenderbuffer", (void (*)(void))StubFramebufferRenderbuffer },
+        { "glBlitFramebuffer",        (void (*)(void))StubBlitFramebuffer },
+        { "glDrawBuffers",            (void (*)(void))StubDrawBuffers },
+        { "glCreateShader",           (void (*)(void))StubCreateShader },
+        { "glShaderSource",           (void (*)(void))StubShaderSource },
+        { "glCompileShader",          (void (*)(void))StubName },
+        { "glGetShaderiv",            (void (*)(void))StubGetStatus },
+        { "glGetShaderInfoLog",       (void (*)(void))StubGetInfoLog },
+        { "glDeleteShader",           (void (*)(void))StubName },
+        { "glCreateProgram",          (void (*)(void))StubCreateProgram },
+        { "glAttachShader",           (void (*)(void))StubAttachShader },
+        { "glLinkProgram",            (void (*)(void))StubName },
+        { "glGetProgramiv",           (void (*)(void))StubGetStatus },
+        { "glDeleteProgram",          (void (*)(void))StubName },
+        { "glUseProgram",             (void (*)(void))StubName },
+        { "glGetUniformLocation",     (void (*)(void))StubGetUniformLocation },
+        { "glUniform1i",              (void (*)(void))StubUniform1i },
+        { "glUniform1f",              (void (*)(void))StubUniform1f },
+    };
+    for (const auto& p : procs) {
+        if (!strcmp((const char*)procName, p.name)) return p.fn;
+    }
+    return NULL;
+}
+
+// ──────────────────────────────────
+// Sessions
+// ──────────────────────────────────
+struct OwnSample {
+    double t, lat, lon;
+    float elev_m, agl_m, track_deg, gs_mps, vs_mps;
+};
+
+struct Session {
+    std::vector<OwnSample> own;
+    std::string traffic; // feed lines, as the replay file wants them
+};
+
+static bool LoadSession(const char* path, Session& s)
+{
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        OwnSample o;
+        if (sscanf(line, "own,%lf,%lf,%lf,%f,%f,%f,%f,%f", &o.t, &o.lat, &o.lon, &o.elev_m, &o.agl_m,
+                   &o.track_deg, &o.gs_mps, &o.vs_mps) == 8) {
+            s.own.push_back(o);
+        } else if (line[0] >= '0' && line[0] <= '9') {
+            s.traffic += line;
+        }
+    }
+    fclose(f);
+    return !s.own.empty();
+}
+
+static OwnSample Interpolate(const std::vector<OwnSample>& own, size_t& cursor, double t)
+{
+    while (cursor + 1 < own.size() && own[cursor + 1].t <= t) ++cursor;
+    if (cursor + 1 >= own.size()) return own.back();
+    const OwnSample& a = own[cursor];
+    const OwnSample& b = own[cursor + 1];
+    double f = b.t > a.t ? (t - a.t) / (b.t - a.t) : 0.0;
+    float ff = (float)f;
+    float dtrk = fmodf(b.track_deg - a.track_deg + 540.0f, 360.0f) - 180.0f;
+    return { t, a.lat + (b.lat - a.lat) * f, a.lon + (b.lon - a.lon) * f,
+             a.elev_m + (b.elev_m - a.elev_m) * ff, a.agl_m + (b.agl_m - a.agl_m) * ff,
+             fmodf(a.track_deg + dtrk * ff + 360.0f, 360.0f),
+             a.gs_mps + (b.gs_mps - a.gs_mps) * ff, a.vs_mps + (b.vs_mps - a.vs_mps) * ff };
+}
+
+// Looks along the track from the pilot's seat
+static void SetCamera(double x, double y, double z, float heading_deg, float pitch_deg)
+{
+    float h = heading_deg * (float)(M_PI / 180.0), p = pitch_deg * (float)(M_PI / 180.0);
+    float fx = sinf(h) * cosf(p), fy = sinf(p), fz = -cosf(h) * cosf(p); // forward
+    float sx = -fz, sz = fx;                                             // right = forward x up
+    float sl = sqrtf(sx * sx + sz * sz);
+    sx /= sl; sz /= sl;
+    float ux = -sz * fy, uy = sz * fx - sx * fz, uz = sx * fy;           // up = right x forward
+    float ex = (float)x, ey = (float)y, ez = (float)z;
+    float m[16] = { sx, ux, -fx, 0,  0, uy, -fy, 0,  sz, uz, -fz, 0,
+                    -(sx * ex + sz * ez), -(ux * ex + uy * ey + uz * ez), fx * ex + fy * ey + fz * ez, 1 };
+    memcpy(g_modelview, m, sizeof(m));
+
+    float aspect = (float)g_screen_w / g_screen_h, n = 0.5f, f = 100000.0f;
+    float c = 1.0f / tanf(g_fov_deg * (float)(M_PI / 360.0));
+    float proj[16] = { c / aspect, 0, 0, 0,  0, c, 0, 0,  0, 0, (f + n) / (n - f), -1,  0, 0, 2 * f * n / (n - f), 0 };
+    memcpy(g_projection, proj, sizeof(proj));
+}
+
+static void SetAircraft(const OwnSample& o, float fps)
+{
+    double x, y, z;
+    XPLMWorldToLocal(o.lat, o.lon, o.elev_m, &x, &y, &z);
+    float trk = o.track_deg * (float)(M_PI / 180.0);
+    float pitch = (float)(atan2(o.vs_mps, std::max(o.gs_mps, 1.0f)) * 180.0 / M_PI);
+    Set("sim/flightmodel/position/latitude", o.lat);
+    Set("sim/flightmodel/position/longitude", o.lon);
+    Set("sim/flightmodel/position/elevation", o.elev_m);
+    Set("sim/flightmodel/position/y_agl", o.agl_m);
+    Set("sim/flightmodel/position/local_x", x);
+    Set("sim/flightmodel/position/local_y", y);
+    Set("sim/flightmodel/position/local_z", z);
+    Set("sim/flightmodel/position/local_vx", o.gs_mps * sinf(trk));
+    Set("sim/flightmodel/position/local_vy", o.vs_mps);
+    Set("sim/flightmodel/position/local_vz", -o.gs_mps * cosf(trk));
+    Set("sim/flightmodel/position/psi", o.track_deg);
+    Set("sim/flightmodel/position/hpath", o.track_deg);
+    Set("sim/flightmodel/position/theta", pitch);
+    Set("sim/flightmodel/position/groundspeed", o.gs_mps);
+    Set("sim/flightmodel/position/true_airspeed", o.gs_mps);
+    Set("sim/flightmodel/position/indicated_airspeed", o.gs_mps * 1.94384);
+    Set("sim/flightmodel/position/vh_ind", o.vs_mps);
+    Set("sim/flightmodel/position/vh_ind_fpm", o.vs_mps * 196.85);
+    Set("sim/flightmodel/misc/machno", o.gs_mps / 340.0);
+    Set("sim/operation/misc/frame_rate_period", 1.0 / fps);
+    SetCamera(x, y + 1.5, z, o.track_deg, pitch);
+}
+
+// ──────────────────────────────────
+// Frame loop
+// ──────────────────────────────────
+static void RunFlightLoops()
+{
+    for (size_t i = 0; i < g_loops.size(); ++i) {
+        FlightLoopRegistration& l = g_loops[i];
+        if (l.removed || l.interval == 0.0f) continue;
+        bool due = l.interval < 0.0f ? g_cycle >= l.next_cycle : g_sim_time >= l.next_time;
+        if (!due) continue;
+        XPLMFlightLoop_f fn = l.fn;
+        void* refcon = l.refcon;
+        float since = g_sim_time - l.last_call;
+        int counter = ++l.counter;
+        std::string name = l.name;
+        float next = Timed(name, [&] { return fn(since, since, counter, refcon); });
+        // The callback may have registered loops, which can move the vector
+        FlightLoopRegistration& after = g_loops[i];
+        after.last_call = g_sim_time;
+        after.interval = next;
+        after.next_time = g_sim_time + next;
+        after.next_cycle = g_cycle - (int)next;
+    }
+    g_loops.erase(std::remove_if(g_loops.begin(), g_loops.end(),
+        [](const FlightLoopRegistration& l) { return l.removed; }), g_loops.end());
+}
+
+static void RunDrawPhases()
+{
+    std::vector<XPLMDrawingPhase> phases;
+    for (const DrawRegistration& d : g_draw) phases.push_back(d.phase);
+    std::sort(phases.begin(), phases.end());
+    phases.erase(std::unique(phases.begin(), phases.end()), phases.end());
+
+    for (XPLMDrawingPhase phase : phases) {
+        for (int before = 1; before >= 0; --before) {
+            // Copy, callbacks may register and unregister while drawing
+            std::vector<DrawRegistration> batch;
+            for (const DrawRegistration& d : g_draw) {
+                if (d.phase == phase && d.before == before) batch.push_back(d);
+            }
+            for (const DrawRegistration& d : batch) {
+                Timed(d.name, [&] { return d.fn(phase, before, d.refcon); });
+            }
+        }
+    }
+}
+
+static bool ClickMenu(const char* name)
+{
+    for (const MenuItem& m : g_menu_items) {
+        if (m.name == name && m.menu && m.menu->handler) {
+            m.menu->handler(m.menu->ref, m.ref);
+            return true;
+        }
+    }
+    fprintf(stderr, "no menu item '%s'\n", name);
+    return false;
+}
+
+static std::string TrafficReplayPath() { return g_root + "Resources/plugins/traffic_replay.csv"; }
+
+static void ReplaySession(const Session& s, float fps)
+{
+    bool traffic = !s.traffic.empty();
+    if (traffic) {
+        FILE* f = fopen(TrafficReplayPath().c_str(), "w");
+        if (f) {
+            fputs(s.traffic.c_str(), f);
+            fclose(f);
+            ClickMenu("Replay Recorded Traffic");
+        } else {
+            fprintf(stderr, "cannot write %s, traffic is not replayed\n", TrafficReplayPath().c_str());
+            traffic = false;
+        }
+    }
+
+    size_t cursor = 0;
+    double t0 = s.own.front().t;
+    double t1 = s.own.back().t;
+    for (double t = t0; t <= t1; t += 1.0 / fps) {
+        SetAircraft(Interpolate(s.own, cursor, t), fps);
+        g_sim_time += 1.0f / fps;
+        ++g_cycle;
+        Timed("(frame)", [] {
+            RunFlightLoops();
+            RunDrawPhases();
+            return 0;
+        });
+    }
+
+    if (traffic) ClickMenu("Replay Recorded Traffic");
+}
+
+// ──────────────────────────────────
+// Report
+// ──────────────────────────────────
+static void WriteReport(const char* path)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "%s: cannot open for writing\n", path);
+        return;
+    }
+    fprintf(f, "callback,calls,total_ms\n");
+    for (const auto& kv : g_stats) fprintf(f, "%s,%lld,%.3f\n", kv.first.c_str(), kv.second.calls, kv.second.total_s * 1000.0);
+    fclose(f);
+}
+
+static void PrintTimes(const char* compare_path)
+{
+    std::map<std::string, double> baseline; // mean microseconds per call
+    if (compare_path) {
+        FILE* f = fopen(compare_path, "r");
+        if (!f) {
+            fprintf(stderr, "%s: cannot open\n", compare_path);
+        } else {
+            char name[512];
+            long long calls;
+            double total_ms;
+            char line[700];
+            while (fgets(line, sizeof(line), f)) {
+                if (sscanf(line, "%511[^,],%lld,%lf", name, &calls, &total_ms) == 3 && calls > 0) {
+                    baseline[name] = total_ms * 1000.0 / calls;
+                }
+            }
+            fclose(f);
+        }
+    }
+
+    printf("%-40s %10s %12s", "callback", "calls", "mean_us");
+    if (compare_path) printf(" %12s %8s", "base_us", "speedup");
+    printf("\n");
+    for (const auto& kv : g_stats) {
+        double mean_us = kv.second.total_s * 1e6 / std::max(1LL, kv.second.calls);
+        printf("%-40s %10lld %12.2f", kv.first.c_str(), kv.second.calls, mean_us);
+        auto it = baseline.find(kv.first);
+        if (it != baseline.end()) printf(" %12.2f %7.2fx", it->second, mean_us > 0.0 ? it->second / mean_us : 0.0);
+        printf("\n");
+    }
+}
+
+static void Usage()
+{
+    fprintf(stderr, "usage: hud_replay --plugin lin.xpl [--root DIR] [--fps 30] [--menu NAME]... "
+                    "[--report times.csv] [--compare baseline.csv] [-v] session.csv...\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* plugin_path = NULL;
+    const char* report_path = NULL;
+    const char* compare_path = NULL;
+    float fps = 30.0f;
+    std::vector<std::string> menus;
+    std::vector<const char*> sessions;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--plugin") && has_value) plugin_path = argv[++i];
+        else if (!strcmp(argv[i], "--root") && has_value) g_root = argv[++i];
+        else if (!strcmp(argv[i], "--fps") && has_value) fps = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--menu") && has_value) menus.push_back(argv[++i]);
+        else if (!strcmp(argv[i], "--report") && has_value) report_path = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && has_value) compare_path = argv[++i];
+        else if (!strcmp(argv[i], "-v")) g_verbose = true;
+        else if (argv[i][0] == '-') { Usage(); return 2; }
+        else sessions.push_back(argv[i]);
+    }
+    if (!plugin_path || sessions.empty() || fps <= 0.0f) { Usage(); return 2; }
+    if (g_root.empty() || g_root.back() != '/') g_root += '/';
+    if (menus.empty()) {
+        menus = { "HUD", "Landing Assist", "Seattle to Kelowna", "Show zones", "Toggle Aircraft Highlight", "Synthetic Vision" };
+    }
+
+    std::vector<Session> loaded(sessions.size());
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        if (!LoadSession(sessions[i], loaded[i])) {
+            fprintf(stderr, "%s: no own-ship samples\n", sessions[i]);
+            return 1;
+        }
+    }
+    g_ref_lat = loaded[0].own[0].lat;
+    g_ref_lon = loaded[0].own[0].lon;
+    g_m_per_deg_lon = 111320.0 * cos(g_ref_lat * M_PI / 180.0);
+    mkdir((g_root + "Resources").c_str(), 0755);
+    mkdir((g_root + "Resources/plugins").c_str(), 0755);
+
+    // Multiplayer slots with no aircraft in them are parked out of range
+    for (int i = 1; i < 20; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "sim/multiplayer/position/plane%d_y", i);
+        Set(name, -1.0e6);
+    }
+    SetAircraft(loaded[0].own[0], fps);
+
+    void* plugin = dlopen(plugin_path, RTLD_NOW | RTLD_LOCAL);
+    if (!plugin) {
+        fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+    typedef int (*StartFn)(char*, char*, char*);
+    typedef int (*EnableFn)();
+    typedef void (*VoidFn)();
+    StartFn start = (StartFn)dlsym(plugin, "XPluginStart");
+    EnableFn enable = (EnableFn)dlsym(plugin, "XPluginEnable");
+    VoidFn disable = (VoidFn)dlsym(plugin, "XPluginDisable");
+    VoidFn stop = (VoidFn)dlsym(plugin, "XPluginStop");
+    if (!start || !enable || !disable || !stop) {
+        fprintf(stderr, "%s: not an X-Plane plugin\n", plugin_path);
+        return 1;
+    }
+    Dl_info info;
+    if (dladdr((void*)start, &info)) g_plugin_base = info.dli_fbase;
+    LoadPluginSymbols(plugin_path);
+
+    char name[256], sig[256], desc[1024];
+    if (!start(name, sig, desc) || !enable()) {
+        fprintf(stderr, "%s: plugin refused to start\n", plugin_path);
+        return 1;
+    }
+
+    // --root may be a real X-Plane folder, keep its traffic recording
+    std::string backup = TrafficReplayPath() + ".hud_replay";
+    bool restore = rename(TrafficReplayPath().c_str(), backup.c_str()) == 0;
+
+    for (const std::string& m : menus) ClickMenu(m.c_str());
+
+    for (const Session& s : loaded) ReplaySession(s, fps);
+
+    disable();
+    stop();
+    dlclose(plugin); // writes the profile of an instrumented build
+    remove(TrafficReplayPath().c_str());
+    if (restore) rename(backup.c_str(), TrafficReplayPath().c_str());
+
+    if (report_path) WriteReport(report_path);
+    PrintTimes(compare_path);
+    return 0;
+}
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""Reads the plugin's shared memory telemetry bus.
+
+The plugin rewrites the segment once per sim frame under a seqlock. The
+structures below mirror TelemetryBlock in Main.cpp and must be kept in step
+with it (the version field is checked).
+
+The Qt UI can keep one TelemetryReader open and call snapshot() from its
+timer. Run this file directly to print the aircraft state and traffic.
+
+usage: hud_telemetry.py [--rate HZ]
+"""
+import argparse
+import ctypes
+import sys
+import time
+from multiprocessing import resource_tracker, shared_memory
+
+MAGIC = 0x4D4C4548
+VERSION = 1
+MAX_TRAFFIC = 512       # g_max_traffic
+TRAIL_POINTS = 256      # g_telemetry_trail_points
+THREATS = ("none", "proximate", "caution", "warning")
+
+# g_telemetry_name; SharedMemory adds the leading slash of the POSIX name itself
+if sys.platform == "win32":
+    SEGMENT = "Local\\hudplugin_telemetry"
+else:
+    SEGMENT = "hudplugin_telemetry"
+
+
+class Aircraft(ctypes.Structure):
+    _fields_ = [
+        ("lat", ctypes.c_double), ("lon", ctypes.c_double),
+        ("local_x", ctypes.c_double), ("local_y", ctypes.c_double), ("local_z", ctypes.c_double),
+        ("local_vx", ctypes.c_float), ("local_vy", ctypes.c_float), ("local_vz", ctypes.c_float),
+        ("elevation_m", ctypes.c_float), ("agl_m", ctypes.c_float),
+        ("ias_kt", ctypes.c_float), ("tas_kt", ctypes.c_float),
+        ("vs_fpm", ctypes.c_float), ("mach", ctypes.c_float),
+        ("pitch_deg", ctypes.c_float), ("roll_deg", ctypes.c_float),
+        ("heading_deg", ctypes.c_float), ("aoa_deg", ctypes.c_float),
+    ]
+
+
+FloatColumn = ctypes.c_float * MAX_TRAFFIC
+
+
+class Traffic(ctypes.Structure):
+    _fields_ = [
+        ("count", ctypes.c_uint32), ("epoch", ctypes.c_uint32),
+        ("time_s", ctypes.c_float), ("worst_index", ctypes.c_int32), ("worst", ctypes.c_uint32),
+        ("x", FloatColumn), ("y", FloatColumn), ("z", FloatColumn),
+        ("vx", FloatColumn), ("vy", FloatColumn), ("vz", FloatColumn),
+        ("range_m", FloatColumn), ("t_cpa_s", FloatColumn),
+        ("trail", ctypes.c_int32 * MAX_TRAFFIC),
+        ("threat", ctypes.c_uint8 * MAX_TRAFFIC),
+        ("label", (ctypes.c_char * 9) * MAX_TRAFFIC),
+    ]
+
+
+class Trail(ctypes.Structure):
+    _fields_ = [
+        ("generation", ctypes.c_uint32), ("head", ctypes.c_uint32),
+        ("pts", (ctypes.c_float * 3) * TRAIL_POINTS),
+    ]
+
+
+class Block(ctypes.Structure):
+    _fields_ = [
+        ("magic", ctypes.c_uint32), ("version", ctypes.c_uint32),
+        ("size", ctypes.c_uint32), ("seq", ctypes.c_uint32),
+        ("frame", ctypes.c_uint32), ("sim_time_s", ctypes.c_float),
+        ("aircraft", Aircraft),
+        ("traffic", Traffic),
+        ("trails", Trail * MAX_TRAFFIC),
+    ]
+
+
+class Head(ctypes.Structure):
+    """Everything in Block before the trail rings."""
+    _fields_ = Block._fields_[:-1]
+
+
+def _attach(name):
+    """Opens the plugin's segment without taking ownership of it."""
+    try:
+        return shared_memory.SharedMemory(name=name, track=False)  # Python 3.13+
+    except TypeError:
+        shm = shared_memory.SharedMemory(name=name)
+        if sys.platform != "win32":
+            # Older versions unlink every segment they attached to at exit,
+            # which would take the bus away from the plugin
+            resource_tracker.unregister("/" + name, "shared_memory")
+        return shm
+
+
+class TelemetryReader:
+    def __init__(self):
+        size = ctypes.sizeof(Block)
+        self._shm = _attach(SEGMENT)
+        self._map = self._shm.buf
+        if len(self._map) < size:
+            self.close()
+            raise RuntimeError("telemetry segment missing or from a different plugin version")
+        head = Head.from_buffer_copy(self._map)
+        if head.magic != MAGIC or head.version != VERSION or head.size != size:
+            self.close()
+            raise RuntimeError("telemetry segment missing or from a different plugin version")
+
+    def _seq(self):
+        off = Block.seq.offset
+        return int.from_bytes(self._map[off:off + 4], sys.byteorder)
+
+    def _read(self, cls, offset, retries):
+        # Seqlock read: retry while the plugin is writing or wrote meanwhile
+        for _ in range(retries):
+            before = self._seq()
+            if before & 1:
+                continue
+            value = cls.from_buffer_copy(self._map, offset)
+            if self._seq() == before:
+                return value
+        return None
+
+    def snapshot(self, retries=100):
+        """Consistent copy of the aircraft state and traffic table (the trail
+        rings are left in place), or None if the plugin was mid-write every
+        time we looked."""
+        head = self._read(Head, 0, retries)
+        return head if head is not None and head.magic == MAGIC else None
+
+    def trail(self, index, retries=100):
+        """Consistent copy of one trail ring, see TelemetryTraffic.trail."""
+        return self._read(Trail, Block.trails.offset + index * ctypes.sizeof(Trail), retries)
+
+    def close(self):
+        self._map = None
+        self._shm.close()
+
+
+def trail_points(trail, last=None):
+    """Newest-last list of (x, y, z) held in a trail ring."""
+    n = min(trail.head, TRAIL_POINTS)
+    if last is not None:
+        n = min(n, last)
+    return [tuple(trail.pts[i % TRAIL_POINTS]) for i in range(trail.head - n, trail.head)]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--rate', type=float, default=2.0, help="prints per second")
+    args = ap.parse_args()
+
+    try:
+        reader = TelemetryReader()
+    except (OSError, RuntimeError) as e:
+        sys.exit(f"cannot open telemetry: {e}")
+    try:
+        while True:
+            b = reader.snapshot()
+            if b is None:
+                print("no consistent snapshot")
+            else:
+                a, t = b.aircraft, b.traffic
+                print(f"frame {b.frame} t={b.sim_time_s:.1f}s  {a.lat:.5f} {a.lon:.5f}  "
+                      f"{a.elevation_m * 3.28084:.0f} ft  {a.ias_kt:.0f} kt  hdg {a.heading_deg:.0f}  "
+                      f"traffic {t.count} worst {THREATS[t.worst]}")
+            time.sleep(1.0 / args.rate)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        reader.close()
+
+
+if __name__ == '__main__':
+    main()
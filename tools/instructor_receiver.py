@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Loopback stand-in for the instructor station.
+
+Receives the plugin's delta-encoded UDP stream ("Stream to Instructor
+Station" in the plugin menu), rebuilds the own ship and traffic state and
+prints it with the measured bandwidth once per second.
+
+Wire format, all integers little endian:
+
+  header   u32 magic "HUDI", u8 version, u8 flags (1 = keyframe),
+           u16 snapshot, u32 datagram sequence number
+  records  until the end of the datagram, never split across datagrams
+    'A'/'a'  own ship, absolute/delta: varint field mask, then one zigzag
+             varint per set bit, in OWN_FIELDS order
+    'T'      traffic: varint key, u8 mask (see TF_*), then one zigzag varint
+             per set value bit; TF_LABEL adds u8 length + bytes. Values are
+             deltas from the last record for the key unless TF_ABSOLUTE.
+
+A gap in the sequence numbers means a delta was lost, so every entity is
+held as stale until its next absolute record (at the latest the next
+keyframe).
+
+usage: instructor_receiver.py [--port 49101]
+"""
+import argparse
+import socket
+import struct
+import sys
+import time
+
+MAGIC = 0x49445548
+VERSION = 1
+
+# name, quantization step; order matches InstructorField in Main.cpp
+OWN_FIELDS = [
+    ("lat", 1e-7), ("lon", 1e-7),
+    ("elevation_m", 0.1), ("agl_m", 0.1),
+    ("ias_kt", 0.1), ("tas_kt", 0.1),
+    ("vs_fpm", 1.0), ("mach", 0.001),
+    ("pitch_deg", 0.01), ("roll_deg", 0.01), ("heading_deg", 0.01), ("aoa_deg", 0.01),
+    ("route_active", 1), ("route_passed", 1), ("route_dist_m", 1),
+    ("threat", 1),
+]
+
+TF_LAT, TF_LON, TF_ALT, TF_THREAT, TF_TCPA, TF_LABEL, TF_ABSOLUTE, TF_REMOVED = (1 << i for i in range(8))
+TARGET_FIELDS = [(TF_LAT, "lat"), (TF_LON, "lon"), (TF_ALT, "alt"), (TF_THREAT, "threat"), (TF_TCPA, "t_cpa")]
+THREATS = ("none", "proximate", "caution", "warning")
+
+
+def to_int32(v):
+    v &= 0xFFFFFFFF
+    return v - (1 << 32) if v & 0x80000000 else v
+
+
+class Reader:
+    def __init__(self, data, pos):
+        self.data, self.pos = data, pos
+
+    def byte(self):
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        v, shift = 0, 0
+        while True:
+            b = self.byte()
+            v |= (b & 0x7F) << shift
+            if b < 0x80:
+                return v
+            shift += 7
+
+    def delta(self):
+        z = self.varint()
+        return (z >> 1) ^ -(z & 1)
+
+
+class Station:
+    def __init__(self):
+        self.own = [0] * len(OWN_FIELDS)
+        self.own_valid = False
+        self.targets = {}  # key -> dict, 'valid' False while stale
+        self.next_seq = None
+        self.gaps = 0
+
+    def apply(self, data):
+        if len(data) < 12:
+            return
+        magic, version, flags, _snapshot, seq = struct.unpack_from("<IBBHI", data, 0)
+        if magic != MAGIC or version != VERSION:
+            return
+        if self.next_seq is not None and seq != self.next_seq:
+            self.gaps += 1
+            self.own_valid = False
+            for t in self.targets.values():
+                t["valid"] = False
+        self.next_seq = (seq + 1) & 0xFFFFFFFF
+
+        r = Reader(data, 12)
+        while r.pos < len(data):
+            tag = r.byte()
+            if tag in (ord('A'), ord('a')):
+                self._own(r, tag == ord('A'))
+            elif tag == ord('T'):
+                self._target(r)
+            else:
+                return  # unknown record, rest of the datagram cannot be parsed
+
+    def _own(self, r, absolute):
+        mask = r.varint()
+        for f in range(len(OWN_FIELDS)):
+            if mask & (1 << f):
+                d = r.delta()
+                self.own[f] = to_int32(d if absolute else self.own[f] + d)
+        if absolute:
+            self.own_valid = True
+
+    def _target(self, r):
+        key = r.varint()
+        mask = r.byte()
+        if mask & TF_REMOVED:
+            self.targets.pop(key, None)
+            return
+        absolute = bool(mask & TF_ABSOLUTE)
+        t = self.targets.get(key)
+        if t is None or absolute:
+            # A delta for an unknown key is still parsed, but not trusted
+            t = self.targets[key] = {"lat": 0, "lon": 0, "alt": 0, "threat": 0, "t_cpa": 0,
+                                     "label": t["label"] if t else "", "valid": absolute}
+        for bit, name in TARGET_FIELDS:
+            if mask & bit:
+                d = r.delta()
+                t[name] = to_int32(d if absolute else t[name] + d)
+        if mask & TF_LABEL:
+            n = r.byte()
+            t["label"] = r.data[r.pos:r.pos + n].decode("ascii", "replace")
+            r.pos += n
+
+    def own_values(self):
+        return {name: q * step for (name, step), q in zip(OWN_FIELDS, self.own)}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('--host', default="127.0.0.1")
+    ap.add_argument('--port', type=int, default=49101)
+    args = ap.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.host, args.port))
+    sock.settimeout(0.2)
+    station = Station()
+    packets = nbytes = 0
+    last_print = time.monotonic()
+    try:
+        while True:
+            try:
+                data = sock.recv(65536)
+                packets += 1
+                nbytes += len(data)
+                station.apply(data)
+            except socket.timeout:
+                pass
+            now = time.monotonic()
+            if now - last_print >= 1.0:
+                o = station.own_values()
+                valid = sum(1 for t in station.targets.values() if t["valid"])
+                print(f"{packets:4d} pkt/s {nbytes / 1024.0 / (now - last_print):7.2f} kB/s  "
+                      f"{'ok   ' if station.own_valid else 'stale'} "
+                      f"{o['lat']:.5f} {o['lon']:.5f} {o['elevation_m'] * 3.28084:6.0f} ft "
+                      f"{o['ias_kt']:5.1f} kt hdg {o['heading_deg']:5.1f}  "
+                      f"wpt {int(o['route_active'])} ({int(o['route_dist_m'])} m)  "
+                      f"traffic {valid}/{len(station.targets)} worst {THREATS[int(o['threat']) & 3]}  "
+                      f"gaps {station.gaps}")
+                packets = nbytes = 0
+                last_print = now
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()